@@ -0,0 +1,544 @@
+// rogue_bench: microbenchmarks of the hot paths and end-to-end scans of
+// synthetic workspaces, reported as JSON and optionally compared against a
+// stored baseline (see docs/USAGE.md, "Mesures de performance").
+#include "workspace_gen.hpp"
+
+#include "core/json_index.hpp"
+#include "core/logger.hpp"
+#include "core/path_matcher.hpp"
+#include "core/scanner.hpp"
+#include "core/sha256.hpp"
+#include "core/utils.hpp"
+#include <json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+struct Options
+{
+    std::vector<std::string> only;  // substrings of benchmark names
+    std::vector<std::size_t> scanSizes{10000, 100000, 1000000};
+    std::string workdir{"rogue_bench_data"};
+    std::string output;
+    std::string baseline;
+    double threshold{-1};  // percent, for entries without their own; < 0 = baseline's or 15
+    int repeats{5};
+    double minTime{0.2};  // seconds per sample of a microbenchmark
+    int threads{0};
+    IoEngine ioEngine{IoEngine::Auto};
+    std::uint64_t seed{1};
+};
+
+struct Result
+{
+    std::string name;
+    std::string unit;
+    bool higherIsBetter{false};
+    std::vector<double> samples;
+
+    double median() const
+    {
+        std::vector<double> s = samples;
+        std::sort(s.begin(), s.end());
+        return s.empty() ? 0 : s.size() % 2 ? s[s.size() / 2] : (s[s.size() / 2 - 1] + s[s.size() / 2]) / 2;
+    }
+};
+
+// Swallows the console output of the Logger while a benchmark runs.
+class NullBuffer : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+#ifdef _WIN32
+const char* const kNullFile = "NUL";
+#else
+const char* const kNullFile = "/dev/null";
+#endif
+
+volatile std::size_t g_sink;  // keeps benchmarked results alive
+
+double seconds_since(Clock::time_point t0)
+{
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Seconds per call of op, run in doubling batches until one lasts minTime.
+template <typename Op>
+double time_per_op(Op&& op, double minTime)
+{
+    for (std::size_t n = 1;; n *= 2)
+    {
+        const auto t0 = Clock::now();
+        for (std::size_t i = 0; i < n; ++i)
+            op();
+        const double s = seconds_since(t0);
+        if (s >= minTime || n >= (std::size_t(1) << 40))
+            return s / double(n);
+    }
+}
+
+class Suite
+{
+public:
+    explicit Suite(const Options& opt) : opt_(opt) {}
+
+    bool wants(const std::string& name) const
+    {
+        if (opt_.only.empty())
+            return true;
+        for (const auto& o : opt_.only)
+            if (name.find(o) != std::string::npos)
+                return true;
+        return false;
+    }
+
+    // sample() returns one measurement in `unit`.
+    template <typename Sample>
+    void add(const std::string& name, const std::string& unit, bool higherIsBetter, int repeats, Sample&& sample)
+    {
+        if (!wants(name))
+            return;
+        Result r{name, unit, higherIsBetter, {}};
+        for (int i = 0; i < repeats; ++i)
+            r.samples.push_back(sample());
+        std::fprintf(stderr, "%-32s %14.1f %s\n", name.c_str(), r.median(), unit.c_str());
+        results_.push_back(std::move(r));
+    }
+
+    const std::vector<Result>& results() const { return results_; }
+
+private:
+    const Options& opt_;
+    std::vector<Result> results_;
+};
+
+void bench_glob(Suite& suite, const Options& opt)
+{
+    // The default .rogueignore plus the usual build outputs.
+    const std::vector<std::string> patterns = {"*.key",   "*.pem",     "*.pfx", "*.kdbx", ".env",  "id_*",
+                                               "*token*", "*.iso",     "*.zip", "*.tar.gz", "*.7z", "*.mp4",
+                                               "*.mov",   "build/",    "node_modules", "out/*", "*.log", "*.o"};
+    bench::WorkspaceSpec spec;
+    spec.files = 4096;
+    spec.seed = opt.seed;
+    const auto paths = bench::workspace_paths(spec);
+    const PathMatcher matcher(patterns);
+
+    suite.add("glob/is_ignored", "ns/path", false, opt.repeats, [&] {
+        std::size_t i = 0, hits = 0;
+        const double s = time_per_op([&] { hits += utils::is_ignored(paths[i++ & 4095], patterns); }, opt.minTime);
+        g_sink = hits;
+        return s * 1e9;
+    });
+    suite.add("glob/path_matcher", "ns/path", false, opt.repeats, [&] {
+        std::size_t i = 0, hits = 0;
+        const double s = time_per_op([&] { hits += matcher.matches(paths[i++ & 4095]); }, opt.minTime);
+        g_sink = hits;
+        return s * 1e9;
+    });
+}
+
+void bench_sha256(Suite& suite, const Options& opt)
+{
+    if (!suite.wants("sha256_file"))
+        return;
+    const fs::path dir = fs::path(opt.workdir) / "sha256";
+    fs::create_directories(dir);
+    std::string block(1 << 20, '\0');
+    for (std::size_t i = 0; i < block.size(); ++i)
+        block[i] = char(i * 2654435761u >> 13);
+    const std::string big = (dir / "16MiB.bin").string();
+    {
+        std::ofstream out(big, std::ios::binary);
+        for (int i = 0; i < 16; ++i)
+            out << block;
+    }
+    std::vector<std::string> small;
+    for (int i = 0; i < 256; ++i)
+    {
+        small.push_back((dir / ("small" + std::to_string(i) + ".bin")).string());
+        std::ofstream(small.back(), std::ios::binary).write(block.data() + i, 4096);
+    }
+
+    // Both from the page cache: this is the hashing and read path, not the disk.
+    suite.add("sha256_file/16MiB", "MB/s", true, opt.repeats, [&] {
+        const double s = time_per_op([&] { g_sink = utils::sha256_file(big).size(); }, opt.minTime);
+        return 16.0 * 1048576 / s / 1e6;
+    });
+    suite.add("sha256_file/4KiB", "files/s", true, opt.repeats, [&] {
+        std::size_t i = 0;
+        const double s = time_per_op([&] { g_sink = utils::sha256_file(small[i++ & 255]).size(); }, opt.minTime);
+        return 1.0 / s;
+    });
+}
+
+void bench_logger(Suite& suite, const Options& opt)
+{
+    LoggerOptions lo;
+    lo.path = kNullFile;
+    Logger logger(lo);
+    logger.set_min_level(LogLevel::Info);
+    const std::string path = "src/core/scanner.cpp";
+
+    // Sustained rate: includes waiting on the writer thread when the ring is full.
+    suite.add("logger/info_2_fields", "ns/line", false, opt.repeats, [&] {
+        std::uintmax_t n = 0;
+        return 1e9 * time_per_op([&] { logger.info("bench", "file hashed", LogField("path", path), LogField("size", ++n)); },
+                                 opt.minTime);
+    });
+    // Below the runtime level (debug calls are compiled out of release builds).
+    logger.set_min_level(LogLevel::Error);
+    suite.add("logger/info_filtered", "ns/line", false, opt.repeats, [&] {
+        std::uintmax_t n = 0;
+        return 1e9 * time_per_op([&] { logger.info("bench", "file hashed", LogField("path", path), LogField("size", ++n)); },
+                                 opt.minTime);
+    });
+}
+
+json inventory_document(std::size_t files)
+{
+    json doc;
+    json arr = json::array();
+    for (std::size_t i = 0; i < files; ++i)
+    {
+        json e;
+        e["hash"] = std::string(64, "0123456789abcdef"[i % 16]);
+        e["mtime"] = "2025-01-01T00:00:00";
+        e["path"] = "src/module" + std::to_string(i % 97) + "/file" + std::to_string(i) + ".cpp";
+        e["size"] = std::uint64_t(i * 37);
+        arr.push_back(std::move(e));
+    }
+    doc["files"] = std::move(arr);
+    doc["generated_at"] = "2025-01-01T00:00:00";
+    doc["root"] = "/workspace";
+    doc["total_size"] = std::uint64_t(files * 37);
+    return doc;
+}
+
+void bench_json(Suite& suite, const Options& opt)
+{
+    if (!suite.wants("json/"))
+        return;
+    const json doc = inventory_document(10000);
+    const std::string text = doc.dump(2);
+    const double mb = double(text.size()) / 1e6;
+
+    suite.add("json/build_10k", "ms", false, opt.repeats, [&] {
+        return 1e3 * time_per_op([&] { g_sink = inventory_document(10000).size(); }, opt.minTime);
+    });
+    suite.add("json/dump_10k", "MB/s", true, opt.repeats, [&] {
+        std::string out;
+        return mb / time_per_op([&] {
+            out.clear();
+            doc.dump_to(out, 2);
+            g_sink = out.size();
+        }, opt.minTime);
+    });
+    suite.add("json/parse_10k", "MB/s", true, opt.repeats, [&] {
+        return mb / time_per_op([&] { g_sink = json::parse(text).size(); }, opt.minTime);
+    });
+}
+
+void bench_scan(Suite& suite, const Options& opt)
+{
+    for (std::size_t n : opt.scanSizes)
+    {
+        const std::string prefix = "scan/" + std::to_string(n);
+        if (!suite.wants(prefix + "/nocache") && !suite.wants(prefix + "/cached"))
+            continue;
+        // Bigger trees get smaller files, so the generated data stays in the
+        // hundreds of MB: about 60 MB at 10k, 170 MB at 100k, 490 MB at 1M.
+        bench::WorkspaceSpec spec;
+        spec.files = n;
+        spec.seed = opt.seed;
+        spec.maxSize = n <= 10000 ? 64 * 1024 : n <= 100000 ? 16 * 1024 : 4 * 1024;
+        const fs::path root = fs::path(opt.workdir) / ("ws_" + std::to_string(n));
+        const auto t0 = Clock::now();
+        const auto stats = bench::generate_workspace(root, spec);
+        std::fprintf(stderr, "workspace %s: %zu files (%zu ignored, %zu sensitive), %.1f MB, %s in %.1f s\n",
+                     root.string().c_str(), stats.files, stats.ignored, stats.sensitive, double(stats.bytes) / 1e6,
+                     stats.reused ? "reused" : "generated", seconds_since(t0));
+
+        LoggerOptions lo;
+        lo.path = kNullFile;
+        Logger logger(lo);
+        const int repeats = n >= 1000000 ? 1 : n >= 100000 ? std::min(opt.repeats, 3) : opt.repeats;
+        ScanOptions so;
+        so.root = root.string();
+        so.threads = opt.threads;
+        so.ioEngine = opt.ioEngine;
+        auto scan = [&] {
+            const auto s0 = Clock::now();
+            const auto r = scan_workspace(so, logger);
+            const double s = seconds_since(s0);
+            g_sink = r.files.size();
+            return double(n) / s;
+        };
+        so.useCache = false;
+        suite.add(prefix + "/nocache", "files/s", true, repeats, scan);
+        so.useCache = true;
+        so.cachePath = (fs::path(opt.workdir) / ("cache_" + std::to_string(n))).string();
+        if (suite.wants(prefix + "/cached"))
+            scan();  // fill the cache
+        suite.add(prefix + "/cached", "files/s", true, repeats, scan);
+    }
+}
+
+// Four significant digits are plenty for noisy timings and keep the
+// baseline file readable.
+double rounded(double v)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.4g", v);
+    return std::strtod(buf, nullptr);
+}
+
+json report_json(const Suite& suite, const Options& opt)
+{
+    json report;
+    report["schema"] = 1;
+    report["generated_at"] = utils::iso_timestamp();
+    json host;
+#ifdef NDEBUG
+    host["build"] = "release";
+#else
+    host["build"] = "debug";
+#endif
+#if defined(__VERSION__)
+    host["compiler"] = __VERSION__;
+#endif
+    host["json_index_kernel"] = JsonIndexer::active_kernel_name();
+    host["sha256_kernel"] = Sha256::active_kernel_name();
+    host["threads"] = std::thread::hardware_concurrency();
+    IoEngine engine = opt.ioEngine;  // io_uring falls back to threads when the kernel refuses it
+    if (engine == IoEngine::Auto || engine == IoEngine::IoUring)
+        engine = BatchReader::available(IoEngine::IoUring) ? IoEngine::IoUring : IoEngine::Threads;
+    host["io_engine"] = io_engine_name(engine);
+    report["host"] = std::move(host);
+    json results = json::array();
+    for (const auto& r : suite.results())
+    {
+        json e;
+        e["name"] = r.name;
+        e["unit"] = r.unit;
+        e["higher_is_better"] = r.higherIsBetter;
+        e["value"] = rounded(r.median());
+        json samples = json::array();
+        for (double s : r.samples)
+        {
+            json v;
+            v = rounded(s);
+            samples.push_back(std::move(v));
+        }
+        e["samples"] = std::move(samples);
+        results.push_back(std::move(e));
+    }
+    report["results"] = std::move(results);
+    return report;
+}
+
+// Adds a "comparison" to the report; returns the number of regressions, or
+// -1 if the baseline cannot be read.
+int compare_with_baseline(json& report, const Suite& suite, const Options& opt)
+{
+    std::ifstream in(opt.baseline, std::ios::binary);
+    std::ostringstream text;
+    text << in.rdbuf();
+    bool ok = false;
+    const json base = json::parse(text.str(), &ok);
+    const json* baseResults = ok ? base.find("results") : nullptr;
+    if (!in || !baseResults || !baseResults->is_array())
+    {
+        std::fprintf(stderr, "cannot read baseline %s\n", opt.baseline.c_str());
+        return -1;
+    }
+    const double defaultThreshold = opt.threshold >= 0 ? opt.threshold : base.value("threshold_pct", 15.0);
+
+    int regressions = 0;
+    json rows = json::array();
+    std::fprintf(stderr, "\n%-32s %14s %14s %8s %6s\n", "benchmark", "baseline", "current", "change", "limit");
+    for (const auto& r : suite.results())
+    {
+        const json* b = nullptr;
+        for (std::size_t i = 0; i < baseResults->size() && !b; ++i)
+            if (baseResults->at(i).value("name", std::string()) == r.name)
+                b = &baseResults->at(i);
+        json row;
+        row["name"] = r.name;
+        row["value"] = r.median();
+        if (!b)
+        {
+            row["status"] = "new";
+            rows.push_back(std::move(row));
+            continue;
+        }
+        const double was = b->value("value", 0.0);
+        const double now = r.median();
+        // Positive = worse, whichever direction the metric goes.
+        const double worse = was > 0 ? (r.higherIsBetter ? was - now : now - was) / was * 100 : 0;
+        const double limit = b->value("threshold_pct", defaultThreshold);
+        const char* status = worse > limit ? "regression" : worse < -limit ? "improved" : "ok";
+        regressions += worse > limit;
+        row["baseline"] = was;
+        row["change_pct"] = -worse;
+        row["threshold_pct"] = limit;
+        row["status"] = status;
+        rows.push_back(std::move(row));
+        std::fprintf(stderr, "%-32s %14.1f %14.1f %+7.1f%% %5.0f%%  %s\n", r.name.c_str(), was, now, -worse, limit,
+                     status);
+    }
+    json cmp;
+    cmp["baseline"] = opt.baseline;
+    cmp["regressions"] = regressions;
+    cmp["results"] = std::move(rows);
+    report["comparison"] = std::move(cmp);
+    return regressions;
+}
+
+void print_help()
+{
+    std::cerr << "rogue_bench [--only <name>...] [--scan-sizes <n,n,...>] [--quick] [--repeats <n>] [--min-time <s>]\n"
+              << "            [--threads <n>] [--io-engine auto|io_uring|threads|off] [--seed <n>] [--workdir <dir>] [--output <file>]\n"
+              << "            [--baseline <file> [--threshold <percent>]]\n"
+              << "Exit codes: 0 ok, 1 bad arguments, 2 unreadable baseline or output, 3 regression beyond threshold\n";
+}
+
+bool parse_options(int argc, char** argv, Options& o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string k = argv[i];
+        auto next = [&](std::string& out) {
+            if (i + 1 >= argc)
+                return false;
+            out = argv[++i];
+            return true;
+        };
+        std::string v;
+        try
+        {
+            if (k == "--only" && next(v))
+                o.only.push_back(v);
+            else if (k == "--scan-sizes" && next(v))
+            {
+                o.scanSizes.clear();
+                std::istringstream in(v);
+                std::string item;
+                while (std::getline(in, item, ','))
+                    if (!item.empty())
+                        o.scanSizes.push_back(std::stoull(item));
+            }
+            else if (k == "--quick")
+            {
+                o.scanSizes = {10000};
+                o.repeats = 3;
+                o.minTime = 0.05;
+            }
+            else if (k == "--repeats" && next(v))
+                o.repeats = std::max(1, std::stoi(v));
+            else if (k == "--min-time" && next(v))
+                o.minTime = std::stod(v);
+            else if (k == "--threads" && next(v))
+                o.threads = std::stoi(v);
+            else if (k == "--io-engine" && next(v))
+            {
+                if (!parse_io_engine(v, o.ioEngine))
+                    return false;
+            }
+            else if (k == "--seed" && next(v))
+                o.seed = std::stoull(v);
+            else if (k == "--workdir" && next(v))
+                o.workdir = v;
+            else if (k == "--output" && next(v))
+                o.output = v;
+            else if (k == "--baseline" && next(v))
+                o.baseline = v;
+            else if (k == "--threshold" && next(v))
+                o.threshold = std::stod(v);
+            else
+                return false;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_options(argc, argv, opt))
+    {
+        print_help();
+        return 1;
+    }
+#ifndef NDEBUG
+    std::fprintf(stderr, "warning: not a release build (configure with -DCMAKE_BUILD_TYPE=Release)\n");
+#endif
+    fs::create_directories(opt.workdir);
+
+    // The Logger echoes every line to stdout; keep that out of the numbers
+    // and of the report.
+    NullBuffer null;
+    std::streambuf* console = std::cout.rdbuf(&null);
+
+    Suite suite(opt);
+    bench_glob(suite, opt);
+    bench_sha256(suite, opt);
+    bench_logger(suite, opt);
+    bench_json(suite, opt);
+    bench_scan(suite, opt);
+
+    std::cout.rdbuf(console);
+    json report = report_json(suite, opt);
+    int regressions = 0;
+    if (!opt.baseline.empty())
+    {
+        regressions = compare_with_baseline(report, suite, opt);
+        if (regressions < 0)
+            return 2;
+    }
+    const std::string text = report.dump(2);
+    if (opt.output.empty())
+        std::cout << text << std::endl;
+    else
+    {
+        std::ofstream out(opt.output, std::ios::binary | std::ios::trunc);
+        out << text << "\n";
+        if (!out)
+        {
+            std::fprintf(stderr, "cannot write %s\n", opt.output.c_str());
+            return 2;
+        }
+    }
+    if (regressions > 0)
+    {
+        std::fprintf(stderr, "%d benchmark(s) regressed beyond the threshold\n", regressions);
+        return 3;
+    }
+    return 0;
+}
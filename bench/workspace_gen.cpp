@@ -0,0 +1,169 @@
+#include "workspace_gen.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace rogue
+{
+namespace bench
+{
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+std::uint64_t splitmix64(std::uint64_t& state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1).
+double unit(std::uint64_t& state)
+{
+    return double(splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+enum class Kind
+{
+    Regular,
+    Ignored,
+    Sensitive
+};
+
+struct FilePlan
+{
+    std::string path;
+    std::uint64_t size;
+    Kind kind;
+};
+
+const char* const kExtensions[] = {"cpp", "hpp", "md", "json", "txt", "py", "png", "csv"};
+const char* const kSensitiveNames[] = {".env", "server.key", "api_token.txt", "cert.pem"};
+
+unsigned fanout_for(const WorkspaceSpec& spec)
+{
+    const double leaves = std::max(1.0, double(spec.files) / double(std::max<std::size_t>(1, spec.filesPerDir)));
+    if (spec.depth == 0)
+        return 1;
+    return std::max(1u, unsigned(std::ceil(std::pow(leaves, 1.0 / spec.depth))));
+}
+
+template <typename F>
+void for_each_file(const WorkspaceSpec& spec, F&& f)
+{
+    const unsigned fanout = fanout_for(spec);
+    std::uint64_t state = spec.seed;
+    const double logMin = std::log(double(spec.minSize) + 1.0);
+    const double logMax = std::log(double(std::max(spec.maxSize, spec.minSize)) + 1.0);
+    FilePlan plan;
+    for (std::size_t i = 0; i < spec.files; ++i)
+    {
+        const double roll = unit(state);
+        plan.kind = roll < spec.ignoredRatio ? Kind::Ignored
+                    : roll < spec.ignoredRatio + spec.sensitiveRatio ? Kind::Sensitive
+                                                                      : Kind::Regular;
+        plan.size = std::uint64_t(std::exp(logMin + (logMax - logMin) * unit(state)) - 1.0);
+        plan.path.clear();
+        // Half the ignored files sit under build/, which the scan prunes
+        // without descending; the others are *.log next to regular files.
+        const bool underBuild = plan.kind == Kind::Ignored && (splitmix64(state) & 1);
+        if (underBuild)
+            plan.path = "build/";
+        for (unsigned level = 0; level < spec.depth; ++level)
+        {
+            plan.path += 'd';
+            plan.path += std::to_string(splitmix64(state) % fanout);
+            plan.path += '/';
+        }
+        const std::uint64_t pick = splitmix64(state);
+        if (plan.kind == Kind::Sensitive)
+        {
+            plan.path += std::to_string(i) + "_";
+            plan.path += kSensitiveNames[pick % 4];
+        }
+        else
+        {
+            plan.path += "f" + std::to_string(i) + ".";
+            plan.path += plan.kind == Kind::Ignored && !underBuild ? "log" : kExtensions[pick % 8];
+        }
+        f(plan, i);
+    }
+}
+
+}  // namespace
+
+std::string WorkspaceSpec::describe() const
+{
+    std::ostringstream s;
+    s << "files=" << files << " depth=" << depth << " per_dir=" << filesPerDir << " size=" << minSize << ".."
+      << maxSize << " ignored=" << ignoredRatio << " sensitive=" << sensitiveRatio << " seed=" << seed;
+    return s.str();
+}
+
+std::vector<std::string> workspace_paths(const WorkspaceSpec& spec)
+{
+    std::vector<std::string> out;
+    out.reserve(spec.files);
+    for_each_file(spec, [&](const FilePlan& p, std::size_t) { out.push_back(p.path); });
+    return out;
+}
+
+WorkspaceStats generate_workspace(const fs::path& root, const WorkspaceSpec& spec)
+{
+    WorkspaceStats stats;
+    const fs::path marker = root / ".rogue" / "bench-spec";
+    const std::string desc = spec.describe();
+    bool reuse = false;
+    {
+        std::ifstream in(marker);
+        std::string line;
+        reuse = in && std::getline(in, line) && line == desc;
+    }
+    if (!reuse)
+    {
+        fs::remove_all(root);
+        fs::create_directories(root / ".rogue");
+        std::ofstream(root / ".rogueignore") << "build/\n*.log\n";
+    }
+
+    std::vector<char> buf;
+    fs::path lastDir;
+    for_each_file(spec, [&](const FilePlan& p, std::size_t i) {
+        ++stats.files;
+        stats.bytes += p.size;
+        stats.ignored += p.kind == Kind::Ignored;
+        stats.sensitive += p.kind == Kind::Sensitive;
+        if (reuse)
+            return;
+        const fs::path file = root / p.path;
+        if (file.parent_path() != lastDir)
+        {
+            lastDir = file.parent_path();
+            fs::create_directories(lastDir);
+        }
+        // Contents depend on the seed and the file index only.
+        std::uint64_t state = spec.seed ^ (std::uint64_t(i) * 0xD1B54A32D192ED03ULL);
+        buf.resize(std::size_t((p.size + 7) & ~std::uint64_t(7)));
+        for (std::size_t k = 0; k < buf.size(); k += 8)
+        {
+            const std::uint64_t v = splitmix64(state);
+            std::memcpy(buf.data() + k, &v, 8);
+        }
+        std::ofstream(file, std::ios::binary).write(buf.data(), std::streamsize(p.size));
+    });
+
+    if (!reuse)
+        std::ofstream(marker) << desc << "\n";
+    stats.reused = reuse;
+    return stats;
+}
+
+}  // namespace bench
+}  // namespace rogue
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace rogue
+{
+namespace bench
+{
+
+// Shape of a synthetic workspace. The same spec always produces the same
+// tree, byte for byte, on any platform (own PRNG, no <random> distributions).
+struct WorkspaceSpec
+{
+    std::size_t files{10000};
+    unsigned depth{3};           // directory levels under the root
+    std::size_t filesPerDir{64};  // average; sets the number of leaf directories
+    // Sizes are log-uniform in [minSize, maxSize]: many small files, a few
+    // large ones, as in a source tree.
+    std::uint64_t minSize{0};
+    std::uint64_t maxSize{64 * 1024};
+    // Share of files the scan must skip: under build/ (pruned by
+    // .rogueignore) or named *.log (matched by pattern).
+    double ignoredRatio{0.1};
+    // Share of files with sensitive names (.env, *.key, *token*), walked but
+    // skipped by the scanner's name check.
+    double sensitiveRatio{0.01};
+    std::uint64_t seed{1};
+
+    // Stable one-line description, used to reuse an existing tree.
+    std::string describe() const;
+};
+
+struct WorkspaceStats
+{
+    std::size_t files{0};
+    std::size_t ignored{0};
+    std::size_t sensitive{0};
+    std::uint64_t bytes{0};
+    bool reused{false};
+};
+
+// Relative paths of the files a spec produces (no disk access), in
+// generation order.
+std::vector<std::string> workspace_paths(const WorkspaceSpec& spec);
+
+// Creates the tree under root, with its .rogueignore. If root already holds
+// a tree generated from the same spec, it is kept as is.
+WorkspaceStats generate_workspace(const std::filesystem::path& root, const WorkspaceSpec& spec);
+
+}  // namespace bench
+}  // namespace rogue
@@ -6,4 +6,7 @@ namespace rogue
     int command_scan(const CliOptions &opt);
     int command_init(const CliOptions &opt);
     int command_push(const CliOptions &opt);
+    int command_watch(const CliOptions &opt);
+    int command_dupes(const CliOptions &opt);
+    int command_inventory(const CliOptions &opt);
 }
@@ -1,2 +1,2 @@
 #pragma once
-#include <nlohmann/json.hpp>
+#include <json.hpp>
@@ -2,7 +2,7 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <nlohmann/json.hpp>
+#include <json.hpp>
 
 namespace rogue
 {
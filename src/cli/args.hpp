@@ -9,10 +9,17 @@ namespace rogue
     struct CliOptions
     {
         std::string command;
+        std::vector<std::string> args;  // positional, after the command (subcommands)
         std::string root;
         std::vector<std::string> includes;
         std::vector<std::string> excludes;
         std::optional<int> maxSizeMb;
+        std::optional<unsigned long long> minSize;
+        std::optional<unsigned long long> maxSize;
+        std::vector<std::string> paths;         // inventory query --path
+        std::optional<std::string> hashPrefix;  // inventory query --hash
+        std::optional<std::string> groupBy;
+        bool count{false};
         bool dryRun{false};
         std::string repoName;
         std::optional<std::string> org;
@@ -22,6 +29,28 @@ namespace rogue
         std::optional<std::string> commitMessage;
         std::optional<std::string> configFile;
         bool includeSecrets{false};
+        bool detectSecrets{false};
+        bool inodeOrder{false};
+        bool dedup{false};
+        bool nativePack{false};
+        bool fastStage{false};
+        std::optional<int> threads;
+        std::optional<int> chunkMb;
+        std::optional<int> pushEvery;
+        std::optional<int> maxPushMb;
+        bool changedOnly{false};
+        bool diff{false};
+        bool pipeline{false};
+        std::optional<int> pipelineWindow;
+        std::optional<int> settleMs;
+        bool noCache{false};
+        std::optional<std::string> format;
+        std::optional<std::string> output;
+        std::optional<std::string> input;
+        std::optional<std::string> logLevel;
+        std::optional<std::string> ioEngine;  // auto|io_uring|threads|off
+        bool stats{false};                 // phase/counter summary on stderr
+        std::optional<std::string> trace;  // Chrome trace-event file
     };
 
     CliOptions parse_args(int argc, char **argv);
@@ -0,0 +1,58 @@
+#include "args.hpp"
+#include "../core/dupes.hpp"
+#include "../core/logger.hpp"
+#include "../core/scanner.hpp"
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace rogue
+{
+
+    int command_dupes(const CliOptions &opt)
+    {
+        Logger logger;
+        if (opt.root.empty())
+        {
+            logger.error("dupes", "--root is required");
+            return 1;
+        }
+        std::ofstream file;
+        std::ostream *out = &std::cout;
+        if (opt.output)
+        {
+            file.open(*opt.output, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                logger.error("dupes", "Cannot open output file", {{"path", *opt.output}});
+                return 2;
+            }
+            out = &file;
+        }
+
+        // Walk only: contents are read by find_duplicates, and only as far
+        // as needed to tell files of the same size apart.
+        ScanOptions sopt;
+        sopt.root = opt.root;
+        sopt.includes = opt.includes;
+        sopt.excludes = opt.excludes;
+        sopt.maxSizeMb = opt.maxSizeMb.value_or(std::numeric_limits<int>::max());
+        sopt.includeSecrets = opt.includeSecrets;
+        sopt.threads = opt.threads.value_or(0);
+        sopt.useCache = !opt.noCache;
+        sopt.inodeOrder = opt.inodeOrder;
+        if (opt.ioEngine)
+            parse_io_engine(*opt.ioEngine, sopt.ioEngine);
+        sopt.hashContents = false;
+        auto inv = scan_workspace(sopt, logger);
+        if (!inv.ok)
+        {
+            logger.error("dupes", inv.errorMessage);
+            return 2;
+        }
+        const DupeReport report = find_duplicates(opt.root, inv.files, logger, opt.minSize.value_or(1), sopt.threads);
+        *out << dupe_report_json(report, inv.files) << std::endl;
+        return 0;
+    }
+
+}
@@ -0,0 +1,171 @@
+#include "args.hpp"
+#include "../core/inventory_query.hpp"
+#include "../core/inventory_reader.hpp"
+#include "../core/logger.hpp"
+#include "../core/mapped_file.hpp"
+#include "../core/rinv.hpp"
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+namespace rogue
+{
+
+    namespace
+    {
+        // JSON -> .rinv or .rinv -> JSON, whichever the input is.
+        int convert(const CliOptions &opt, Logger &logger)
+        {
+            if (!opt.input || !opt.output)
+            {
+                logger.error("inventory", "convert needs --input and --output");
+                return 1;
+            }
+            std::string error;
+            if (is_rinv_file(*opt.input))
+            {
+                RinvView view;
+                if (!view.open(*opt.input, &error))
+                {
+                    logger.error("inventory", error);
+                    return 2;
+                }
+                std::ofstream out(*opt.output, std::ios::binary | std::ios::trunc);
+                write_rinv_as_json(view, out);
+                out << std::endl;
+                if (!out)
+                {
+                    logger.error("inventory", "Cannot write output file", LogField("path", *opt.output));
+                    return 2;
+                }
+                logger.info("inventory", "converted to json", LogField("files", view.size()));
+                return 0;
+            }
+
+            MappedFile in;
+            if (!in.open(*opt.input, &error, true))
+            {
+                logger.error("inventory", "Cannot open input file", LogField("path", *opt.input));
+                return 2;
+            }
+            InventoryDoc doc;
+            if (!parse_inventory_json(in.view(), doc, &error))
+            {
+                logger.error("inventory", "Invalid inventory JSON", LogField("path", *opt.input), LogField("error", error));
+                return 2;
+            }
+            if (!write_rinv(*opt.output, doc.root, doc.generatedAt, doc.files, doc.totalSize, &error))
+            {
+                logger.error("inventory", error);
+                return 2;
+            }
+            logger.info("inventory", "converted to rinv", LogField("files", doc.files.size()));
+            return 0;
+        }
+
+        // Filters (and optionally aggregates) an inventory without loading it:
+        // JSON is walked in place with the structural index, .rinv records are
+        // read from the mapping.
+        int query(const CliOptions &opt, Logger &logger)
+        {
+            if (!opt.input)
+            {
+                logger.error("inventory", "query needs --input");
+                return 1;
+            }
+            InventoryQueryOptions qopt;
+            qopt.paths = opt.paths;
+            qopt.minSize = opt.minSize.value_or(0);
+            if (opt.maxSize)
+                qopt.maxSize = *opt.maxSize;
+            if (opt.hashPrefix)
+            {
+                qopt.hashPrefix = *opt.hashPrefix;
+                for (char c : qopt.hashPrefix)
+                    if (!std::isxdigit(static_cast<unsigned char>(c)))
+                    {
+                        logger.error("inventory", "--hash expects a hex prefix", LogField("hash", qopt.hashPrefix));
+                        return 1;
+                    }
+            }
+            if (opt.groupBy && !parse_query_group(*opt.groupBy, qopt.group))
+            {
+                logger.error("inventory", "invalid --group-by (expected ext or dir)", LogField("group_by", *opt.groupBy));
+                return 1;
+            }
+            if (opt.count && !opt.groupBy)
+                qopt.group = QueryGroup::Total;
+
+            std::ofstream file;
+            std::ostream *out = &std::cout;
+            if (opt.output)
+            {
+                file.open(*opt.output, std::ios::binary | std::ios::trunc);
+                if (!file)
+                {
+                    logger.error("inventory", "Cannot open output file", LogField("path", *opt.output));
+                    return 2;
+                }
+                out = &file;
+            }
+
+            const auto t0 = std::chrono::steady_clock::now();
+            InventoryQuery q(qopt, *out);
+            std::string error;
+            if (is_rinv_file(*opt.input))
+            {
+                RinvView view;
+                if (!view.open(*opt.input, &error))
+                {
+                    logger.error("inventory", error);
+                    return 2;
+                }
+                run_inventory_query(view, q);
+            }
+            else
+            {
+                MappedFile in;
+                if (!in.open(*opt.input, &error, true))
+                {
+                    logger.error("inventory", "Cannot open input file", LogField("path", *opt.input));
+                    return 2;
+                }
+                const std::string_view json = find_inventory_json(in.view());
+                if (json.empty())
+                {
+                    logger.error("inventory", "No inventory found in input", LogField("path", *opt.input));
+                    return 2;
+                }
+                if (!run_inventory_query(json, q, &error))
+                {
+                    // No totals: they would read as the answer.
+                    logger.error("inventory", "Invalid inventory JSON", LogField("path", *opt.input), LogField("error", error));
+                    return 2;
+                }
+            }
+            q.finish();
+            if (!*out)
+            {
+                logger.error("inventory", "Cannot write output", LogField("path", opt.output.value_or("-")));
+                return 2;
+            }
+            logger.info("inventory", "query done", LogField("files", q.files()), LogField("bytes", q.bytes()),
+                        LogField("ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count()));
+            return 0;
+        }
+    }
+
+    int command_inventory(const CliOptions &opt)
+    {
+        Logger logger;
+        const std::string sub = opt.args.empty() ? std::string() : opt.args.front();
+        if (sub == "convert")
+            return convert(opt, logger);
+        if (sub == "query")
+            return query(opt, logger);
+        logger.error("inventory", "Unknown inventory subcommand (expected convert or query)", LogField("subcommand", sub));
+        return 1;
+    }
+
+}
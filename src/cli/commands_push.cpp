@@ -1,19 +1,73 @@
 #include "args.hpp"
+#include "../core/chunk_planner.hpp"
 #include "../core/gitops.hpp"
 #include "../core/logger.hpp"
+#include "../core/push_pipeline.hpp"
+#include "../core/push_snapshot.hpp"
 #include "../core/scanner.hpp"
 #include "../core/utils.hpp"
+#include <algorithm>
 #include <iostream>
 #include <ctime>
 
 namespace rogue
 {
 
+    namespace
+    {
+        ChunkLimits chunk_limits(const CliOptions &opt)
+        {
+            ChunkLimits limits;
+            if (opt.chunkMb)
+                limits.chunkBytes = std::uint64_t(*opt.chunkMb) << 20;
+            if (opt.maxPushMb)
+                limits.pushBytes = std::uint64_t(*opt.maxPushMb) << 20;
+            // Pipelined pushes overlap with the next commits only if there are
+            // several of them: push every chunk unless told otherwise.
+            limits.pushEvery = unsigned(opt.pushEvery.value_or(opt.pipeline ? 1 : 0));
+            return limits;
+        }
+
+        // Chunked mode: asked for explicitly, or implied by a large import.
+        bool wants_chunks(const CliOptions &opt, std::uintmax_t bytes)
+        {
+            return opt.chunkMb || opt.pushEvery || opt.maxPushMb || opt.pipeline || bytes > (100ull * 1024ull * 1024ull);
+        }
+
+        std::uintmax_t total_size(const std::vector<FileEntry> &files)
+        {
+            std::uintmax_t total = 0;
+            for (auto &f : files)
+                total += f.size;
+            return total;
+        }
+
+        // Against the inventory of the last successful push of `branch`; with
+        // no usable snapshot every file counts as added.
+        InventoryDiff diff_since_push(const CliOptions &opt, const std::string &branch, const ScanResult &inv, Logger &logger)
+        {
+            PushSnapshot last;
+            if (!last.load(PushSnapshot::default_path(opt.root), branch))
+                logger.info("push-all", "No snapshot of a previous push; every file counts as added");
+            InventoryDiff diff = diff_inventory(last.entries(), inv.files);
+            logger.info("push-all", "changes since last push", LogField("added", diff.added.size()), LogField("modified", diff.modified.size()),
+                        LogField("deleted", diff.deleted.size()));
+            return diff;
+        }
+    }
+
     int command_push(const CliOptions &opt)
     {
         Logger logger;
         GitOps git(logger);
 
+        if ((opt.chunkMb && *opt.chunkMb <= 0) || (opt.maxPushMb && *opt.maxPushMb <= 0) || (opt.pushEvery && *opt.pushEvery < 0) ||
+            (opt.pipelineWindow && *opt.pipelineWindow <= 0))
+        {
+            logger.error("push-all", "--chunk-mb, --max-push-mb and --pipeline-window must be positive, --push-every non-negative");
+            return 1;
+        }
+
         std::string msg = opt.commitMessage.value_or("");
         if (msg.empty())
         {
@@ -31,9 +85,29 @@ namespace rogue
             sopt.root = opt.root;
             sopt.maxSizeMb = 50;
             sopt.includeSecrets = opt.includeSecrets;
+            sopt.threads = opt.threads.value_or(0);
+            sopt.useCache = !opt.noCache;
+            sopt.detectSecrets = opt.detectSecrets;
+            sopt.inodeOrder = opt.inodeOrder;
+            if (opt.ioEngine)
+                parse_io_engine(*opt.ioEngine, sopt.ioEngine);
+            sopt.dedup = opt.dedup;
             auto inv = scan_workspace(sopt, logger);
-            std::string mode = (inv.ok && inv.totalSize > (100ull * 1024ull * 1024ull)) ? "chunked (~50MB)" : "single";
-            logger.info("push-all", "[dry-run] Would commit and push", {{"message", msg}, {"branch", opt.branch.value_or("main")}, {"mode", mode}});
+            if (inv.ok && git.drop_ignored(opt.root, inv.files))
+                inv.totalSize = total_size(inv.files);
+            if (inv.ok && opt.changedOnly && diff_since_push(opt, opt.branch.value_or("main"), inv, logger).empty())
+            {
+                logger.info("push-all", "[dry-run] Nothing changed since the last push; would neither commit nor push");
+                return 0;
+            }
+            if (inv.ok && !opt.nativePack && !opt.fastStage && wants_chunks(opt, inv.totalSize))
+            {
+                const ChunkPlan plan = plan_chunks(inv.files, chunk_limits(opt));
+                logger.info("push-all", "[dry-run] Would commit and push", LogField("message", msg), LogField("branch", opt.branch.value_or("main")),
+                            LogField("mode", "chunked"), LogField("commits", plan.chunks.size()), LogField("pushes", plan.pushes), LogField("skipped", plan.skipped.size()));
+                return 0;
+            }
+            logger.info("push-all", "[dry-run] Would commit and push", {{"message", msg}, {"branch", opt.branch.value_or("main")}, {"mode", "single"}});
             return 0;
         }
 
@@ -42,39 +116,156 @@ namespace rogue
         sopt.root = opt.root;
         sopt.maxSizeMb = 50;
         sopt.includeSecrets = opt.includeSecrets;
+        sopt.threads = opt.threads.value_or(0);
+        sopt.useCache = !opt.noCache;
+        sopt.detectSecrets = opt.detectSecrets;
+        sopt.inodeOrder = opt.inodeOrder;
+        if (opt.ioEngine)
+            parse_io_engine(*opt.ioEngine, sopt.ioEngine);
+        sopt.dedup = opt.dedup; // chunk plans weigh unique bytes
+        sopt.gitOids = opt.nativePack || opt.fastStage;
         auto inv = scan_workspace(sopt, logger);
-        if (inv.ok && inv.totalSize > (100ull * 1024ull * 1024ull))
+        const std::string branch = opt.branch.value_or("main");
+        // The scan only knows .rogueignore; what .gitignore excludes is not
+        // staged by `git add -A`, so it is not staged or committed here either.
+        if (inv.ok && !git.drop_ignored(opt.root, inv.files))
         {
-            std::uintmax_t chunk = 0;
-            std::vector<std::string> staged;
-            for (auto &f : inv.files)
+            logger.error("push-all", "Cannot read .gitignore rules (is root a git repository?)");
+            return 6;
+        }
+        inv.totalSize = total_size(inv.files);
+
+        // --changed-only: an unchanged tree ends the run here; otherwise only
+        // added and modified files are staged, and deletions are unstaged.
+        // Native pack and fast stage always write the full tree, so for them
+        // this only decides whether there is anything to do.
+        std::vector<FileEntry> changed;
+        const std::vector<FileEntry> *toCommit = &inv.files;
+        if (inv.ok && opt.changedOnly)
+        {
+            const InventoryDiff diff = diff_since_push(opt, branch, inv, logger);
+            if (diff.empty())
+            {
+                logger.info("push-all", "Nothing changed since the last push; skipping commit and push");
+                return 0;
+            }
+            if (!opt.nativePack && !opt.fastStage)
             {
-                if (f.size > 50ull * 1024ull * 1024ull)
+                for (auto *idx : {&diff.added, &diff.modified})
+                    for (std::size_t i : *idx)
+                        changed.push_back(inv.files[i]);
+                std::sort(changed.begin(), changed.end(), [](const FileEntry &a, const FileEntry &b)
+                          { return a.path < b.path; });
+                toCommit = &changed;
+                if (!git.remove_paths(opt.root, diff.deleted))
                 {
-                    logger.warn("push-all", std::string("skip >50MB: ") + f.path);
-                    continue;
+                    logger.error("push-all", "Failed to stage deletions");
+                    return 6;
                 }
-                staged.push_back(f.path);
-                chunk += f.size;
-                if (chunk >= 50ull * 1024ull * 1024ull)
+            }
+        }
+
+        // Staging listed paths only adds files; tracked files gone from the
+        // workspace leave the commit here, as they would with `git add -A`.
+        if (inv.ok && !opt.nativePack && !opt.fastStage && !git.stage_deletions(opt.root))
+        {
+            logger.error("push-all", "Failed to stage deletions");
+            return 6;
+        }
+
+        if (inv.ok && opt.nativePack)
+        {
+            // One pack straight from the scanned list; git does not re-read the tree.
+            const CommitResult result = git.commit_files(opt.root, inv.files, msg, sopt.threads);
+            if (result == CommitResult::Failed)
+            {
+                logger.error("push-all", "Native commit failed");
+                return 7;
+            }
+            if (result == CommitResult::Unchanged)
+                logger.info("push-all", "Nothing to commit; pushing the current HEAD");
+        }
+        else if (inv.ok && opt.fastStage)
+        {
+            // Index written from the scan; git commit then only builds trees.
+            if (!git.stage_files(opt.root, inv.files, sopt.threads))
+            {
+                logger.error("push-all", "Failed to stage files");
+                return 6;
+            }
+            if (git.commit(opt.root, msg) == CommitResult::Failed)
+            {
+                logger.error("push-all", "Commit failed");
+                return 7;
+            }
+        }
+        else if (inv.ok && wants_chunks(opt, total_size(*toCommit)))
+        {
+            // Each commit stages exactly its planned files; pushes go out as
+            // the plan says so no single push carries the whole import.
+            const std::vector<FileEntry> &files = *toCommit;
+            const ChunkPlan plan = plan_chunks(files, chunk_limits(opt));
+            for (std::size_t i : plan.skipped)
+                logger.warn("push-all", "skip >50MB", LogField("path", files[i].path));
+            std::optional<PushPipeline> pipeline;
+            if (opt.pipeline)
+                pipeline.emplace(git, opt.root, branch, std::size_t(opt.pipelineWindow.value_or(2)));
+            std::vector<std::string> paths;
+            for (std::size_t c = 0; c < plan.chunks.size(); ++c)
+            {
+                const Chunk &chunk = plan.chunks[c];
+                paths.clear();
+                for (std::size_t i : chunk.files)
+                    paths.push_back(files[i].path);
+                logger.info("push-all", "chunk", LogField("n", c + 1), LogField("of", plan.chunks.size()), LogField("files", paths.size()), LogField("bytes", chunk.bytes));
+                if (!git.stage_paths(opt.root, paths))
+                {
+                    logger.error("push-all", "Failed to stage files");
+                    return 6;
+                }
+                // A chunk with nothing new (already committed) is skipped by git.
+                if (git.commit(opt.root, msg + " [chunk " + std::to_string(c + 1) + "/" + std::to_string(plan.chunks.size()) + "]") == CommitResult::Failed)
+                {
+                    logger.error("push-all", "Commit failed", LogField("chunk", c + 1));
+                    return 7;
+                }
+                if (pipeline && chunk.pushAfter)
+                {
+                    // Pushed in the background while the next chunk is staged.
+                    const std::string head = git.head_commit(opt.root);
+                    if (!head.empty() && !pipeline->submit(head))
+                        break;
+                }
+                else if (chunk.pushAfter && c + 1 < plan.chunks.size() && !git.push(opt.root, branch))
                 {
-                    if (!git.stage_all(opt.root))
-                    {
-                        logger.error("push-all", "Failed to stage files");
-                        return 6;
-                    }
-                    // Commit can fail if nothing to commit - that's OK
-                    git.commit(opt.root, msg + " [chunk]");
-                    staged.clear();
-                    chunk = 0;
+                    logger.error("push-all", "Failed to push");
+                    return 8;
                 }
             }
-            if (!staged.empty())
+            if (pipeline)
             {
-                if (!git.stage_all(opt.root))
-                    return 6;
-                // Commit can fail if nothing to commit - that's OK
-                git.commit(opt.root, msg + " [chunk]");
+                if (!pipeline->finish())
+                {
+                    logger.error("push-all", "Failed to push", LogField("pushed", pipeline->pushed()));
+                    return 8;
+                }
+                logger.info("push-all", "pipelined pushes done", LogField("pushes", pipeline->pushed()));
+            }
+        }
+        else if (inv.ok && opt.changedOnly)
+        {
+            std::vector<std::string> paths;
+            for (auto &f : changed)
+                paths.push_back(f.path);
+            if (!git.stage_paths(opt.root, paths))
+            {
+                logger.error("push-all", "Failed to stage files");
+                return 6;
+            }
+            if (git.commit(opt.root, msg) == CommitResult::Failed)
+            {
+                logger.error("push-all", "Commit failed");
+                return 7;
             }
         }
         else
@@ -84,18 +275,23 @@ namespace rogue
                 logger.error("push-all", "Failed to stage files");
                 return 6;
             }
-            if (!git.commit(opt.root, msg))
+            if (git.commit(opt.root, msg) == CommitResult::Failed)
             {
-                logger.warn("push-all", "Commit failed (possibly nothing to commit); will attempt push anyway");
-                // Don't return error - might be "nothing to commit" which is OK
+                logger.error("push-all", "Commit failed");
+                return 7;
             }
         }
-        // push (always attempt, even if commit was skipped)
-        if (!git.push(opt.root, opt.branch.value_or("main")))
+        // push (also when there was nothing new to commit: HEAD may not be
+        // on the remote yet); every commit above either succeeded or had
+        // nothing to do, so the snapshot below matches what is pushed.
+        if (!git.push(opt.root, branch))
         {
             logger.error("push-all", "Failed to push");
             return 8;
         }
+        // What is now on the remote is the base for the next --changed-only.
+        if (inv.ok && !PushSnapshot::save(PushSnapshot::default_path(opt.root), branch, inv.files))
+            logger.warn("push-all", "Could not record the pushed inventory", LogField("path", PushSnapshot::default_path(opt.root)));
 
         logger.info("push-all", "Pushed successfully");
         return 0;
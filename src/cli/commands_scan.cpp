@@ -1,8 +1,13 @@
 #include "args.hpp"
 #include "../core/scanner.hpp"
+#include "../core/inventory_writer.hpp"
 #include "../core/logger.hpp"
 #include "../core/config.hpp"
+#include "../core/push_snapshot.hpp"
+#include "../core/rinv.hpp"
+#include <fstream>
 #include <iostream>
+#include <memory>
 
 namespace rogue
 {
@@ -10,6 +15,41 @@ namespace rogue
     int command_scan(const CliOptions &opt)
     {
         Logger logger;
+        InventoryFormat format = InventoryFormat::Json;
+        // .rinv is written from the sorted result, not streamed
+        const bool rinv = opt.format && *opt.format == "rinv";
+        if (opt.format && !rinv && !parse_inventory_format(*opt.format, format))
+        {
+            logger.error("scan", "Unknown --format (expected json, json-stream, ndjson or rinv)", {{"format", *opt.format}});
+            return 1;
+        }
+        if (rinv && (!opt.output || opt.diff))
+        {
+            logger.error("scan", "--format rinv needs --output and cannot be combined with --diff");
+            return 1;
+        }
+        if (opt.diff && format != InventoryFormat::Json)
+        {
+            logger.error("scan", "--diff needs the whole inventory; it cannot be combined with a streaming --format");
+            return 1;
+        }
+        std::ofstream file;
+        std::ostream *out = &std::cout;
+        if (opt.output && !rinv)
+        {
+            file.open(*opt.output, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                logger.error("scan", "Cannot open output file", {{"path", *opt.output}});
+                return 2;
+            }
+            out = &file;
+        }
+        // Streamed entries are written to stdout from the hashing threads; log
+        // lines there would land in the middle of them.
+        if (format != InventoryFormat::Json && out == &std::cout)
+            logger.set_console_to_stderr(true);
+
         logger.info("scan", "Starting scan", {{"root", opt.root}});
         ScanOptions sopt;
         sopt.root = opt.root;
@@ -17,13 +57,49 @@ namespace rogue
         sopt.excludes = opt.excludes;
         sopt.maxSizeMb = opt.maxSizeMb.value_or(50);
         sopt.includeSecrets = opt.includeSecrets;
+        sopt.threads = opt.threads.value_or(0);
+        sopt.useCache = !opt.noCache;
+        sopt.detectSecrets = opt.detectSecrets;
+        sopt.inodeOrder = opt.inodeOrder;
+        if (opt.ioEngine)
+            parse_io_engine(*opt.ioEngine, sopt.ioEngine);
+        sopt.dedup = opt.dedup;
+        // Streaming formats write each entry as soon as it is hashed
+        std::unique_ptr<InventoryWriter> sink;
+        if (format != InventoryFormat::Json)
+        {
+            sink = make_inventory_writer(format, *out);
+            sopt.sink = sink.get();
+        }
         auto result = scan_workspace(sopt, logger);
         if (!result.ok)
         {
             logger.error("scan", result.errorMessage);
             return 2;
         }
-        std::cout << result.inventoryJson << std::endl;
+        if (opt.diff)
+        {
+            // Added / modified / deleted since the last successful push-all.
+            const std::string branch = opt.branch.value_or("main");
+            PushSnapshot last;
+            if (!last.load(PushSnapshot::default_path(opt.root), branch))
+                logger.warn("scan", "No snapshot of a previous push; every file counts as added", {{"branch", branch}});
+            const InventoryDiff diff = diff_inventory(last.entries(), result.files);
+            logger.info("scan", "diff", LogField("added", diff.added.size()), LogField("modified", diff.modified.size()),
+                        LogField("deleted", diff.deleted.size()));
+            *out << inventory_diff_json(diff, result.files) << std::endl;
+        }
+        else if (rinv)
+        {
+            std::string error;
+            if (!write_rinv(*opt.output, opt.root, result.generatedAt, result.files, result.totalSize, &error))
+            {
+                logger.error("scan", error);
+                return 2;
+            }
+        }
+        else if (!sink)
+            *out << result.inventoryJson << std::endl;
         logger.info("scan", "Completed");
         return 0;
     }
@@ -0,0 +1,96 @@
+#include "args.hpp"
+#include "../core/live_inventory.hpp"
+#include "../core/logger.hpp"
+#include "../core/utils.hpp"
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+    namespace
+    {
+        volatile std::sig_atomic_t g_stop = 0;
+
+        void on_signal(int) { g_stop = 1; }
+
+        // Readers of the file never see a half-written inventory.
+        bool write_atomically(const fs::path &path, const std::string &text)
+        {
+            const fs::path tmp = path.string() + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                if (!(out << text << '\n'))
+                    return false;
+            }
+            std::error_code ec;
+            fs::rename(tmp, path, ec);
+            return !ec;
+        }
+    }
+
+    int command_watch(const CliOptions &opt)
+    {
+        Logger logger;
+        if (opt.root.empty())
+        {
+            logger.error("watch", "--root is required");
+            return 1;
+        }
+        if (opt.settleMs && *opt.settleMs < 0)
+        {
+            logger.error("watch", "--settle-ms must be non-negative");
+            return 1;
+        }
+        ScanOptions sopt;
+        sopt.root = opt.root;
+        sopt.includes = opt.includes;
+        sopt.excludes = opt.excludes;
+        sopt.maxSizeMb = opt.maxSizeMb.value_or(50);
+        sopt.includeSecrets = opt.includeSecrets;
+        sopt.threads = opt.threads.value_or(0);
+        sopt.useCache = !opt.noCache;
+        sopt.detectSecrets = opt.detectSecrets;
+        sopt.inodeOrder = opt.inodeOrder;
+        if (opt.ioEngine)
+            parse_io_engine(*opt.ioEngine, sopt.ioEngine);
+
+        const fs::path output = opt.output ? fs::path(*opt.output) : fs::path(opt.root) / ".rogue" / "inventory.json";
+        std::error_code ec;
+        fs::create_directories(fs::absolute(output, ec).parent_path(), ec);
+        // An inventory file inside the tree, or the temporary it is written
+        // to first, must not feed its own updates.
+        const std::string rel = utils::path_under(opt.root, output);
+        if (!rel.empty())
+        {
+            sopt.excludes.push_back(rel);
+            sopt.excludes.push_back(rel + ".tmp");
+        }
+
+        LiveInventory live(sopt, logger, unsigned(opt.settleMs.value_or(200)));
+        if (!live.start())
+            return 2;
+        if (!write_atomically(output, live.snapshot().inventoryJson))
+        {
+            logger.error("watch", "Cannot write inventory", LogField("path", output.string()));
+            return 2;
+        }
+        logger.info("watch", "watching", LogField("root", opt.root), LogField("inventory", output.string()));
+
+        std::signal(SIGINT, on_signal);
+        std::signal(SIGTERM, on_signal);
+        while (!g_stop)
+        {
+            if (live.wait_and_apply(250) == 0)
+                continue;
+            if (!write_atomically(output, live.snapshot().inventoryJson))
+                logger.warn("watch", "Cannot write inventory", LogField("path", output.string()));
+        }
+        logger.info("watch", "stopped", LogField("files", live.file_count()));
+        return 0;
+    }
+
+}
@@ -0,0 +1,571 @@
+#include "batch_reader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ROGUE_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace rogue
+{
+
+bool parse_io_engine(std::string_view s, IoEngine& out)
+{
+    if (s == "auto")
+        out = IoEngine::Auto;
+    else if (s == "io_uring" || s == "uring")
+        out = IoEngine::IoUring;
+    else if (s == "threads")
+        out = IoEngine::Threads;
+    else if (s == "off")
+        out = IoEngine::Off;
+    else
+        return false;
+    return true;
+}
+
+const char* io_engine_name(IoEngine engine)
+{
+    switch (engine)
+    {
+        case IoEngine::Auto:
+            return "auto";
+        case IoEngine::IoUring:
+            return "io_uring";
+        case IoEngine::Threads:
+            return "threads";
+        case IoEngine::Off:
+            break;
+    }
+    return "off";
+}
+
+// Owns the slot arena; results come back in any order.
+class BatchReader::Backend
+{
+public:
+    // Left uninitialized: every byte handed out was just read.
+    explicit Backend(unsigned depth)
+        : arenaSize_(std::size_t(depth) * kSlotSize), arena_(new unsigned char[arenaSize_])
+    {
+    }
+    virtual ~Backend() = default;
+    virtual IoEngine engine() const = 0;
+    virtual void submit(unsigned slot, std::string path) = 0;
+    virtual Completion wait() = 0;
+
+protected:
+    unsigned char* slot_data(unsigned slot) { return arena_.get() + std::size_t(slot) * kSlotSize; }
+    const std::size_t arenaSize_;
+    std::unique_ptr<unsigned char[]> arena_;
+};
+
+namespace
+{
+
+constexpr std::size_t kSlotSize = BatchReader::kSlotSize;
+
+// --- thread pool ----------------------------------------------------------
+
+class ThreadBackend final : public BatchReader::Backend
+{
+public:
+    ThreadBackend(unsigned depth, unsigned threads) : Backend(depth)
+    {
+        threads = std::max(1u, std::min(threads, depth));
+        for (unsigned i = 0; i < threads; ++i)
+            workers_.emplace_back([this] { run(); });
+    }
+
+    ~ThreadBackend() override
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        todoCv_.notify_all();
+        for (auto& t : workers_)
+            t.join();
+    }
+
+    IoEngine engine() const override { return IoEngine::Threads; }
+
+    void submit(unsigned slot, std::string path) override
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            todo_.emplace_back(slot, std::move(path));
+        }
+        todoCv_.notify_one();
+    }
+
+    BatchReader::Completion wait() override
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        doneCv_.wait(lk, [&] { return !done_.empty(); });
+        auto c = done_.front();
+        done_.pop_front();
+        return c;
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::pair<unsigned, std::string> job;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                todoCv_.wait(lk, [&] { return stop_ || !todo_.empty(); });
+                if (stop_)
+                    return;
+                job = std::move(todo_.front());
+                todo_.pop_front();
+            }
+            unsigned char* buf = slot_data(job.first);
+            BatchReader::Completion c;
+            c.slot = job.first;
+            c.data = buf;
+            read_whole(job.second, buf, c);
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                done_.push_back(c);
+            }
+            doneCv_.notify_one();
+        }
+    }
+
+    // Up to kSlotSize bytes; stops early only at end of file.
+    static void read_whole(const std::string& path, unsigned char* buf, BatchReader::Completion& c)
+    {
+#ifdef _WIN32
+        std::FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f)
+        {
+            c.error = errno ? errno : EIO;
+            return;
+        }
+        std::setvbuf(f, nullptr, _IONBF, 0);
+        c.size = std::fread(buf, 1, kSlotSize, f);
+        if (std::ferror(f))
+            c.error = EIO;
+        std::fclose(f);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            c.error = errno;
+            return;
+        }
+        while (c.size < kSlotSize)
+        {
+            ssize_t n = ::read(fd, buf + c.size, kSlotSize - c.size);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0)
+                c.error = errno;
+            if (n <= 0)
+                break;
+            c.size += std::size_t(n);
+        }
+        ::close(fd);
+#endif
+    }
+
+    std::mutex mu_;
+    std::condition_variable todoCv_;
+    std::condition_variable doneCv_;
+    std::deque<std::pair<unsigned, std::string>> todo_;
+    std::deque<BatchReader::Completion> done_;
+    bool stop_{false};
+    std::vector<std::thread> workers_;
+};
+
+// --- io_uring -------------------------------------------------------------
+
+#if defined(ROGUE_HAVE_IO_URING)
+
+// glibc has no wrappers; the numbers are the same on every architecture.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+int sys_io_uring_setup(unsigned entries, io_uring_params* p)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, unsigned op, const void* arg, unsigned n)
+{
+    return int(::syscall(__NR_io_uring_register, fd, op, arg, n));
+}
+
+// Each file is an OPENAT, then a READ(_FIXED) hard-linked to a CLOSE so the
+// descriptor is closed by the kernel even if the read fails. Nothing is
+// submitted until wait(): a batch of opens, and then of read/close pairs,
+// goes in with one io_uring_enter.
+class UringBackend final : public BatchReader::Backend
+{
+public:
+    // Null if the kernel lacks io_uring or the ops used here.
+    static std::unique_ptr<UringBackend> create(unsigned depth)
+    {
+        std::unique_ptr<UringBackend> b(new UringBackend(depth));
+        return b->setup() ? std::move(b) : nullptr;
+    }
+
+    ~UringBackend() override
+    {
+        // The kernel may still write into the arena: drain before it goes.
+        draining_ = true;
+        while (ringFd_ >= 0 && outstanding_ > 0)
+        {
+            if (!enter(1))
+                break;
+            reap();
+        }
+        if (sqes_)
+            ::munmap(sqes_, sqesSize_);
+        if (cqPtr_ && cqPtr_ != sqPtr_)
+            ::munmap(cqPtr_, cqSize_);
+        if (sqPtr_)
+            ::munmap(sqPtr_, sqSize_);
+        if (ringFd_ >= 0)
+            ::close(ringFd_);
+    }
+
+    IoEngine engine() const override { return IoEngine::IoUring; }
+
+    void submit(unsigned slot, std::string path) override
+    {
+        paths_[slot] = std::move(path);
+        io_uring_sqe* sqe = next_sqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<std::uint64_t>(paths_[slot].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = tag(slot, kOpen);
+    }
+
+    BatchReader::Completion wait() override
+    {
+        while (ready_.empty())
+        {
+            if (!enter(1))
+            {
+                // The ring is unusable (should not happen once set up):
+                // fail every read in flight rather than hang.
+                fail_all(errno ? errno : EIO);
+                break;
+            }
+            reap();
+            // Reads for the files just opened go in now, not after the
+            // caller has hashed this batch.
+            if (toSubmit_)
+                enter(0);
+        }
+        auto c = ready_.front();
+        ready_.pop_front();
+        return c;
+    }
+
+private:
+    enum Op : std::uint64_t
+    {
+        kOpen = 1,
+        kRead = 2,
+        kClose = 3
+    };
+    static std::uint64_t tag(unsigned slot, Op op) { return (std::uint64_t(slot) << 8) | op; }
+
+    explicit UringBackend(unsigned depth) : Backend(depth), paths_(depth), depth_(depth) {}
+
+    bool setup()
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof p);
+        // A slot has at most a read and a close queued at once.
+        ringFd_ = sys_io_uring_setup(2 * depth_, &p);
+        if (ringFd_ < 0)
+            return false;
+        sqEntries_ = p.sq_entries;
+
+        sqSize_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqSize_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single)
+            sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+        sqPtr_ = map(sqSize_, IORING_OFF_SQ_RING);
+        if (!sqPtr_)
+            return false;
+        cqPtr_ = single ? sqPtr_ : map(cqSize_, IORING_OFF_CQ_RING);
+        sqesSize_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqesSize_, IORING_OFF_SQES));
+        if (!cqPtr_ || !sqes_)
+            return false;
+
+        auto* sq = static_cast<char*>(sqPtr_);
+        auto* cq = static_cast<char*>(cqPtr_);
+        sqHead_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        localTail_ = *sqTail_;
+
+        // OPENAT and CLOSE need 5.6; probing needs 5.6 too, so an older
+        // kernel fails here.
+        std::vector<unsigned char> probeBuf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeBuf.data());
+        if (sys_io_uring_register(ringFd_, IORING_REGISTER_PROBE, probe, 256) < 0)
+            return false;
+        auto supported = [&](unsigned op)
+        { return op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED); };
+        if (!supported(IORING_OP_OPENAT) || !supported(IORING_OP_CLOSE) || !supported(IORING_OP_READ))
+            return false;
+
+        // Registered buffers save a page pin per read. They count against
+        // RLIMIT_MEMLOCK on older kernels; plain READ works without.
+        iovec iov{arena_.get(), arenaSize_};
+        fixed_ = supported(IORING_OP_READ_FIXED) && sys_io_uring_register(ringFd_, IORING_REGISTER_BUFFERS, &iov, 1) == 0;
+        return true;
+    }
+
+    void* map(std::size_t size, std::uint64_t offset)
+    {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd_, off_t(offset));
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    io_uring_sqe* next_sqe()
+    {
+        if (localTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_)
+            enter(0);  // not expected with 2 * depth entries, but never overwrite
+        const unsigned idx = localTail_ & sqMask_;
+        io_uring_sqe* sqe = &sqes_[idx];
+        std::memset(sqe, 0, sizeof *sqe);
+        sqArray_[idx] = idx;
+        ++localTail_;
+        ++toSubmit_;
+        ++outstanding_;
+        return sqe;
+    }
+
+    // Submits what is queued and waits for minComplete completions.
+    bool enter(unsigned minComplete)
+    {
+        __atomic_store_n(sqTail_, localTail_, __ATOMIC_RELEASE);
+        for (;;)
+        {
+            int n = sys_io_uring_enter(ringFd_, toSubmit_, minComplete, minComplete ? IORING_ENTER_GETEVENTS : 0);
+            if (n >= 0)
+            {
+                toSubmit_ -= std::min<unsigned>(toSubmit_, unsigned(n));
+                if (!toSubmit_ || minComplete)
+                    return true;
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            // Completions are backed up or the kernel is short of memory:
+            // what is queued goes in on a later call, after a reap.
+            if (errno == EBUSY || errno == EAGAIN)
+                return true;
+            return false;
+        }
+    }
+
+    void reap()
+    {
+        unsigned head = *cqHead_;
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            --outstanding_;
+            const unsigned slot = unsigned(cqe.user_data >> 8);
+            switch (Op(cqe.user_data & 0xff))
+            {
+                case kOpen:
+                    if (cqe.res < 0)
+                        finish(slot, -cqe.res, 0);
+                    else if (draining_)
+                        ::close(cqe.res);
+                    else
+                        queue_read(slot, cqe.res);
+                    break;
+                case kRead:
+                    finish(slot, cqe.res < 0 ? -cqe.res : 0, cqe.res < 0 ? 0 : std::size_t(cqe.res));
+                    break;
+                case kClose:
+                    break;
+            }
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+
+    void queue_read(unsigned slot, int fd)
+    {
+        io_uring_sqe* read = next_sqe();
+        read->opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        read->fd = fd;
+        read->addr = reinterpret_cast<std::uint64_t>(slot_data(slot));
+        read->len = unsigned(kSlotSize);
+        read->off = 0;
+        read->buf_index = 0;
+        read->flags = IOSQE_IO_HARDLINK;
+        read->user_data = tag(slot, kRead);
+        io_uring_sqe* close = next_sqe();
+        close->opcode = IORING_OP_CLOSE;
+        close->fd = fd;
+        close->user_data = tag(slot, kClose);
+    }
+
+    void finish(unsigned slot, int error, std::size_t size)
+    {
+        BatchReader::Completion c;
+        c.slot = slot;
+        c.data = slot_data(slot);
+        c.size = size;
+        c.error = error;
+        ready_.push_back(c);
+        paths_[slot].clear();
+    }
+
+    void fail_all(int error)
+    {
+        // Only reached if io_uring_enter itself fails; the slots the caller
+        // is waiting on are those without a result yet.
+        std::vector<bool> done(depth_, false);
+        for (auto& c : ready_)
+            done[c.slot] = true;
+        for (unsigned s = 0; s < depth_; ++s)
+            if (!paths_[s].empty() && !done[s])
+                finish(s, error, 0);
+        outstanding_ = 0;
+    }
+
+    std::vector<std::string> paths_;  // kept until the read completes; empty when idle
+    const unsigned depth_;
+    std::deque<BatchReader::Completion> ready_;
+    int ringFd_{-1};
+    bool fixed_{false};
+    bool draining_{false};
+    unsigned sqEntries_{0};
+    std::size_t sqSize_{0}, cqSize_{0}, sqesSize_{0};
+    void* sqPtr_{nullptr};
+    void* cqPtr_{nullptr};
+    io_uring_sqe* sqes_{nullptr};
+    unsigned *sqHead_{nullptr}, *sqTail_{nullptr}, *sqArray_{nullptr}, sqMask_{0};
+    unsigned *cqHead_{nullptr}, *cqTail_{nullptr}, cqMask_{0};
+    io_uring_cqe* cqes_{nullptr};
+    unsigned localTail_{0};
+    unsigned toSubmit_{0};
+    std::size_t outstanding_{0};  // SQEs without a CQE yet
+};
+
+#endif  // ROGUE_HAVE_IO_URING
+
+}  // namespace
+
+BatchReader::BatchReader(IoEngine engine, unsigned depth, unsigned threads) : depth_(std::max(1u, depth))
+{
+#if defined(ROGUE_HAVE_IO_URING)
+    if (engine == IoEngine::Auto || engine == IoEngine::IoUring)
+        backend_ = UringBackend::create(depth_);
+#else
+    (void)engine;
+#endif
+    if (!backend_)
+        backend_ = std::make_unique<ThreadBackend>(depth_, threads);
+    free_.reserve(depth_);
+    for (unsigned s = depth_; s-- > 0;)
+        free_.push_back(s);
+}
+
+BatchReader::~BatchReader() = default;
+
+bool BatchReader::available(IoEngine engine)
+{
+    switch (engine)
+    {
+        case IoEngine::Auto:
+        case IoEngine::Threads:
+            return true;
+        case IoEngine::IoUring:
+#if defined(ROGUE_HAVE_IO_URING)
+            return UringBackend::create(1) != nullptr;
+#else
+            return false;
+#endif
+        case IoEngine::Off:
+            break;
+    }
+    return false;
+}
+
+IoEngine BatchReader::engine() const
+{
+    return backend_->engine();
+}
+
+void BatchReader::release_last()
+{
+    if (lastSlot_ >= 0)
+        free_.push_back(unsigned(lastSlot_));
+    lastSlot_ = -1;
+}
+
+unsigned BatchReader::submit(std::string path)
+{
+    release_last();
+    const unsigned slot = free_.back();
+    free_.pop_back();
+    ++inFlight_;
+    backend_->submit(slot, std::move(path));
+    return slot;
+}
+
+BatchReader::Completion BatchReader::wait()
+{
+    release_last();
+    Completion c = backend_->wait();
+    --inFlight_;
+    lastSlot_ = int(c.slot);
+    return c;
+}
+
+}  // namespace rogue
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rogue
+{
+
+enum class IoEngine : std::uint8_t
+{
+    Auto,     // io_uring when the kernel allows it, else threads
+    IoUring,  // Linux 5.6+
+    Threads,  // blocking reads on a small pool
+    Off       // read each file on the hashing thread (utils::sha256_file)
+};
+
+// "auto", "io_uring", "threads", "off"
+bool parse_io_engine(std::string_view s, IoEngine& out);
+const char* io_engine_name(IoEngine engine);
+
+// Reads many small files whole, with up to depth() opens and reads in
+// flight at once, so a tree of small files costs round trips to the device
+// rather than one blocking open/read/close per file on the hashing thread.
+//
+// Each read lands in its own slot of one buffer arena. With io_uring the
+// arena is registered with the kernel (READ_FIXED), every open, read and
+// close is an SQE, and a submit is one syscall for the whole batch. The
+// thread engine does the same work with blocking calls on `threads` workers.
+//
+// One thread drives a reader: submit() while !full(), wait() for results.
+class BatchReader
+{
+public:
+    // Files are read up to this many bytes; a read that fills the slot is
+    // reported as incomplete and the caller streams the file instead.
+    static constexpr std::size_t kSlotSize = 16 * 1024;
+
+    struct Completion
+    {
+        unsigned slot{0};  // as returned by submit()
+        const unsigned char* data{nullptr};
+        std::size_t size{0};
+        int error{0};  // errno from open or read, 0 on success
+        // The read ended before filling the slot. With io_uring that is one
+        // read, which may stop short of the end of the file (network or FUSE
+        // file systems): callers compare size with the file's own as well.
+        bool complete() const { return error == 0 && size < kSlotSize; }
+    };
+
+    // Falls back from io_uring to threads if the ring cannot be set up
+    // (old kernel, seccomp, io_uring_disabled). Off is not a valid engine.
+    explicit BatchReader(IoEngine engine = IoEngine::Auto, unsigned depth = 256, unsigned threads = 8);
+    ~BatchReader();
+    BatchReader(const BatchReader&) = delete;
+    BatchReader& operator=(const BatchReader&) = delete;
+
+    static bool available(IoEngine engine);
+
+    IoEngine engine() const;  // the one in use
+    unsigned depth() const { return depth_; }
+    std::size_t in_flight() const { return inFlight_; }
+    bool full() const { return inFlight_ == depth_; }
+
+    // Queues a read of `path`; returns its slot (< depth()). Requires !full().
+    unsigned submit(std::string path);
+    // Blocks for the next finished read. Completion::data stays valid until
+    // the next submit() or wait(). Requires in_flight() > 0.
+    Completion wait();
+
+    class Backend;
+
+private:
+    const unsigned depth_;
+    std::size_t inFlight_{0};
+    std::unique_ptr<Backend> backend_;
+    std::vector<unsigned> free_;
+    int lastSlot_{-1};  // handed out by the previous wait(), freed by the next call
+
+    void release_last();
+};
+
+}  // namespace rogue
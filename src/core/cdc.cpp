@@ -0,0 +1,189 @@
+#include "cdc.hpp"
+
+#include <cstring>
+
+namespace rogue
+{
+
+namespace
+{
+
+constexpr std::uint64_t splitmix64(std::uint64_t& x)
+{
+    std::uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+struct GearTables
+{
+    std::uint64_t gear[256];
+    std::uint64_t gearLs[256];  // gear << 1, for the first byte of each pair
+    constexpr GearTables() : gear(), gearLs()
+    {
+        std::uint64_t seed = 0x726F677565636463ULL;
+        for (int i = 0; i < 256; ++i)
+        {
+            gear[i] = splitmix64(seed);
+            gearLs[i] = gear[i] << 1;
+        }
+    }
+};
+
+constexpr GearTables kTables;
+
+// FastCDC masks for an 8 KiB average: 15 bits below it, 11 above
+// (normalization level 2), spread over the high half of the hash.
+constexpr std::uint64_t kMaskS = 0x0000D9F003530000ULL;
+constexpr std::uint64_t kMaskL = 0x0000D90003530000ULL;
+constexpr std::uint64_t kMaskSLs = kMaskS << 1;
+constexpr std::uint64_t kMaskLLs = kMaskL << 1;
+
+inline std::uint64_t mul_fold(std::uint64_t a, std::uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 r = (unsigned __int128)a * b;
+    return std::uint64_t(r) ^ std::uint64_t(r >> 64);
+#else
+    const std::uint64_t aLo = a & 0xFFFFFFFFu, aHi = a >> 32, bLo = b & 0xFFFFFFFFu, bHi = b >> 32;
+    const std::uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    const std::uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+    const std::uint64_t lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+    const std::uint64_t hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return lo ^ hi;
+#endif
+}
+
+inline std::uint64_t load64(const std::uint8_t* p)
+{
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+}  // namespace
+
+ChunkKey chunk_fingerprint(const std::uint8_t* data, std::size_t len)
+{
+    // Two independent multiply-fold lanes over 16-byte blocks.
+    std::uint64_t s0 = 0x243F6A8885A308D3ULL ^ len;
+    std::uint64_t s1 = 0x13198A2E03707344ULL + len;
+    std::size_t i = 0;
+    auto round = [&](std::uint64_t x, std::uint64_t y)
+    {
+        s0 = mul_fold(x ^ s0 ^ 0xA4093822299F31D0ULL, y ^ 0x082EFA98EC4E6C89ULL);
+        s1 = mul_fold(y ^ s1 ^ 0x452821E638D01377ULL, x ^ 0xBE5466CF34E90C6CULL);
+    };
+    for (; i + 16 <= len; i += 16)
+        round(load64(data + i), load64(data + i + 8));
+    if (i < len)
+    {
+        std::uint8_t tail[16] = {};
+        std::memcpy(tail, data + i, len - i);
+        round(load64(tail), load64(tail + 8));
+    }
+    ChunkKey k;
+    k.lo = mul_fold(s0 ^ 0xC0AC29B7C97C50DDULL, s1 ^ 0x3F84D5B5B5470917ULL);
+    k.hi = mul_fold(s1 ^ 0x9216D5D98979FB1BULL, s0 ^ 0xD1310BA698DFB5ACULL);
+    return k;
+}
+
+CdcChunker::CdcChunker() : buf_(4 * kMaxSize) {}
+
+void CdcChunker::compact()
+{
+    if (begin_ == 0)
+        return;
+    std::memmove(buf_.data(), buf_.data() + begin_, end_ - begin_);
+    end_ -= begin_;
+    begin_ = 0;
+}
+
+std::size_t CdcChunker::find_cut(const std::uint8_t* data, std::size_t len)
+{
+    if (len <= kMinSize)
+        return len;
+    const std::size_t n = len < kMaxSize ? len : kMaxSize;
+    const std::size_t normal = n < kAvgSize ? n : kAvgSize;
+    std::uint64_t fp = 0;
+    std::size_t i = kMinSize;
+    // Two bytes per step: the first byte uses the shifted table and mask, so
+    // both positions are tested without a dependent shift in between.
+    for (; i + 2 <= normal; i += 2)
+    {
+        fp = (fp << 2) + kTables.gearLs[data[i]];
+        if (!(fp & kMaskSLs))
+            return i + 1;
+        fp += kTables.gear[data[i + 1]];
+        if (!(fp & kMaskS))
+            return i + 2;
+    }
+    for (; i + 2 <= n; i += 2)
+    {
+        fp = (fp << 2) + kTables.gearLs[data[i]];
+        if (!(fp & kMaskLLs))
+            return i + 1;
+        fp += kTables.gear[data[i + 1]];
+        if (!(fp & kMaskL))
+            return i + 2;
+    }
+    return n;
+}
+
+ChunkIndex::ChunkIndex() : shards_(new Shard[kShards])
+{
+}
+
+ChunkIndex::~ChunkIndex() = default;
+
+bool ChunkIndex::insert(const ChunkKey& in)
+{
+    ChunkKey key = in;
+    if (key.lo == 0 && key.hi == 0)
+        key.hi = 1;
+    Shard& s = shards_[key.hi >> 58];
+    std::lock_guard<std::mutex> lk(s.mu);
+    if ((s.used + 1) * 10 > s.slots.size() * 7)
+    {
+        // Grow (and rehash) at 70% load.
+        std::vector<ChunkKey> old(s.slots.empty() ? 1024 : s.slots.size() * 2);
+        old.swap(s.slots);
+        const std::size_t mask = s.slots.size() - 1;
+        for (auto& k : old)
+        {
+            if (k.lo == 0 && k.hi == 0)
+                continue;
+            std::size_t at = k.lo & mask;
+            while (!(s.slots[at].lo == 0 && s.slots[at].hi == 0))
+                at = (at + 1) & mask;
+            s.slots[at] = k;
+        }
+    }
+    const std::size_t mask = s.slots.size() - 1;
+    for (std::size_t at = key.lo & mask;; at = (at + 1) & mask)
+    {
+        ChunkKey& slot = s.slots[at];
+        if (slot == key)
+            return false;
+        if (slot.lo == 0 && slot.hi == 0)
+        {
+            slot = key;
+            ++s.used;
+            return true;
+        }
+    }
+}
+
+std::size_t ChunkIndex::size() const
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < kShards; ++i)
+    {
+        std::lock_guard<std::mutex> lk(shards_[i].mu);
+        n += shards_[i].used;
+    }
+    return n;
+}
+
+}  // namespace rogue
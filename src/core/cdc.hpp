@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rogue
+{
+
+// 128-bit fingerprint of a chunk (fast, not cryptographic; collisions only
+// skew the duplicate estimate).
+struct ChunkKey
+{
+    std::uint64_t lo{0};
+    std::uint64_t hi{0};
+    bool operator==(const ChunkKey& o) const { return lo == o.lo && hi == o.hi; }
+};
+
+ChunkKey chunk_fingerprint(const std::uint8_t* data, std::size_t len);
+
+// FastCDC content-defined chunker: cut points depend only on nearby bytes,
+// so an insertion early in a file only changes the chunks around it.
+// Normalized chunking (a stricter mask before the average size, a looser
+// one after) keeps sizes close to the average; the gear hash skips the
+// first minSize bytes of each chunk and rolls two bytes per step.
+//
+// Streaming: feed() any block sizes, then finish(); each chunk is reported
+// once, in order, as onChunk(fingerprint, length).
+class CdcChunker
+{
+public:
+    static constexpr std::size_t kMinSize = 2 * 1024;
+    static constexpr std::size_t kAvgSize = 8 * 1024;
+    static constexpr std::size_t kMaxSize = 64 * 1024;
+
+    CdcChunker();
+
+    template <typename OnChunk>
+    void feed(const std::uint8_t* data, std::size_t len, OnChunk&& onChunk)
+    {
+        while (len)
+        {
+            const std::size_t room = buf_.size() - end_;
+            const std::size_t take = len < room ? len : room;
+            std::copy(data, data + take, buf_.data() + end_);
+            end_ += take;
+            data += take;
+            len -= take;
+            while (end_ - begin_ >= kMaxSize)
+                emit(find_cut(buf_.data() + begin_, end_ - begin_), onChunk);
+            if (buf_.size() - end_ < kMaxSize)
+                compact();
+        }
+    }
+
+    template <typename OnChunk>
+    void finish(OnChunk&& onChunk)
+    {
+        while (end_ > begin_)
+            emit(find_cut(buf_.data() + begin_, end_ - begin_), onChunk);
+        begin_ = end_ = 0;
+    }
+
+    void reset() { begin_ = end_ = 0; }
+
+    // Length of the first chunk of data[0, len).
+    static std::size_t find_cut(const std::uint8_t* data, std::size_t len);
+
+private:
+    template <typename OnChunk>
+    void emit(std::size_t cut, OnChunk& onChunk)
+    {
+        onChunk(chunk_fingerprint(buf_.data() + begin_, cut), cut);
+        begin_ += cut;
+    }
+    void compact();
+
+    std::vector<std::uint8_t> buf_;
+    std::size_t begin_{0};
+    std::size_t end_{0};
+};
+
+// Set of chunk fingerprints shared by the hashing threads: sharded by the
+// fingerprint's top bits, each shard an open-addressing table (16 bytes per
+// chunk, about 0.2% of the indexed data at the 8 KiB average).
+class ChunkIndex
+{
+public:
+    ChunkIndex();
+    ~ChunkIndex();
+
+    // True if the chunk had not been seen before.
+    bool insert(const ChunkKey& key);
+    std::size_t size() const;
+
+private:
+    struct Shard
+    {
+        mutable std::mutex mu;
+        std::vector<ChunkKey> slots;  // {0, 0} = empty
+        std::size_t used{0};
+    };
+    static constexpr std::size_t kShards = 64;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+}  // namespace rogue
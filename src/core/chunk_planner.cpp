@@ -0,0 +1,119 @@
+#include "chunk_planner.hpp"
+
+#include <algorithm>
+#include <map>
+#include <string_view>
+#include <unordered_map>
+
+namespace rogue
+{
+
+namespace
+{
+
+// Bytes a file is expected to add to a commit's pack. Chunks already seen
+// elsewhere in the workspace (ScanOptions::dedup) end up as deltas or
+// identical blobs, provided the file they were seen in is pushed first.
+std::uint64_t cost(const FileEntry& fe)
+{
+    return fe.hasDedup ? fe.size - fe.dupBytes : fe.size;
+}
+
+}  // namespace
+
+ChunkPlan plan_chunks(const std::vector<FileEntry>& files, const ChunkLimits& limits)
+{
+    ChunkPlan plan;
+    std::vector<std::size_t> order;
+    order.reserve(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        if (files[i].size > limits.maxFileBytes)
+            plan.skipped.push_back(i);
+        else
+            order.push_back(i);
+    }
+    // Biggest first, path as tie-break so the plan does not depend on scan order.
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        const std::uint64_t ca = cost(files[a]), cb = cost(files[b]);
+        if (ca != cb)
+            return ca > cb;
+        return files[a].path < files[b].path;
+    });
+
+    // Best fit: the open chunk with the least room that still takes the file.
+    // A file whose whole content a dedup scan saw in another file is the same
+    // blob: it joins that file's chunk at no cost, so it is never pushed
+    // before its copy. Which file a partial duplicate shares chunks with is
+    // not known, so pushes are bounded by full sizes (`upper`): the shared
+    // chunks may well be planned into a later push.
+    std::multimap<std::uint64_t, std::size_t> room;  // free bytes -> chunk
+    std::unordered_map<std::string_view, std::size_t> chunkOf;  // content hash -> chunk
+    std::vector<std::uint64_t> upper;
+    for (std::size_t i : order)
+    {
+        const FileEntry& fe = files[i];
+        const bool keyed = fe.hasDedup && !fe.hash.empty();
+        if (keyed)
+        {
+            auto same = chunkOf.find(fe.hash);
+            if (same != chunkOf.end())
+            {
+                plan.chunks[same->second].files.push_back(i);
+                continue;
+            }
+        }
+        const std::uint64_t size = cost(fe);
+        auto it = room.lower_bound(size);
+        std::size_t c;
+        if (it == room.end())
+        {
+            c = plan.chunks.size();
+            plan.chunks.emplace_back();
+            upper.push_back(0);
+        }
+        else
+        {
+            c = it->second;
+            room.erase(it);
+        }
+        Chunk& chunk = plan.chunks[c];
+        chunk.files.push_back(i);
+        chunk.bytes += size;
+        upper[c] += fe.size;
+        if (keyed)
+            chunkOf.emplace(fe.hash, c);
+        if (chunk.bytes < limits.chunkBytes)
+            room.emplace(limits.chunkBytes - chunk.bytes, c);
+    }
+
+    std::uint64_t pending = 0;
+    unsigned pendingChunks = 0;
+    for (std::size_t c = 0; c < plan.chunks.size(); ++c)
+    {
+        Chunk& chunk = plan.chunks[c];
+        std::sort(chunk.files.begin(), chunk.files.end(),
+                  [&](std::size_t a, std::size_t b) { return files[a].path < files[b].path; });
+        if (pendingChunks && pending + upper[c] > limits.pushBytes)
+        {
+            plan.chunks[c - 1].pushAfter = true;
+            pending = 0;
+            pendingChunks = 0;
+        }
+        pending += upper[c];
+        ++pendingChunks;
+        if (limits.pushEvery && pendingChunks >= limits.pushEvery)
+        {
+            chunk.pushAfter = true;
+            pending = 0;
+            pendingChunks = 0;
+        }
+    }
+    if (!plan.chunks.empty())
+        plan.chunks.back().pushAfter = true;
+    for (auto& chunk : plan.chunks)
+        plan.pushes += chunk.pushAfter ? 1 : 0;
+    return plan;
+}
+
+}  // namespace rogue
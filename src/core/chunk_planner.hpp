@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+struct ChunkLimits
+{
+    std::uint64_t chunkBytes{50ull << 20};    // content per commit (soft: a lone big file still fits)
+    std::uint64_t maxFileBytes{50ull << 20};  // larger files are left out
+    std::uint64_t pushBytes{1024ull << 20};   // content per push, so one pack stays under host limits
+    unsigned pushEvery{0};                    // chunks per push, 0 = only the byte limit
+};
+
+struct Chunk
+{
+    std::vector<std::size_t> files;  // indexes into the scanned list, sorted by path
+    std::uint64_t bytes{0};  // unique bytes when the scan measured duplicates
+    bool pushAfter{false};  // push once this chunk is committed
+};
+
+struct ChunkPlan
+{
+    std::vector<Chunk> chunks;
+    std::vector<std::size_t> skipped;  // over maxFileBytes
+    std::size_t pushes{0};
+};
+
+// Bin-packs the files into as few commits as possible under chunkBytes (best
+// fit by decreasing size, O(n log n)), then groups consecutive chunks into
+// pushes bounded by pushBytes and pushEvery. The last chunk always pushes.
+// Only indexes are kept, so the plan costs a few words per file. Files from a
+// dedup scan weigh their unique bytes in commits, and identical files share
+// one; pushes are bounded by full sizes, except for those identical files,
+// since the content a file shares may sit in a later push. maxFileBytes
+// still applies to the size.
+ChunkPlan plan_chunks(const std::vector<FileEntry>& files, const ChunkLimits& limits);
+
+}  // namespace rogue
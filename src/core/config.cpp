@@ -34,9 +34,20 @@ namespace rogue
                 out.repoName = val;
             else if (key == "private")
                 out.isPrivate = (val == "true" || val == "1");
+            else if (key == "mask_patterns")
+            {
+                std::stringstream ss(val);
+                std::string item;
+                while (std::getline(ss, item, ','))
+                {
+                    item = trim(item);
+                    if (!item.empty())
+                        out.maskPatterns.push_back(item);
+                }
+            }
         }
         if (logger)
-            logger->info("config", std::string("Loaded ") + path);
+            logger->info("config", "Loaded", LogField("path", path));
         return true;
     }
 
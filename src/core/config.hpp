@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <optional>
+#include <vector>
 
 namespace rogue
 {
@@ -10,6 +11,7 @@ namespace rogue
         std::string root;
         std::string repoName;
         bool isPrivate{true};
+        std::vector<std::string> maskPatterns; // mask_patterns = a, b, c (added to the built-in set)
     };
 
     class Logger;
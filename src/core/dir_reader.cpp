@@ -0,0 +1,193 @@
+#include "dir_reader.hpp"
+
+#include <filesystem>
+
+#include "utils.hpp"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+#if defined(__linux__)
+
+namespace
+{
+
+// Layout the kernel fills in for getdents64; glibc does not export it.
+struct LinuxDirent64
+{
+    std::uint64_t d_ino;
+    std::int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+DirEntryType from_d_type(unsigned char t)
+{
+    switch (t)
+    {
+        case DT_REG:
+            return DirEntryType::File;
+        case DT_DIR:
+            return DirEntryType::Dir;
+        case DT_LNK:
+            return DirEntryType::Symlink;
+        case DT_UNKNOWN:
+            return DirEntryType::Unknown;
+        default:
+            return DirEntryType::Other;
+    }
+}
+
+DirEntryType from_mode(unsigned mode)
+{
+    if (S_ISREG(mode))
+        return DirEntryType::File;
+    if (S_ISDIR(mode))
+        return DirEntryType::Dir;
+    if (S_ISLNK(mode))
+        return DirEntryType::Symlink;
+    return DirEntryType::Other;
+}
+
+}  // namespace
+
+DirReader::~DirReader() { close(); }
+
+void DirReader::close()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+bool DirReader::open(const std::string& path)
+{
+    close();
+    path_ = path;
+    fd_ = ::open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return fd_ >= 0;
+}
+
+bool DirReader::read_all(std::vector<DirEntry>& out)
+{
+    if (fd_ < 0)
+        return false;
+    if (buf_.empty())
+        buf_.resize(64 * 1024);
+    for (;;)
+    {
+        long n = ::syscall(SYS_getdents64, fd_, buf_.data(), buf_.size());
+        if (n < 0)
+            return false;
+        if (n == 0)
+            return true;
+        for (long off = 0; off < n;)
+        {
+            auto* d = reinterpret_cast<const LinuxDirent64*>(buf_.data() + off);
+            off += d->d_reclen;
+            const char* name = d->d_name;
+            if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))
+                continue;
+            out.push_back(DirEntry{name, from_d_type(d->d_type), d->d_ino});
+        }
+    }
+}
+
+bool DirReader::stat_file(const std::string& name, FileStat& out) const
+{
+#ifdef STATX_BASIC_STATS
+    struct statx sx;
+    const unsigned mask = STATX_TYPE | STATX_MODE | STATX_INO | STATX_SIZE | STATX_MTIME | STATX_CTIME | STATX_UID | STATX_GID;
+    if (::statx(fd_, name.c_str(), 0, mask, &sx) != 0 ||
+        !S_ISREG(sx.stx_mode))
+        return false;
+    out.dev = (std::uint64_t)makedev(sx.stx_dev_major, sx.stx_dev_minor);  // same value as st_dev
+    out.ino = sx.stx_ino;
+    out.size = sx.stx_size;
+    out.mtimeNs = std::int64_t(sx.stx_mtime.tv_sec) * 1000000000LL + sx.stx_mtime.tv_nsec;
+    out.ctimeNs = std::int64_t(sx.stx_ctime.tv_sec) * 1000000000LL + sx.stx_ctime.tv_nsec;
+    out.mode = sx.stx_mode;
+    out.uid = sx.stx_uid;
+    out.gid = sx.stx_gid;
+    return true;
+#else
+    struct stat st;
+    if (::fstatat(fd_, name.c_str(), &st, 0) != 0 || !S_ISREG(st.st_mode))
+        return false;
+    out.dev = (std::uint64_t)st.st_dev;
+    out.ino = (std::uint64_t)st.st_ino;
+    out.size = (std::uint64_t)st.st_size;
+    out.mtimeNs = (std::int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    out.ctimeNs = (std::int64_t)st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec;
+    out.mode = (std::uint32_t)st.st_mode;
+    out.uid = (std::uint32_t)st.st_uid;
+    out.gid = (std::uint32_t)st.st_gid;
+    return true;
+#endif
+}
+
+DirEntryType DirReader::resolve_type(const std::string& name) const
+{
+    struct stat st;
+    if (::fstatat(fd_, name.c_str(), &st, AT_SYMLINK_NOFOLLOW) != 0)
+        return DirEntryType::Other;
+    return from_mode(st.st_mode);
+}
+
+#else  // portable fallback
+
+DirReader::~DirReader() { close(); }
+
+void DirReader::close() {}
+
+bool DirReader::open(const std::string& path)
+{
+    path_ = path.empty() ? "." : path;
+    std::error_code ec;
+    return fs::is_directory(path_, ec);
+}
+
+bool DirReader::read_all(std::vector<DirEntry>& out)
+{
+    std::error_code ec;
+    fs::directory_iterator it(path_, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::directory_iterator(); it.increment(ec))
+        out.push_back(DirEntry{it->path().filename().string(), resolve_type(it->path().filename().string()), 0});
+    return !ec;
+}
+
+bool DirReader::stat_file(const std::string& name, FileStat& out) const
+{
+    return utils::stat_file((fs::path(path_) / name).string(), out);
+}
+
+DirEntryType DirReader::resolve_type(const std::string& name) const
+{
+    std::error_code ec;
+    auto st = fs::symlink_status(fs::path(path_) / name, ec);
+    if (ec)
+        return DirEntryType::Other;
+    if (fs::is_symlink(st))
+        return DirEntryType::Symlink;
+    if (fs::is_directory(st))
+        return DirEntryType::Dir;
+    if (fs::is_regular_file(st))
+        return DirEntryType::File;
+    return DirEntryType::Other;
+}
+
+#endif
+
+}  // namespace rogue
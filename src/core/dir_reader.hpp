@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "file_stat.hpp"
+
+namespace rogue
+{
+
+enum class DirEntryType : std::uint8_t
+{
+    Unknown,  // the filesystem did not say; call DirReader::resolve_type
+    File,
+    Dir,
+    Symlink,
+    Other
+};
+
+struct DirEntry
+{
+    std::string name;
+    DirEntryType type{DirEntryType::Unknown};
+    std::uint64_t ino{0};
+};
+
+// Lists one directory at a time; a reader is meant to be reused for many
+// directories by one thread.
+//
+// On Linux, entries come from getdents64 into a 64 KiB buffer with their
+// d_type and inode number, so telling files from directories costs no stat.
+// The directory stays open until the next open(), and stat_file() issues a
+// single statx relative to it asking only for the FileStat fields.
+// Elsewhere this falls back to std::filesystem.
+class DirReader
+{
+public:
+    DirReader() = default;
+    ~DirReader();
+    DirReader(const DirReader&) = delete;
+    DirReader& operator=(const DirReader&) = delete;
+
+    bool open(const std::string& path);
+    // Appends every entry except "." and "..". False on a read error.
+    bool read_all(std::vector<DirEntry>& out);
+    // Follows symlinks; false if name is missing or not a regular file.
+    bool stat_file(const std::string& name, FileStat& out) const;
+    // Does not follow symlinks. For entries reported as Unknown.
+    DirEntryType resolve_type(const std::string& name) const;
+
+private:
+    void close();
+
+    std::string path_;
+    int fd_{-1};
+    std::vector<char> buf_;
+};
+
+}  // namespace rogue
@@ -0,0 +1,226 @@
+#include "dupes.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+#include "logger.hpp"
+#include "sha256.hpp"
+#include "utils.hpp"
+
+namespace rogue
+{
+
+namespace
+{
+
+constexpr std::size_t kEdge = 4096;
+
+// Paths sharing one inode: identical without reading.
+struct Copy
+{
+    std::vector<std::size_t> files;
+    Sha256::Digest edge{};
+    std::string hash;  // full SHA-256 hex, from the scan or computed here
+    bool readable{true};
+};
+
+template <typename Fn>
+void parallel_for(std::size_t count, int threads, Fn fn)
+{
+    std::size_t n = threads > 0 ? std::size_t(threads) : std::max(1u, std::thread::hardware_concurrency());
+    n = std::min(n, count);
+    std::atomic<std::size_t> next{0};
+    auto work = [&]
+    {
+        for (std::size_t i; (i = next.fetch_add(1)) < count;)
+            fn(i);
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < n; ++i)
+        pool.emplace_back(work);
+    if (count)
+        work();
+    for (auto& t : pool)
+        t.join();
+}
+
+// SHA-256 of the first and last kEdge bytes; up to 2 * kEdge bytes this is
+// the whole file, so the digest is the file's SHA-256.
+bool edge_digest(const std::string& path, std::uintmax_t size, Sha256::Digest& out)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    char buf[2 * kEdge];
+    const std::size_t head = std::size_t(std::min<std::uintmax_t>(size, kEdge));
+    const std::size_t tail = std::size_t(std::min<std::uintmax_t>(size - head, kEdge));
+    if (!in.read(buf, std::streamsize(head)))
+        return false;
+    if (tail && (!in.seekg(std::streamoff(size - tail)) || !in.read(buf + head, std::streamsize(tail))))
+        return false;
+    Sha256 h;
+    h.update(buf, head + tail);
+    out = h.finish();
+    return true;
+}
+
+}  // namespace
+
+DupeReport find_duplicates(const std::string& root, const std::vector<FileEntry>& files, Logger& logger,
+                           std::uintmax_t minSize, int threads)
+{
+    DupeReport report;
+    const std::string prefix = root.empty() || root.back() == '/' ? root : root + "/";
+
+    // Size buckets, then hardlinks within each bucket.
+    std::unordered_map<std::uintmax_t, std::vector<std::size_t>> bySize;
+    for (std::size_t i = 0; i < files.size(); ++i)
+        if (files[i].size >= minSize)
+            bySize[files[i].size].push_back(i);
+    std::vector<Copy> copies;
+    std::vector<std::vector<std::size_t>> buckets;  // copy indexes
+    for (auto& [size, idx] : bySize)
+    {
+        if (idx.size() < 2)
+            continue;
+        std::vector<std::size_t> bucket;
+        std::map<std::pair<std::uint64_t, std::uint64_t>, std::size_t> inodes;
+        for (std::size_t i : idx)
+        {
+            const FileStat& st = files[i].stat;
+            if (st.ino)
+            {
+                auto it = inodes.find({st.dev, st.ino});
+                if (it != inodes.end())
+                {
+                    copies[it->second].files.push_back(i);
+                    continue;
+                }
+                inodes.emplace(std::make_pair(st.dev, st.ino), copies.size());
+            }
+            bucket.push_back(copies.size());
+            copies.emplace_back();
+            copies.back().files.push_back(i);
+            copies.back().hash = files[i].hash;
+        }
+        buckets.push_back(std::move(bucket));
+    }
+
+    // Head and tail of every copy in a bucket with more than one copy,
+    // unless the scan already hashed them all.
+    std::vector<std::size_t> toRead;
+    for (auto& bucket : buckets)
+    {
+        if (bucket.size() < 2)
+            continue;
+        const bool known = std::all_of(bucket.begin(), bucket.end(), [&](std::size_t c) { return !copies[c].hash.empty(); });
+        if (!known)
+            toRead.insert(toRead.end(), bucket.begin(), bucket.end());
+    }
+    parallel_for(toRead.size(), threads, [&](std::size_t k)
+    {
+        Copy& c = copies[toRead[k]];
+        const FileEntry& fe = files[c.files.front()];
+        c.readable = edge_digest(prefix + fe.path, fe.size, c.edge);
+        if (c.readable && fe.size <= 2 * kEdge)
+            c.hash = Sha256::to_hex(c.edge);
+    });
+    report.partialReads = toRead.size();
+
+    // Copies whose edges match another copy's are hashed in full.
+    std::vector<std::vector<std::size_t>> candidates;
+    toRead.clear();
+    for (auto& bucket : buckets)
+    {
+        std::map<Sha256::Digest, std::vector<std::size_t>> byEdge;
+        for (std::size_t c : bucket)
+            if (copies[c].readable)
+                byEdge[copies[c].edge].push_back(c);
+        for (auto& [edge, group] : byEdge)
+        {
+            if (group.size() < 2 && copies[group.front()].files.size() < 2)
+                continue;
+            for (std::size_t c : group)
+                if (group.size() > 1 && copies[c].hash.empty())
+                    toRead.push_back(c);
+            candidates.push_back(std::move(group));
+        }
+    }
+    parallel_for(toRead.size(), threads, [&](std::size_t k)
+    {
+        Copy& c = copies[toRead[k]];
+        c.hash = utils::sha256_file(prefix + files[c.files.front()].path);
+        c.readable = !c.hash.empty();
+    });
+    report.fullReads = toRead.size();
+
+    for (std::size_t c = 0; c < copies.size(); ++c)
+        if (!copies[c].readable)
+            logger.warn("dupes", "cannot read file", LogField("path", files[copies[c].files.front()].path));
+
+    for (auto& group : candidates)
+    {
+        std::map<std::string, std::vector<std::size_t>> byHash;
+        for (std::size_t c : group)
+            if (copies[c].readable)
+                byHash[copies[c].hash].push_back(c);
+        for (auto& [hash, same] : byHash)
+        {
+            DupeGroup g;
+            g.hash = hash;
+            g.copies = same.size();
+            for (std::size_t c : same)
+                g.files.insert(g.files.end(), copies[c].files.begin(), copies[c].files.end());
+            if (g.files.size() < 2)
+                continue;
+            std::sort(g.files.begin(), g.files.end(),
+                      [&](std::size_t a, std::size_t b) { return files[a].path < files[b].path; });
+            g.size = files[g.files.front()].size;
+            report.wastedBytes += g.size * (g.copies - 1);
+            report.groups.push_back(std::move(g));
+        }
+    }
+    std::sort(report.groups.begin(), report.groups.end(), [&](const DupeGroup& a, const DupeGroup& b) {
+        const std::uintmax_t wa = a.size * (a.copies - 1), wb = b.size * (b.copies - 1);
+        if (wa != wb)
+            return wa > wb;
+        return files[a.files.front()].path < files[b.files.front()].path;
+    });
+    logger.info("dupes", "done", LogField("groups", report.groups.size()), LogField("wasted_bytes", report.wastedBytes),
+                LogField("partial_reads", report.partialReads), LogField("full_reads", report.fullReads));
+    return report;
+}
+
+std::string dupe_report_json(const DupeReport& report, const std::vector<FileEntry>& files)
+{
+    std::string out = "{\"duplicate_groups\":" + std::to_string(report.groups.size()) + ",\"groups\":[";
+    for (std::size_t i = 0; i < report.groups.size(); ++i)
+    {
+        const DupeGroup& g = report.groups[i];
+        out += i ? ",{\"copies\":" : "{\"copies\":";
+        out += std::to_string(g.copies);
+        if (!g.hash.empty())
+        {
+            out += ",\"hash\":";
+            utils::append_json_string(out, g.hash);
+        }
+        out += ",\"paths\":[";
+        for (std::size_t j = 0; j < g.files.size(); ++j)
+        {
+            if (j)
+                out += ',';
+            utils::append_json_string(out, files[g.files[j]].path);
+        }
+        out += "],\"size\":";
+        out += std::to_string(g.size);
+        out += '}';
+    }
+    out += "],\"wasted_bytes\":" + std::to_string(report.wastedBytes) + "}";
+    return out;
+}
+
+}  // namespace rogue
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+class Logger;
+
+struct DupeGroup
+{
+    std::uintmax_t size{0};
+    std::string hash;                // SHA-256 hex; empty for hardlinks that were never read
+    std::vector<std::size_t> files;  // indexes into the scanned list, sorted by path
+    std::size_t copies{0};           // distinct inodes (hardlinks share one)
+};
+
+struct DupeReport
+{
+    std::vector<DupeGroup> groups;  // most wasted bytes first
+    std::uintmax_t wastedBytes{0};  // size x (copies - 1), summed
+    std::size_t partialReads{0};    // files whose head and tail were read
+    std::size_t fullReads{0};       // files hashed in full
+};
+
+// Identical files among `files` (a scan of `root`, hashes optional), reading
+// as little as possible: files are bucketed by size; paths sharing a device
+// and inode collapse without any read; within a bucket only the first and
+// last 4 KiB are compared (which is the whole file up to 8 KiB); only files
+// that still match are hashed in full, unless the scan already has their
+// SHA-256. Files under minSize are ignored.
+DupeReport find_duplicates(const std::string& root, const std::vector<FileEntry>& files, Logger& logger,
+                           std::uintmax_t minSize = 1, int threads = 0);
+
+// {"duplicate_groups":N,"groups":[{"copies":..,"hash":..,"paths":[..],"size":..}],"wasted_bytes":N}
+std::string dupe_report_json(const DupeReport& report, const std::vector<FileEntry>& files);
+
+}  // namespace rogue
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace rogue
+{
+
+// The subset of stat(2) the scanner relies on. dev/ino are 0 on platforms
+// without stable inode numbers. dev/ino/size/mtimeNs identify unchanged
+// content (scan cache); the rest is only carried for the git index.
+struct FileStat
+{
+    std::uint64_t dev{};
+    std::uint64_t ino{};
+    std::uint64_t size{};
+    std::int64_t mtimeNs{};
+    std::int64_t ctimeNs{};
+    std::uint32_t mode{};
+    std::uint32_t uid{};
+    std::uint32_t gid{};
+};
+
+namespace utils
+{
+// Follows symlinks, like std::filesystem::is_regular_file. Returns false if
+// the path is missing or not a regular file.
+bool stat_file(const std::string& path, FileStat& out);
+}  // namespace utils
+
+}  // namespace rogue
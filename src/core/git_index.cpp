@@ -0,0 +1,89 @@
+#include "git_index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+#include "sha1.hpp"
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+void put_be32(std::string& out, std::uint32_t v)
+{
+    out.push_back(char(v >> 24));
+    out.push_back(char(v >> 16));
+    out.push_back(char(v >> 8));
+    out.push_back(char(v));
+}
+
+void put_time(std::string& out, std::int64_t ns)
+{
+    const std::int64_t sec = ns / 1000000000LL - (ns % 1000000000LL < 0 ? 1 : 0);
+    put_be32(out, std::uint32_t(sec));
+    put_be32(out, std::uint32_t(ns - sec * 1000000000LL));
+}
+
+}  // namespace
+
+bool write_git_index(const std::string& indexPath, std::vector<IndexEntry> entries)
+{
+    std::sort(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.path < b.path; });
+
+    std::string buf;
+    buf.reserve(64 + entries.size() * 96);
+    buf += "DIRC";
+    put_be32(buf, 2);
+    put_be32(buf, std::uint32_t(entries.size()));
+    for (auto& e : entries)
+    {
+        const std::size_t start = buf.size();
+        put_time(buf, e.stat.ctimeNs);
+        put_time(buf, e.stat.mtimeNs);
+        // git keeps the low 32 bits of these and only compares those.
+        put_be32(buf, std::uint32_t(e.stat.dev));
+        put_be32(buf, std::uint32_t(e.stat.ino));
+        if ((e.stat.mode & 0170000) == 0120000)
+            put_be32(buf, 0120000);
+        else
+            put_be32(buf, (e.stat.mode & 0100) ? 0100755 : 0100644);
+        put_be32(buf, e.stat.uid);
+        put_be32(buf, e.stat.gid);
+        put_be32(buf, std::uint32_t(e.stat.size));
+        buf.append(reinterpret_cast<const char*>(e.oid.data()), e.oid.size());
+        const std::size_t nameLen = std::min<std::size_t>(e.path.size(), 0xFFF);
+        buf.push_back(char(nameLen >> 8));
+        buf.push_back(char(nameLen));
+        buf += e.path;
+        // NUL-terminated and padded to a multiple of 8 bytes.
+        const std::size_t len = buf.size() - start;
+        buf.append(8 - len % 8, '\0');
+    }
+    Sha1 sum;
+    sum.update(buf.data(), buf.size());
+    const auto digest = sum.finish();
+    buf.append(reinterpret_cast<const char*>(digest.data()), digest.size());
+
+    const std::string lock = indexPath + ".lock";
+    std::FILE* f = std::fopen(lock.c_str(), "wbx");  // fails if git holds the lock
+    if (!f)
+        return false;
+    bool ok = std::fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    ok = std::fclose(f) == 0 && ok;
+    std::error_code ec;
+    if (ok)
+        fs::rename(lock, indexPath, ec);
+    if (!ok || ec)
+    {
+        fs::remove(lock, ec);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace rogue
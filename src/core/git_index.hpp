@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "file_stat.hpp"
+#include "pack_writer.hpp"
+
+namespace rogue
+{
+
+struct IndexEntry
+{
+    std::string path;  // '/'-separated, relative to the work tree
+    ObjectId oid;
+    FileStat stat;     // as seen when oid was computed
+};
+
+// Replaces the git index at indexPath with a version 2 index holding exactly
+// these entries (stage 0, any order), taking the lock file the way git does.
+// With the stat data of the read that produced each id, git treats the
+// entries as clean without re-hashing them. Existing extensions are dropped.
+bool write_git_index(const std::string& indexPath, std::vector<IndexEntry> entries);
+
+}  // namespace rogue
@@ -1,10 +1,11 @@
 #include "github_api.hpp"
 #include "logger.hpp"
+#include "process.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
 #ifdef HAVE_LIBCURL
 #include <curl/curl.h>
 #endif
-#include <sstream>
 
 namespace rogue
 {
@@ -41,9 +42,15 @@ namespace rogue
                          {
         (void)userdata; return size*nmemb; });
 
-        auto res = curl_easy_perform(curl);
+        CURLcode res;
         long code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+        {
+            ProfileScope scope(Phase::Http);
+            if (scope.active())
+                scope.set_detail("POST " + url);
+            res = curl_easy_perform(curl);
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &code);
+        }
         curl_slist_free_all(headers);
         curl_easy_cleanup(curl);
         if (res != CURLE_OK || code >= 300)
@@ -58,39 +65,22 @@ namespace rogue
 
     bool GitHubApi::create_repo_via_gh(const std::filesystem::path &workdir, const std::string &repoName, const std::string &org, bool isPrivate)
     {
+        const std::string fullName = org.empty() ? repoName : org + "/" + repoName;
+        ProcessOptions opts;
+        opts.cwd = workdir.string();
+        opts.stdoutMode = ProcessOutput::Discard;
+
         // If repo already exists, skip creation
+        if (run_process({"gh", "repo", "view", fullName}, opts).ok())
         {
-            std::ostringstream check;
-#ifdef _WIN32
-            check << "cmd /c gh repo view ";
-#else
-            check << "gh repo view ";
-#endif
-            if (!org.empty())
-                check << org << "/";
-            check << repoName;
-            int exists = utils::system_in_dir(workdir.string(), check.str(), true);
-            if (exists == 0)
-            {
-                logger_.info("github", "Repo already exists on GitHub; skipping creation");
-                return true;
-            }
+            logger_.info("github", "Repo already exists on GitHub; skipping creation");
+            return true;
         }
 
-        std::ostringstream cmd;
-#ifdef _WIN32
-        cmd << "cmd /c gh repo create ";
-#else
-        cmd << "gh repo create ";
-#endif
-        if (!org.empty())
-            cmd << org << "/";
-        cmd << repoName << " --confirm ";
-        cmd << (isPrivate ? "--private" : "--public");
-        int code = utils::system_in_dir(workdir.string(), cmd.str(), true);
-        if (code != 0)
+        ProcessResult r = run_process({"gh", "repo", "create", fullName, "--confirm", isPrivate ? "--private" : "--public"}, opts);
+        if (!r.ok())
         {
-            logger_.error("github", "gh repo create failed", {{"code", std::to_string(code)}});
+            logger_.error("github", "gh repo create failed", LogField("code", r.exitCode), LogField("stderr", r.err));
             return false;
         }
         logger_.info("github", "Repo created via gh CLI");
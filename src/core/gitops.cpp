@@ -1,11 +1,25 @@
 #include "gitops.hpp"
 
-#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
+#include "git_index.hpp"
 #include "logger.hpp"
+#include "object_store.hpp"
+#include "pack_writer.hpp"
+#include "process.hpp"
+#include "profiler.hpp"
+#include "scanner.hpp"
 #include "utils.hpp"
 
 namespace fs = std::filesystem;
@@ -13,21 +27,91 @@ namespace fs = std::filesystem;
 namespace rogue
 {
 
+namespace
+{
+
+std::vector<std::string> git_argv(const std::string& root, const std::vector<std::string>& args)
+{
+    std::vector<std::string> argv{"git", "-C", root};
+    argv.insert(argv.end(), args.begin(), args.end());
+    return argv;
+}
+
+// True if path is a symbolic link; fills in its lstat data and target, which
+// git stores as a mode 120000 blob instead of the contents it points to.
+bool read_symlink(const std::string& path, FileStat& st, std::string& target)
+{
+#ifdef _WIN32
+    (void)path;
+    (void)st;
+    (void)target;
+    return false;
+#else
+    struct stat ls;
+    if (::lstat(path.c_str(), &ls) != 0 || !S_ISLNK(ls.st_mode))
+        return false;
+    st.dev = (std::uint64_t)ls.st_dev;
+    st.ino = (std::uint64_t)ls.st_ino;
+    st.size = (std::uint64_t)ls.st_size;
+    st.mtimeNs = (std::int64_t)ls.st_mtim.tv_sec * 1000000000LL + ls.st_mtim.tv_nsec;
+    st.ctimeNs = (std::int64_t)ls.st_ctim.tv_sec * 1000000000LL + ls.st_ctim.tv_nsec;
+    st.mode = (std::uint32_t)ls.st_mode;
+    st.uid = (std::uint32_t)ls.st_uid;
+    st.gid = (std::uint32_t)ls.st_gid;
+    // st_size is 0 for some pseudo file systems: grow until the target fits.
+    target.resize(std::max<std::size_t>(ls.st_size, 255) + 1);
+    for (;;)
+    {
+        const ssize_t n = ::readlink(path.c_str(), &target[0], target.size());
+        if (n < 0)
+            return false;
+        if (std::size_t(n) < target.size())
+        {
+            target.resize(std::size_t(n));
+            return true;
+        }
+        target.resize(target.size() * 2);
+    }
+#endif
+}
+
+}  // namespace
+
 bool GitOps::run_git(const std::string& root, const std::vector<std::string>& args,
-                     bool hide_output)
+                     bool hide_output, const std::string& input)
 {
-    std::ostringstream cmd;
-    cmd << "git -C \"" << root << "\"";
-    for (auto& a : args)
+    const auto argv = git_argv(root, args);
+    logger_.info("git", "exec", LogField("cmd", describe_command(argv)));
+    ProcessOptions opts;
+    opts.stdoutMode = hide_output ? ProcessOutput::Discard : ProcessOutput::Inherit;
+    opts.stderrMode = hide_output ? ProcessOutput::Capture : ProcessOutput::Inherit;
+    opts.input = input;
+    const ProcessResult r = run_process(argv, opts);
+    if (!r.started)
+        logger_.error("git", "cannot start git", LogField("error", r.error));
+    else if (r.signal)
+        logger_.error("git", "killed by signal", LogField("signal", r.signal));
+    else if (r.exitCode != 0)
     {
-        cmd << ' ' << a;
+        if (hide_output)
+            logger_.debug("git", "non-zero exit", LogField("code", r.exitCode), LogField("stderr", r.err));
+        else
+            logger_.error("git", "non-zero exit", LogField("code", r.exitCode));
     }
-    std::string full = cmd.str();
-    logger_.info("git", std::string("exec: ") + full);
-    int code = system(full.c_str());
-    if (code != 0)
-        logger_.error("git", "non-zero exit", {{"code", std::to_string(code)}});
-    return code == 0;
+    return r.ok();
+}
+
+std::string GitOps::capture_git(const std::string& root, const std::vector<std::string>& args)
+{
+    ProcessOptions opts;
+    opts.stderrMode = ProcessOutput::Discard;
+    ProcessResult r = run_process(git_argv(root, args), opts);
+    if (!r.ok())
+        return std::string();
+    std::string out = std::move(r.out);
+    while (!out.empty() && (out.back() == '\n' || out.back() == '\r'))
+        out.pop_back();
+    return out;
 }
 
 bool GitOps::ensure_repo_initialized(const std::string& root)
@@ -92,20 +176,17 @@ bool GitOps::add_remote_and_fetch(const std::string& root, const std::string& re
         if (owner.empty())
         {
             // Use gh CLI to get authenticated user
-            std::string tmpfile = (std::filesystem::path(root) / "owner_tmp.txt").string();
-            std::string cmd = "gh api user --jq .login > \"" + tmpfile + "\"";
-            int code = std::system(cmd.c_str());
-            (void)code;
-            std::ifstream f(tmpfile);
-            if (f)
+            ProcessOptions opts;
+            opts.stderrMode = ProcessOutput::Discard;
+            opts.timeoutMs = 30000;
+            const ProcessResult r = run_process({"gh", "api", "user", "--jq", ".login"}, opts);
+            if (r.ok())
             {
-                std::getline(f, owner);
+                owner = r.out;
                 // Trim whitespace
                 owner.erase(0, owner.find_first_not_of(" \t\n\r"));
                 owner.erase(owner.find_last_not_of(" \t\n\r") + 1);
             }
-            std::error_code ec;
-            std::filesystem::remove(tmpfile, ec);
         }
     }
     if (owner.empty())
@@ -141,18 +222,371 @@ bool GitOps::stage_all(const std::string& root)
     return run_git(root, {"add", "-A"});
 }
 
-bool GitOps::commit(const std::string& root, const std::string& message)
+namespace
+{
+
+std::string nul_separated(const std::vector<std::string>& paths)
+{
+    std::string list;
+    for (auto& p : paths)
+    {
+        list += p;
+        list += '\0';
+    }
+    return list;
+}
+
+// Inverse of nul_separated, for git's -z output; views into `out`.
+std::vector<std::string_view> split_nul(const std::string& out)
+{
+    std::vector<std::string_view> items;
+    for (std::size_t pos = 0; pos < out.size();)
+    {
+        std::size_t end = out.find('\0', pos);
+        if (end == std::string::npos)
+            end = out.size();
+        items.emplace_back(out.data() + pos, end - pos);
+        pos = end + 1;
+    }
+    return items;
+}
+
+}  // namespace
+
+bool GitOps::stage_paths(const std::string& root, const std::vector<std::string>& paths)
+{
+    if (paths.empty())
+        return true;
+    return run_git(root, {"--literal-pathspecs", "add", "--pathspec-from-file=-", "--pathspec-file-nul"}, false,
+                   nul_separated(paths));
+}
+
+bool GitOps::drop_ignored(const std::string& root, std::vector<FileEntry>& files)
 {
+    if (files.empty())
+        return true;
+    std::vector<std::string> paths;
+    paths.reserve(files.size());
+    for (auto& f : files)
+        paths.push_back(f.path);
+    ProcessOptions opts;
+    opts.stderrMode = ProcessOutput::Capture;
+    opts.input = nul_separated(paths);
+    const ProcessResult r = run_process(git_argv(root, {"check-ignore", "--stdin", "-z"}), opts);
+    // Exit 1: nothing is ignored.
+    if (!r.started || r.signal || r.timedOut || (r.exitCode != 0 && r.exitCode != 1))
+    {
+        logger_.error("git", "check-ignore failed", LogField("code", r.exitCode), LogField("stderr", r.err));
+        return false;
+    }
+    std::vector<std::string_view> ignored = split_nul(r.out);
+    if (ignored.empty())
+        return true;
+    std::sort(ignored.begin(), ignored.end());
+    const std::size_t before = files.size();
+    files.erase(std::remove_if(files.begin(), files.end(), [&](const FileEntry& f)
+                               { return std::binary_search(ignored.begin(), ignored.end(), std::string_view(f.path)); }),
+                files.end());
+    logger_.info("git", "ignored by .gitignore", LogField("files", before - files.size()));
+    return true;
+}
+
+bool GitOps::stage_deletions(const std::string& root)
+{
+    ProcessOptions opts;
+    opts.stderrMode = ProcessOutput::Capture;
+    const ProcessResult r = run_process(git_argv(root, {"ls-files", "--deleted", "-z"}), opts);
+    if (!r.ok())
+    {
+        logger_.error("git", "ls-files failed", LogField("code", r.exitCode), LogField("stderr", r.err));
+        return false;
+    }
+    std::vector<std::string> gone;
+    for (std::string_view p : split_nul(r.out))
+        gone.emplace_back(p);
+    if (gone.empty())
+        return true;
+    logger_.info("git", "staging deletions", LogField("files", gone.size()));
+    return remove_paths(root, gone);
+}
+
+bool GitOps::remove_paths(const std::string& root, const std::vector<std::string>& paths)
+{
+    if (paths.empty())
+        return true;
+    return run_git(root, {"--literal-pathspecs", "rm", "--cached", "-q", "--ignore-unmatch", "--pathspec-from-file=-", "--pathspec-file-nul"},
+                   false, nul_separated(paths));
+}
+
+CommitResult GitOps::commit(const std::string& root, const std::string& message)
+{
+    // Index identical to HEAD (or empty before the first commit): git would
+    // refuse, and that is not an error.
+    ProcessOptions quiet;
+    quiet.stdoutMode = ProcessOutput::Discard;
+    quiet.stderrMode = ProcessOutput::Discard;
+    if (run_process(git_argv(root, {"diff", "--cached", "--quiet"}), quiet).ok())
+    {
+        logger_.info("git", "nothing to commit");
+        return CommitResult::Unchanged;
+    }
+
     // Ensure git user config is set (for Docker environments)
     std::string user_name = utils::getenv("GIT_USER_NAME", "RogueMagicBox");
     std::string user_email = utils::getenv("GIT_USER_EMAIL", "roguebox@workshop.local");
 
-    run_git(root, {"config", "user.name", "\"" + user_name + "\""}, true);
-    run_git(root, {"config", "user.email", "\"" + user_email + "\""}, true);
+    run_git(root, {"config", "user.name", user_name}, true);
+    run_git(root, {"config", "user.email", user_email}, true);
+
+    return run_git(root, {"commit", "-m", message}) ? CommitResult::Created : CommitResult::Failed;
+}
+
+namespace
+{
+
+// "Name <email> <epoch> <+hhmm>" for the author and committer lines.
+std::string signature()
+{
+    std::string name = utils::getenv("GIT_USER_NAME", "RogueMagicBox");
+    std::string email = utils::getenv("GIT_USER_EMAIL", "roguebox@workshop.local");
+    std::time_t now = std::time(nullptr);
+    long offset = 0;
+#ifndef _WIN32
+    std::tm lt{};
+    localtime_r(&now, &lt);
+    offset = lt.tm_gmtoff / 60;
+#endif
+    // Room for any long, so the format cannot truncate; real offsets are +-1400.
+    char tz[32];
+    std::snprintf(tz, sizeof(tz), "%c%02ld%02ld", offset < 0 ? '-' : '+', std::labs(offset) / 60, std::labs(offset) % 60);
+    return name + " <" + email + "> " + std::to_string((long long)now) + " " + tz;
+}
+
+}  // namespace
 
-    // Use double quotes for Windows/cmd safety
-    std::string quoted = std::string("\"") + message + "\"";
-    return run_git(root, {"commit", "-m", quoted});
+std::string GitOps::git_path(const std::string& root, const std::string& what)
+{
+    std::string p = capture_git(root, {"rev-parse", "--git-path", what});
+    if (!p.empty() && fs::path(p).is_relative())
+        p = (fs::path(root) / p).string();
+    return p;
+}
+
+bool GitOps::collect_blobs(const std::string& root, const std::vector<FileEntry>& files, PackWriter& pack,
+                           int threads, std::vector<TreeFile>& out, std::size_t& readCount)
+{
+    // Ids from the scan are trusted when the object already exists; the rest
+    // are read, hashed and deflated by the workers, and only the append to
+    // the pack is shared.
+    const ObjectStore store(git_path(root, "objects"));
+    out.assign(files.size(), TreeFile{});
+    std::atomic<std::size_t> next{0}, reads{0};
+    std::atomic<bool> failed{false};
+    const std::string prefix = root.empty() || root.back() == '/' ? root : root + "/";
+    auto work = [&]
+    {
+        for (std::size_t i; !failed.load(std::memory_order_relaxed) && (i = next.fetch_add(1)) < files.size();)
+        {
+            const auto& f = files[i];
+            out[i].path = f.path;
+            // The scan follows links; git stores the link itself.
+            FileStat linkStat;
+            std::string target;
+            if (read_symlink(prefix + f.path, linkStat, target))
+            {
+                out[i].oid = pack.add(ObjectType::Blob, target.data(), target.size());
+                out[i].symlink = true;
+                continue;
+            }
+            if (f.hasGitOid && store.has(f.gitOid))
+            {
+                out[i].oid = f.gitOid;
+                out[i].executable = (f.stat.mode & 0100) != 0;
+                continue;
+            }
+            reads.fetch_add(1, std::memory_order_relaxed);
+            if (!pack.add_file(prefix + f.path, out[i].oid, out[i].executable))
+            {
+                logger_.error("git", "cannot read file", LogField("path", f.path));
+                failed.store(true);
+            }
+        }
+    };
+    std::size_t n = threads > 0 ? std::size_t(threads) : std::max(1u, std::thread::hardware_concurrency());
+    n = std::min(n, std::max<std::size_t>(1, files.size()));
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < n; ++i)
+        pool.emplace_back(work);
+    work();
+    for (auto& t : pool)
+        t.join();
+    readCount = reads.load();
+    return !failed.load();
+}
+
+bool GitOps::tracked_skipped(const std::string& root, const std::vector<FileEntry>& files, bool fromIndex,
+                             std::vector<TreeFile>& out)
+{
+    ProcessOptions opts;
+    opts.stderrMode = ProcessOutput::Capture;
+    const ProcessResult r = run_process(git_argv(root, fromIndex ? std::vector<std::string>{"ls-files", "-s", "-z"}
+                                                                 : std::vector<std::string>{"ls-tree", "-r", "-z", "--full-tree", "HEAD"}),
+                                        opts);
+    if (!r.ok())
+    {
+        logger_.error("git", fromIndex ? "ls-files failed" : "ls-tree failed", LogField("code", r.exitCode), LogField("stderr", r.err));
+        return false;
+    }
+    std::unordered_set<std::string_view> scanned;
+    scanned.reserve(files.size());
+    for (auto& f : files)
+        scanned.insert(f.path);
+    const std::string prefix = root.empty() || root.back() == '/' ? root : root + "/";
+    std::size_t kept = 0;
+    // ls-tree: "<mode> <type> <oid>\t<path>"; ls-files: "<mode> <oid> <stage>\t<path>"
+    for (std::string_view line : split_nul(r.out))
+    {
+        const std::size_t tab = line.find('\t');
+        if (tab == std::string_view::npos || tab < 48)
+            continue;
+        const std::string_view oid = fromIndex ? line.substr(line.find(' ') + 1, 40) : line.substr(tab - 40, 40);
+        const std::string_view path = line.substr(tab + 1);
+        std::error_code ec;
+        if (scanned.count(path) || !fs::exists(fs::symlink_status(prefix + std::string(path), ec)))
+            continue;
+        const std::string_view mode = line.substr(0, line.find(' '));
+        TreeFile t;
+        if (mode == "160000" || (fromIndex && line[tab - 1] != '0') || !Sha1::from_hex(std::string(oid), t.oid))
+        {
+            logger_.warn("git", "tracked entry not carried over; it is dropped", LogField("path", path), LogField("mode", mode));
+            continue;
+        }
+        t.path.assign(path);
+        t.executable = mode == "100755";
+        t.symlink = mode == "120000";
+        out.push_back(std::move(t));
+        ++kept;
+    }
+    if (kept)
+        logger_.info("git", "tracked files outside the scan kept as committed", LogField("files", kept));
+    return true;
+}
+
+bool GitOps::write_index(const std::string& root, const std::vector<FileEntry>& files,
+                         const std::vector<TreeFile>& blobs)
+{
+    std::vector<IndexEntry> entries(blobs.size());
+    const std::string prefix = root.empty() || root.back() == '/' ? root : root + "/";
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        entries[i] = IndexEntry{files[i].path, blobs[i].oid, files[i].stat};
+        std::string target;
+        if (blobs[i].symlink && !read_symlink(prefix + files[i].path, entries[i].stat, target))
+            entries[i].stat.mode = 0120000;  // replaced meanwhile: git re-checks it
+    }
+    // Entries past the scanned files were not looked at: no stat data, so git
+    // compares their contents before calling them clean.
+    for (std::size_t i = files.size(); i < blobs.size(); ++i)
+    {
+        entries[i] = IndexEntry{blobs[i].path, blobs[i].oid, FileStat{}};
+        entries[i].stat.mode = blobs[i].symlink ? 0120000 : blobs[i].executable ? 0100755 : 0100644;
+    }
+    const std::string indexPath = git_path(root, "index");
+    if (indexPath.empty() || !write_git_index(indexPath, std::move(entries)))
+    {
+        logger_.error("git", "cannot write index (is another git process running?)", LogField("path", indexPath));
+        return false;
+    }
+    return true;
+}
+
+bool GitOps::stage_files(const std::string& root, const std::vector<FileEntry>& files, int threads)
+{
+    ProfileScope scope(Phase::Git, "stage_files");
+    const std::string packDir = git_path(root, "objects/pack");
+    if (packDir.empty())
+    {
+        logger_.error("git", "not a git repository", LogField("root", root));
+        return false;
+    }
+    PackWriter pack(packDir);
+    std::vector<TreeFile> blobs;
+    std::size_t reads = 0;
+    if (!pack.ok() || !collect_blobs(root, files, pack, threads, blobs, reads))
+        return false;
+    if (pack.object_count() && !pack.finish())
+    {
+        logger_.error("git", "cannot write pack", LogField("dir", packDir));
+        return false;
+    }
+    // Index entries the scan filtered out stay staged as they are.
+    if (!tracked_skipped(root, files, true, blobs) || !write_index(root, files, blobs))
+        return false;
+    logger_.info("git", "staged", LogField("files", files.size()), LogField("read", reads));
+    return true;
+}
+
+CommitResult GitOps::commit_files(const std::string& root, const std::vector<FileEntry>& files,
+                                  const std::string& message, int threads)
+{
+    ProfileScope scope(Phase::Git, "commit_files");
+    const std::string packDir = git_path(root, "objects/pack");
+    if (packDir.empty())
+    {
+        logger_.error("git", "not a git repository", LogField("root", root));
+        return CommitResult::Failed;
+    }
+    const std::string parent = head_commit(root);
+    const std::string parentTree = parent.empty() ? std::string() : capture_git(root, {"rev-parse", "-q", "--verify", "HEAD^{tree}"});
+
+    PackWriter pack(packDir);
+    if (!pack.ok())
+    {
+        logger_.error("git", "cannot create pack", LogField("dir", packDir));
+        return CommitResult::Failed;
+    }
+    std::vector<TreeFile> tree;
+    std::size_t reads = 0;
+    if (!collect_blobs(root, files, pack, threads, tree, reads))
+        return CommitResult::Failed;
+    // Like `git add -A`, leave tracked files the scan filtered out (size,
+    // sensitive names, .rogueignore, secrets) as they were; only those gone
+    // from disk leave the tree.
+    if (!parent.empty() && !tracked_skipped(root, files, false, tree))
+        return CommitResult::Failed;
+
+    const ObjectId treeId = write_trees(pack, tree);
+    const std::string treeHex = Sha1::to_hex(treeId);
+    if (treeHex == parentTree)
+    {
+        logger_.info("git", "nothing to commit");
+        return CommitResult::Unchanged;
+    }
+    std::string body = "tree " + treeHex + "\n";
+    if (!parent.empty())
+        body += "parent " + parent + "\n";
+    const std::string sig = signature();
+    body += "author " + sig + "\ncommitter " + sig + "\n\n" + message;
+    if (body.back() != '\n')
+        body += '\n';
+    const std::string commitHex = Sha1::to_hex(pack.add(ObjectType::Commit, body.data(), body.size()));
+
+    std::string packName;
+    const std::size_t objects = pack.object_count();
+    if (!pack.finish(&packName))
+    {
+        logger_.error("git", "cannot write pack", LogField("dir", packDir));
+        return CommitResult::Failed;
+    }
+    logger_.info("git", "pack written", LogField("pack", packName), LogField("objects", objects), LogField("read", reads));
+
+    // Move the branch (refusing if HEAD moved meanwhile), then write an index
+    // matching the new tree, with the scan's stat data so it reads as clean.
+    std::vector<std::string> update{"update-ref", "HEAD", commitHex};
+    update.push_back(parent.empty() ? std::string(40, '0') : parent);
+    if (!run_git(root, update))
+        return CommitResult::Failed;
+    return write_index(root, files, tree) ? CommitResult::Created : CommitResult::Failed;
 }
 
 bool GitOps::push(const std::string& root, const std::string& branch)
@@ -160,4 +594,14 @@ bool GitOps::push(const std::string& root, const std::string& branch)
     return run_git(root, {"push", "-u", "origin", branch});
 }
 
+bool GitOps::push_commit(const std::string& root, const std::string& commit, const std::string& branch)
+{
+    return run_git(root, {"push", "-q", "origin", commit + ":refs/heads/" + branch});
+}
+
+std::string GitOps::head_commit(const std::string& root)
+{
+    return capture_git(root, {"rev-parse", "-q", "--verify", "HEAD"});
+}
+
 }  // namespace rogue
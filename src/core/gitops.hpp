@@ -7,6 +7,16 @@ namespace rogue
 {
 
     class Logger;
+    struct FileEntry;
+    class PackWriter;
+    struct TreeFile;
+
+    enum class CommitResult
+    {
+        Created,
+        Unchanged,  // the tree matches HEAD's: nothing to commit
+        Failed
+    };
 
     class GitOps
     {
@@ -15,12 +25,59 @@ namespace rogue
         bool ensure_repo_initialized(const std::string &root);
         bool add_remote_and_fetch(const std::string &root, const std::string &repoName, const std::optional<std::string> &org);
         bool stage_all(const std::string &root);
-        bool commit(const std::string &root, const std::string &message);
+        // Stages exactly these paths (literal, relative to root), handed to
+        // `git add` on stdin so the list has no command-line length limit.
+        // Ignored paths make git fail: filter them with drop_ignored first.
+        bool stage_paths(const std::string &root, const std::vector<std::string> &paths);
+        // Removes from `files` the untracked paths .gitignore (or
+        // .git/info/exclude, core.excludesFile) excludes, so explicit staging
+        // and native commits keep what `git add -A` would leave out. False,
+        // leaving `files` alone, if git cannot tell.
+        bool drop_ignored(const std::string &root, std::vector<FileEntry> &files);
+        // Stages the removal of these paths from the index (the files on disk,
+        // if any, are left alone); paths git does not track are ignored.
+        bool remove_paths(const std::string &root, const std::vector<std::string> &paths);
+        // Stages the removal of every tracked file missing from the work
+        // tree: the part of `git add -A` that stage_paths cannot do.
+        bool stage_deletions(const std::string &root);
+        // Unchanged, without running git commit, when nothing is staged.
+        CommitResult commit(const std::string &root, const std::string &message);
         bool push(const std::string &root, const std::string &branch);
+        // Pushes one commit to refs/heads/<branch> on origin. Leaves config and
+        // HEAD alone, so it can run while further commits are being made.
+        bool push_commit(const std::string &root, const std::string &commit, const std::string &branch);
+        // Id of the commit HEAD points to; empty before the first commit.
+        std::string head_commit(const std::string &root);
+
+        // Commits exactly `files` (paths relative to root, e.g. a scan result)
+        // on top of HEAD without git reading the working tree: blobs, trees and
+        // the commit go into one pack written in-process, deflated on `threads`
+        // workers (0 = hardware concurrency). Tracked files missing from
+        // `files` but still on disk keep HEAD's version. Writes nothing and
+        // returns Unchanged if the tree matches HEAD's.
+        CommitResult commit_files(const std::string &root, const std::vector<FileEntry> &files, const std::string &message, int threads = 0);
+
+        // Replaces `git add -A`: writes .git/index for exactly `files`, with the
+        // stat data from the scan so git sees them clean. Files whose blob id the
+        // scan computed (ScanOptions::gitOids) and that git already has are not
+        // read again; the others are written to a new pack. Entries for files
+        // the scan skipped but that are still on disk are kept as staged.
+        bool stage_files(const std::string &root, const std::vector<FileEntry> &files, int threads = 0);
 
     private:
         Logger &logger_;
-        bool run_git(const std::string &root, const std::vector<std::string> &args, bool hide_output = false);
+        bool run_git(const std::string &root, const std::vector<std::string> &args, bool hide_output = false, const std::string &input = {});
+        // Runs git and returns its trimmed stdout; empty on failure.
+        std::string capture_git(const std::string &root, const std::vector<std::string> &args);
+        // Absolute path of `git rev-parse --git-path <what>`; empty outside a repo.
+        std::string git_path(const std::string &root, const std::string &what);
+        bool collect_blobs(const std::string &root, const std::vector<FileEntry> &files, PackWriter &pack, int threads, std::vector<TreeFile> &out, std::size_t &readCount);
+        // Appends to `out` the index's (or HEAD's) entries for paths that are
+        // not in `files` but still exist on disk.
+        bool tracked_skipped(const std::string &root, const std::vector<FileEntry> &files, bool fromIndex, std::vector<TreeFile> &out);
+        // blobs[i] belongs to files[i]; blobs past files.size() are written
+        // without stat data.
+        bool write_index(const std::string &root, const std::vector<FileEntry> &files, const std::vector<TreeFile> &blobs);
     };
 
 }
@@ -0,0 +1,182 @@
+#include "inventory_query.hpp"
+
+#include <algorithm>
+#include <cctype>
+
+#include "rinv.hpp"
+#include "utils.hpp"
+
+namespace rogue
+{
+
+bool parse_query_group(const std::string& name, QueryGroup& out)
+{
+    if (name == "ext")
+        out = QueryGroup::Ext;
+    else if (name == "dir")
+        out = QueryGroup::Dir;
+    else
+        return false;
+    return true;
+}
+
+InventoryQuery::InventoryQuery(const InventoryQueryOptions& options, std::ostream& out)
+    : group_(options.group),
+      paths_(options.paths),
+      minSize_(options.minSize),
+      maxSize_(options.maxSize),
+      hashPrefix_(options.hashPrefix),
+      out_(out)
+{
+    for (char& c : hashPrefix_)
+        c = char(std::tolower(static_cast<unsigned char>(c)));
+}
+
+bool InventoryQuery::matches(std::string_view path, std::uintmax_t size, std::string_view hash) const
+{
+    if (size < minSize_ || size > maxSize_)
+        return false;
+    if (!hashPrefix_.empty() && hash.compare(0, hashPrefix_.size(), hashPrefix_) != 0)
+        return false;
+    return paths_.empty() || paths_.matches_under(path);
+}
+
+void InventoryQuery::add(const InventoryEntryView& e)
+{
+    ++files_;
+    bytes_ += e.size;
+    switch (group_)
+    {
+        case QueryGroup::None:
+            buf_ += "{\"path\":";
+            utils::append_json_string(buf_, e.path);
+            buf_ += ",\"size\":";
+            buf_ += std::to_string(e.size);
+            buf_ += ",\"hash\":";
+            utils::append_json_string(buf_, e.hash);
+            buf_ += ",\"mtime\":";
+            utils::append_json_string(buf_, e.mtime);
+            if (e.hasDedup)
+            {
+                buf_ += ",\"duplicate_bytes\":";
+                buf_ += std::to_string(e.dupBytes);
+            }
+            buf_ += "}\n";
+            if (buf_.size() >= 64 * 1024)
+                flush();
+            return;
+        case QueryGroup::Total:
+            return;
+        case QueryGroup::Ext:
+        {
+            const std::size_t slash = e.path.rfind('/');
+            const std::string_view name = slash == std::string_view::npos ? e.path : e.path.substr(slash + 1);
+            const std::size_t dot = name.rfind('.');
+            // Dot files (".gitignore") have no extension.
+            key_.assign(dot == std::string_view::npos || dot == 0 ? std::string_view() : name.substr(dot + 1));
+            break;
+        }
+        case QueryGroup::Dir:
+        {
+            const std::size_t slash = e.path.rfind('/');
+            key_.assign(slash == std::string_view::npos ? std::string_view(".") : e.path.substr(0, slash));
+            break;
+        }
+    }
+    Group& g = groups_[key_];
+    ++g.files;
+    g.bytes += e.size;
+}
+
+void InventoryQuery::flush()
+{
+    out_.write(buf_.data(), std::streamsize(buf_.size()));
+    buf_.clear();
+}
+
+void InventoryQuery::finish()
+{
+    if (group_ != QueryGroup::None)
+    {
+        buf_ += "{\"bytes\":" + std::to_string(bytes_) + ",\"files\":" + std::to_string(files_);
+        if (group_ != QueryGroup::Total)
+        {
+            std::vector<std::pair<const std::string*, Group>> sorted;
+            sorted.reserve(groups_.size());
+            for (const auto& kv : groups_)
+                sorted.emplace_back(&kv.first, kv.second);
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+                return a.second.bytes != b.second.bytes ? a.second.bytes > b.second.bytes : *a.first < *b.first;
+            });
+            buf_ += ",\"groups\":[";
+            for (std::size_t i = 0; i < sorted.size(); ++i)
+            {
+                buf_ += i ? ",{\"bytes\":" : "{\"bytes\":";
+                buf_ += std::to_string(sorted[i].second.bytes) + ",\"files\":" + std::to_string(sorted[i].second.files);
+                buf_ += ",\"key\":";
+                utils::append_json_string(buf_, *sorted[i].first);
+                buf_ += '}';
+            }
+            buf_ += ']';
+        }
+        buf_ += "}\n";
+    }
+    flush();
+    out_.flush();
+}
+
+std::string_view find_inventory_json(std::string_view text)
+{
+    std::size_t p = 0;
+    while (p < text.size() && (text[p] == ' ' || text[p] == '\n' || text[p] == '\r' || text[p] == '\t'))
+        ++p;
+    if (p < text.size() && text[p] == '{')
+        return text;
+    // full-run appends "````json\n<inventory>\n````" to the proof of work.
+    static constexpr std::string_view kFence = "````json";
+    const std::size_t fence = text.rfind(kFence);
+    if (fence == std::string_view::npos)
+        return {};
+    const std::size_t begin = text.find('\n', fence);
+    if (begin == std::string_view::npos)
+        return {};
+    const std::size_t end = text.find("\n````", begin);
+    return text.substr(begin + 1, end == std::string_view::npos ? std::string_view::npos : end - begin - 1);
+}
+
+bool run_inventory_query(std::string_view json, InventoryQuery& query, std::string* error)
+{
+    InventoryJsonCursor cursor(json);
+    InventoryEntryView e;
+    if (cursor.start())
+        while (cursor.next(e))
+            if (query.matches(e.path, e.size, e.hash))
+                query.add(e);
+    if (cursor.finish())
+        return true;
+    if (error)
+        *error = cursor.error();
+    return false;
+}
+
+void run_inventory_query(const RinvView& view, InventoryQuery& query)
+{
+    std::string path, hash, mtime;
+    InventoryEntryView e;
+    for (std::size_t i = 0; i < view.size(); ++i)
+    {
+        const RinvRecord& r = view.record(i);
+        view.path(i, path);
+        hash = view.hash_hex(i);
+        if (!query.matches(path, r.size, hash))
+            continue;
+        mtime = view.mtime_iso(i);
+        e.path = path;
+        e.size = r.size;
+        e.hash = hash;
+        e.mtime = mtime;
+        query.add(e);
+    }
+}
+
+}  // namespace rogue
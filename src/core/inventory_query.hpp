@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "inventory_reader.hpp"
+#include "path_matcher.hpp"
+
+namespace rogue
+{
+
+class RinvView;
+
+enum class QueryGroup
+{
+    None,   // matching entries, one JSON object per line
+    Total,  // {"bytes":B,"files":N}
+    Ext,    // totals per file extension
+    Dir     // totals per parent directory
+};
+
+bool parse_query_group(const std::string& name, QueryGroup& out);
+
+struct InventoryQueryOptions
+{
+    std::vector<std::string> paths;  // globs, any of which must match
+    std::uintmax_t minSize{0};
+    std::uintmax_t maxSize{std::numeric_limits<std::uintmax_t>::max()};
+    std::string hashPrefix;  // hex, any case
+    QueryGroup group{QueryGroup::None};
+};
+
+// Filters inventory entries as they are read and either writes the matches
+// (NDJSON, the shape of `scan --format ndjson`) or only keeps totals.
+class InventoryQuery
+{
+public:
+    InventoryQuery(const InventoryQueryOptions& options, std::ostream& out);
+
+    bool matches(std::string_view path, std::uintmax_t size, std::string_view hash) const;
+    void add(const InventoryEntryView& e);
+    // Writes the aggregate (if any) and flushes.
+    void finish();
+
+    std::size_t files() const { return files_; }
+    std::uintmax_t bytes() const { return bytes_; }
+
+private:
+    struct Group
+    {
+        std::size_t files{0};
+        std::uintmax_t bytes{0};
+    };
+
+    void flush();
+
+    QueryGroup group_;
+    PathMatcher paths_;
+    std::uintmax_t minSize_;
+    std::uintmax_t maxSize_;
+    std::string hashPrefix_;
+    std::ostream& out_;
+    std::string buf_;
+    std::string key_;
+    std::unordered_map<std::string, Group> groups_;
+    std::size_t files_{0};
+    std::uintmax_t bytes_{0};
+};
+
+// The inventory inside text: the text itself, or for a Markdown document
+// such as docs/PROOF_OF_WORK.md the last ```` json block. Empty if neither.
+std::string_view find_inventory_json(std::string_view text);
+
+// Feeds every entry of a JSON inventory (read with InventoryJsonCursor) or of
+// a .rinv view to the query. False with a message on malformed JSON.
+bool run_inventory_query(std::string_view json, InventoryQuery& query, std::string* error = nullptr);
+void run_inventory_query(const RinvView& view, InventoryQuery& query);
+
+}  // namespace rogue
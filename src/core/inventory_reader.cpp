@@ -0,0 +1,551 @@
+#include "inventory_reader.hpp"
+
+#include <cstring>
+
+namespace rogue
+{
+
+namespace
+{
+
+int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool hex4(const char*& p, const char* end, unsigned& out)
+{
+    if (end - p < 4)
+        return false;
+    out = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        const int d = hex_digit(*p++);
+        if (d < 0)
+            return false;
+        out = out << 4 | unsigned(d);
+    }
+    return true;
+}
+
+void append_utf8(std::string& out, unsigned cp)
+{
+    if (cp < 0x80)
+        out += char(cp);
+    else if (cp < 0x800)
+    {
+        out += char(0xC0 | cp >> 6);
+        out += char(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += char(0xE0 | cp >> 12);
+        out += char(0x80 | (cp >> 6 & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += char(0xF0 | cp >> 18);
+        out += char(0x80 | (cp >> 12 & 0x3F));
+        out += char(0x80 | (cp >> 6 & 0x3F));
+        out += char(0x80 | (cp & 0x3F));
+    }
+}
+
+struct WsTable
+{
+    bool ws[256]{};
+    constexpr WsTable()
+    {
+        ws[std::uint8_t(' ')] = ws[std::uint8_t('\n')] = ws[std::uint8_t('\r')] = ws[std::uint8_t('\t')] = true;
+    }
+};
+constexpr WsTable kWs;
+
+inline bool is_ws(char c)
+{
+    return kWs.ws[std::uint8_t(c)];
+}
+
+}  // namespace
+
+bool json_unescape(std::string_view raw, std::string& out)
+{
+    out.clear();
+    const char* p = raw.data();
+    const char* end = p + raw.size();
+    for (;;)
+    {
+        // Copy the run up to the next escape in one go.
+        const char* run = p;
+        while (p < end && *p != '\\')
+            ++p;
+        out.append(run, std::size_t(p - run));
+        if (p == end)
+            return true;
+        if (++p == end)
+            return false;
+        switch (*p++)
+        {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                unsigned cp;
+                if (!hex4(p, end, cp))
+                    return false;
+                if (cp >= 0xD800 && cp < 0xDC00)
+                {
+                    unsigned lo;
+                    if (end - p < 2 || p[0] != '\\' || p[1] != 'u' || (p += 2, !hex4(p, end, lo)) || lo < 0xDC00 ||
+                        lo > 0xDFFF)
+                        return false;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                append_utf8(out, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+InventoryJsonCursor::InventoryJsonCursor(std::string_view text, JsonIndexer::Kernel kernel)
+    : text_(text), index_(text, kernel)
+{
+}
+
+bool InventoryJsonCursor::fail(const char* what, std::size_t at)
+{
+    if (error_.empty())
+        error_ = std::string(what) + " at offset " + std::to_string(at);
+    where_ = Where::Done;
+    return false;
+}
+
+bool InventoryJsonCursor::peek(std::size_t& off)
+{
+    while (pos_ == index_.count())
+    {
+        if (!index_.next_window())
+            return false;
+        pos_ = 0;
+    }
+    off = index_.base() + index_.offsets()[pos_];
+    return true;
+}
+
+bool InventoryJsonCursor::take(std::size_t& off)
+{
+    if (!peek(off))
+        return false;
+    ++pos_;
+    return true;
+}
+
+std::size_t InventoryJsonCursor::skip_ws(std::size_t from) const
+{
+    while (from < text_.size() && is_ws(text_[from]))
+        ++from;
+    return from;
+}
+
+// Only whitespace may separate two structurals outside a scalar.
+bool InventoryJsonCursor::ws_until(std::size_t off)
+{
+    if (done_ == off)
+        return true;
+    const std::size_t p = skip_ws(done_);
+    return p >= off || fail("unexpected characters", p);
+}
+
+bool InventoryJsonCursor::expect(char c)
+{
+    std::size_t off;
+    if (!take(off))
+        return fail(c == '"' ? "expected a string" : "unexpected end of input", text_.size());
+    if (!ws_until(off))
+        return false;
+    if (text_[off] != c)
+    {
+        static const char* const messages[] = {"expected '{'", "expected '}'", "expected '['", "expected ']'",
+                                               "expected ':'", "expected a string", "unexpected character"};
+        const char* m = messages[6];
+        switch (c)
+        {
+            case '{': m = messages[0]; break;
+            case '}': m = messages[1]; break;
+            case '[': m = messages[2]; break;
+            case ']': m = messages[3]; break;
+            case ':': m = messages[4]; break;
+            case '"': m = messages[5]; break;
+        }
+        return fail(m, off);
+    }
+    done_ = off + 1;
+    return true;
+}
+
+bool InventoryJsonCursor::peek_is(char c)
+{
+    std::size_t off;
+    return peek(off) && text_[off] == c && skip_ws(done_) >= off;
+}
+
+bool InventoryJsonCursor::raw_string(std::string_view& raw, std::size_t& at)
+{
+    if (!expect('"'))
+        return false;
+    at = done_ - 1;
+    // Inside a string the only structural is its closing quote.
+    std::size_t close;
+    if (!take(close))
+        return fail("unterminated string", at);
+    raw = text_.substr(done_, close - done_);
+    done_ = close + 1;
+    return true;
+}
+
+bool InventoryJsonCursor::string(std::string_view& out, std::string& scratch)
+{
+    std::size_t at;
+    if (!raw_string(out, at))
+        return false;
+    if (std::memchr(out.data(), '\\', out.size()) == nullptr)
+        return true;
+    if (!json_unescape(out, scratch))
+        return fail("bad escape", at);
+    out = scratch;
+    return true;
+}
+
+// A number or literal: everything up to the next structural.
+bool InventoryJsonCursor::scalar(std::string_view& out, std::size_t& at)
+{
+    at = skip_ws(done_);
+    std::size_t end;
+    if (!peek(end))
+        end = text_.size();
+    if (end <= at)
+        return fail("expected a value", at);
+    std::size_t last = end;
+    while (last > at && is_ws(text_[last - 1]))
+        --last;
+    out = text_.substr(at, last - at);
+    done_ = end;
+    return true;
+}
+
+bool InventoryJsonCursor::number(std::uintmax_t& out)
+{
+    std::string_view s;
+    std::size_t at;
+    if (!scalar(s, at))
+        return false;
+    std::uintmax_t v = 0;
+    for (char c : s)
+    {
+        if (c < '0' || c > '9')
+            return fail("expected a non-negative integer", at);
+        const std::uintmax_t next = v * 10 + std::uintmax_t(c - '0');
+        if (next / 10 != v)
+            return fail("integer out of range", at);
+        v = next;
+    }
+    out = v;
+    return true;
+}
+
+bool InventoryJsonCursor::string_or_null(std::string_view& out, std::string& scratch)
+{
+    const std::size_t p = skip_ws(done_);
+    if (p < text_.size() && text_[p] == 'n')
+    {
+        std::string_view s;
+        std::size_t at;
+        if (!scalar(s, at))
+            return false;
+        out = {};
+        return s == "null" || fail("expected a string", at);
+    }
+    return string(out, scratch);
+}
+
+bool InventoryJsonCursor::skip_value()
+{
+    const std::size_t p = skip_ws(done_);
+    if (p == text_.size())
+        return fail("expected a value", p);
+    const char c = text_[p];
+    if (c == '"')
+    {
+        std::string_view raw;
+        std::size_t at;
+        return raw_string(raw, at);
+    }
+    if (c == '{' || c == '[')
+    {
+        // Structurals are already known, so a nested value is skipped by
+        // matching brackets without looking at what lies between them.
+        stack_.clear();
+        std::size_t off;
+        do
+        {
+            if (!take(off))
+                return fail("unexpected end of input", text_.size());
+            const char s = text_[off];
+            if (s == '{' || s == '[')
+                stack_ += s;
+            else if (s == '}' || s == ']')
+            {
+                if (stack_.empty() || stack_.back() != (s == '}' ? '{' : '['))
+                    return fail("mismatched bracket", off);
+                stack_.pop_back();
+            }
+        } while (!stack_.empty());
+        done_ = off + 1;
+        return true;
+    }
+    if (c == '}' || c == ']' || c == ':' || c == ',')
+        return fail("expected a value", p);
+    std::string_view s;
+    std::size_t at;
+    if (!scalar(s, at))
+        return false;
+    if (s == "true" || s == "false" || s == "null")
+        return true;
+    for (char d : s)
+        if (!std::strchr("+-.eE0123456789", d))
+            return fail("unexpected value", at);
+    return true;
+}
+
+// Members of the top-level object, up to "files" or the end.
+bool InventoryJsonCursor::top_members()
+{
+    for (;;)
+    {
+        if (firstMember_)
+        {
+            firstMember_ = false;
+            if (peek_is('}'))
+            {
+                expect('}');
+                break;
+            }
+        }
+        else
+        {
+            std::size_t off;
+            if (!take(off))
+                return fail("expected '}'", text_.size());
+            if (!ws_until(off))
+                return false;
+            done_ = off + 1;
+            if (text_[off] == '}')
+                break;
+            if (text_[off] != ',')
+                return fail("expected '}'", off);
+        }
+        std::string_view key;
+        if (!string(key, keyScratch_) || !expect(':'))
+            return false;
+        if (key == "files")
+        {
+            if (where_ != Where::Before)
+                return fail("duplicate \"files\"", done_);
+            if (!expect('['))
+                return false;
+            where_ = Where::FirstEntry;
+            return true;
+        }
+        std::string_view s;
+        bool ok;
+        if (key == "root")
+            ok = string(s, pathScratch_) && (root_.assign(s), true);
+        else if (key == "generated_at")
+            ok = string(s, pathScratch_) && (generatedAt_.assign(s), true);
+        else if (key == "total_size")
+            ok = number(totalSize_);
+        else
+            ok = skip_value();
+        if (!ok)
+            return false;
+    }
+    std::size_t off;
+    if (peek(off))
+        return fail("trailing characters", off);
+    const std::size_t p = skip_ws(done_);
+    if (p != text_.size())
+        return fail("trailing characters", p);
+    where_ = Where::Done;
+    return true;
+}
+
+// `scan --format ndjson` output: objects whose first key is an entry's.
+bool InventoryJsonCursor::entry_lines() const
+{
+    std::size_t p = skip_ws(0);
+    if (p == text_.size() || text_[p] != '{')
+        return false;
+    p = skip_ws(p + 1);
+    if (p == text_.size() || text_[p] != '"')
+        return false;
+    const std::size_t close = text_.find('"', p + 1);
+    if (close == std::string_view::npos)
+        return false;
+    const std::string_view key = text_.substr(p + 1, close - p - 1);
+    return key == "path" || key == "size" || key == "hash" || key == "mtime" || key == "duplicate_bytes";
+}
+
+bool InventoryJsonCursor::start()
+{
+    if (where_ != Where::Before || !error_.empty())
+        return error_.empty();
+    if (entry_lines())
+    {
+        where_ = Where::Lines;
+        return true;
+    }
+    return expect('{') && top_members();
+}
+
+bool InventoryJsonCursor::entry(InventoryEntryView& e)
+{
+    e = InventoryEntryView{};
+    if (!expect('{'))
+        return false;
+    if (peek_is('}'))
+        return expect('}');
+    for (;;)
+    {
+        std::string_view key;
+        if (!string(key, keyScratch_) || !expect(':'))
+            return false;
+        bool ok;
+        if (key == "path")
+            ok = string(e.path, pathScratch_);
+        else if (key == "size")
+            ok = number(e.size);
+        else if (key == "hash")
+            ok = string_or_null(e.hash, hashScratch_);
+        else if (key == "mtime")
+            ok = string_or_null(e.mtime, mtimeScratch_);
+        else if (key == "duplicate_bytes")
+            ok = (e.hasDedup = true, number(e.dupBytes));
+        else
+            ok = skip_value();
+        if (!ok)
+            return false;
+        std::size_t off;
+        if (!take(off))
+            return fail("expected '}'", text_.size());
+        if (!ws_until(off))
+            return false;
+        done_ = off + 1;
+        if (text_[off] == '}')
+            return true;
+        if (text_[off] != ',')
+            return fail("expected '}'", off);
+    }
+}
+
+bool InventoryJsonCursor::next(InventoryEntryView& e)
+{
+    if (where_ == Where::Lines)
+    {
+        // One object per line; only whitespace may separate them.
+        if (skip_ws(done_) == text_.size())
+        {
+            where_ = Where::Done;
+            return false;
+        }
+        return entry(e);
+    }
+    if (where_ == Where::FirstEntry)
+    {
+        if (peek_is(']'))
+        {
+            expect(']');
+            where_ = Where::AfterFiles;
+            return false;
+        }
+        where_ = Where::Entries;
+        return entry(e);
+    }
+    if (where_ != Where::Entries)
+        return false;
+    std::size_t off;
+    if (!take(off))
+        return fail("expected ']'", text_.size());
+    if (!ws_until(off))
+        return false;
+    done_ = off + 1;
+    if (text_[off] == ']')
+    {
+        where_ = Where::AfterFiles;
+        return false;
+    }
+    if (text_[off] != ',')
+        return fail("expected ']'", off);
+    return entry(e);
+}
+
+bool InventoryJsonCursor::finish()
+{
+    if (where_ == Where::Before && !start())
+        return false;
+    InventoryEntryView e;
+    while (next(e))
+    {
+    }
+    if (where_ == Where::AfterFiles && !top_members())
+        return false;
+    if (!error_.empty())
+        return false;
+    return where_ == Where::Done || fail("expected '}'", text_.size());
+}
+
+bool parse_inventory_json(std::string_view text, InventoryDoc& out, std::string* error)
+{
+    out = InventoryDoc{};
+    InventoryJsonCursor cursor(text);
+    InventoryEntryView e;
+    if (cursor.start())
+        while (cursor.next(e))
+        {
+            FileEntry fe;
+            fe.path.assign(e.path);
+            fe.size = e.size;
+            fe.hash.assign(e.hash);
+            fe.mtime.assign(e.mtime);
+            fe.dupBytes = e.dupBytes;
+            fe.hasDedup = e.hasDedup;
+            out.files.push_back(std::move(fe));
+        }
+    if (!cursor.finish())
+    {
+        if (error)
+            *error = cursor.error();
+        return false;
+    }
+    out.root = cursor.root();
+    out.generatedAt = cursor.generated_at();
+    out.totalSize = cursor.total_size();
+    return true;
+}
+
+}  // namespace rogue
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json_index.hpp"
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+// An inventory document read back from its JSON form.
+struct InventoryDoc
+{
+    std::string root;
+    std::string generatedAt;
+    std::vector<FileEntry> files;  // path, size, hash, mtime (and duplicate_bytes when present)
+    std::uintmax_t totalSize{0};
+};
+
+// One "files" entry, valid until the next call on its cursor. Strings point
+// into the text unless they contained escapes.
+struct InventoryEntryView
+{
+    std::string_view path;
+    std::uintmax_t size{0};
+    std::string_view hash;  // empty when the inventory carries none
+    std::string_view mtime;
+    std::uintmax_t dupBytes{0};
+    bool hasDedup{false};
+};
+
+// Reads an inventory without building it in memory: walks the structural
+// index (JsonIndexer) and only decodes the fields it is asked for. The
+// document is the one the inventory writers produce (pretty or compact,
+// keys in any order); unknown values are skipped by their brackets.
+// NDJSON entries, as `scan --format ndjson` writes them, are read the same
+// way, one object per line, with no root or totals.
+//
+//   InventoryJsonCursor c(text);
+//   if (c.start()) while (c.next(e)) ...;
+//   c.finish();  // false, with error(), if anything was malformed
+class InventoryJsonCursor
+{
+public:
+    explicit InventoryJsonCursor(std::string_view text, JsonIndexer::Kernel kernel = JsonIndexer::Kernel::Auto);
+
+    // Reads the top-level object up to the start of "files".
+    bool start();
+    // Next entry; false at the end of "files" or on error.
+    bool next(InventoryEntryView& entry);
+    // Skips any remaining entries and reads the rest of the document.
+    bool finish();
+
+    const std::string& error() const { return error_; }
+    // Complete once finish() has returned true.
+    const std::string& root() const { return root_; }
+    const std::string& generated_at() const { return generatedAt_; }
+    std::uintmax_t total_size() const { return totalSize_; }
+
+private:
+    enum class Where
+    {
+        Before,
+        FirstEntry,
+        Entries,
+        Lines,  // NDJSON: a stream of entry objects
+        AfterFiles,
+        Done
+    };
+
+    bool fail(const char* what, std::size_t at);
+    bool peek(std::size_t& off);
+    bool take(std::size_t& off);
+    bool ws_until(std::size_t off);
+    std::size_t skip_ws(std::size_t from) const;
+    bool expect(char c);
+    bool peek_is(char c);
+    bool raw_string(std::string_view& raw, std::size_t& at);
+    bool string(std::string_view& out, std::string& scratch);
+    bool scalar(std::string_view& out, std::size_t& at);
+    bool number(std::uintmax_t& out);
+    bool string_or_null(std::string_view& out, std::string& scratch);
+    bool skip_value();
+    bool top_members();
+    bool entry_lines() const;
+    bool entry(InventoryEntryView& e);
+
+    std::string_view text_;
+    JsonIndexer index_;
+    std::size_t pos_{0};   // next offset in the current window
+    std::size_t done_{0};  // text before this has been consumed
+    Where where_{Where::Before};
+    bool firstMember_{true};
+    std::string error_;
+    std::string root_;
+    std::string generatedAt_;
+    std::uintmax_t totalSize_{0};
+    std::string keyScratch_;
+    std::string pathScratch_;
+    std::string hashScratch_;
+    std::string mtimeScratch_;
+    std::string stack_;  // brackets of the value being skipped
+};
+
+// Reads the document the inventory writers produce into memory. False with
+// a message ("... at offset N") on malformed input.
+bool parse_inventory_json(std::string_view text, InventoryDoc& out, std::string* error = nullptr);
+
+// Decodes the body of a JSON string (between its quotes). False on a bad
+// escape.
+bool json_unescape(std::string_view raw, std::string& out);
+
+}  // namespace rogue
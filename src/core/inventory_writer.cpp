@@ -0,0 +1,139 @@
+#include "inventory_writer.hpp"
+
+#include "utils.hpp"
+
+namespace rogue
+{
+
+namespace
+{
+
+// Entries are formatted into a reused buffer and handed to the stream in one
+// write, so the per-file cost is a few appends and no allocation once warm.
+class PrettyJsonWriter : public InventoryWriter
+{
+public:
+    explicit PrettyJsonWriter(std::ostream& out) : out_(out) {}
+
+    // Keys are emitted in sorted order; the output is byte-identical to the
+    // json shim's dump(2) of the same document built in that order.
+    void begin(const std::string& root, const std::string& generatedAt) override
+    {
+        root_ = root;
+        generatedAt_ = generatedAt;
+        out_ << "{\n  \"files\": [";
+    }
+
+    void entry(const FileEntry& fe) override
+    {
+        buf_.clear();
+        buf_ += count_++ ? ",\n    {\n      " : "\n    {\n      ";
+        if (fe.hasDedup)
+        {
+            buf_ += "\"duplicate_bytes\": ";
+            buf_ += std::to_string(fe.dupBytes);
+            buf_ += ",\n      ";
+        }
+        buf_ += "\"hash\": ";
+        utils::append_json_string(buf_, fe.hash);
+        buf_ += ",\n      \"mtime\": ";
+        utils::append_json_string(buf_, fe.mtime);
+        buf_ += ",\n      \"path\": ";
+        utils::append_json_string(buf_, fe.path);
+        buf_ += ",\n      \"size\": ";
+        buf_ += std::to_string(fe.size);
+        buf_ += "\n    }";
+        out_.write(buf_.data(), std::streamsize(buf_.size()));
+    }
+
+    void dedup_totals(std::uintmax_t uniqueSize) override
+    {
+        uniqueSize_ = uniqueSize;
+        hasUnique_ = true;
+    }
+
+    void end(std::uintmax_t totalSize) override
+    {
+        buf_.clear();
+        buf_ += count_ ? "\n  ],\n  \"generated_at\": " : "],\n  \"generated_at\": ";
+        utils::append_json_string(buf_, generatedAt_);
+        buf_ += ",\n  \"root\": ";
+        utils::append_json_string(buf_, root_);
+        buf_ += ",\n  \"total_size\": ";
+        buf_ += std::to_string(totalSize);
+        if (hasUnique_)
+        {
+            buf_ += ",\n  \"unique_size\": ";
+            buf_ += std::to_string(uniqueSize_);
+        }
+        buf_ += "\n}";
+        out_.write(buf_.data(), std::streamsize(buf_.size()));
+        out_.flush();
+    }
+
+private:
+    std::ostream& out_;
+    std::string buf_;
+    std::string root_;
+    std::string generatedAt_;
+    std::size_t count_{0};
+    std::uintmax_t uniqueSize_{0};
+    bool hasUnique_{false};
+};
+
+class NdjsonWriter : public InventoryWriter
+{
+public:
+    explicit NdjsonWriter(std::ostream& out) : out_(out) {}
+
+    void begin(const std::string&, const std::string&) override {}
+
+    void entry(const FileEntry& fe) override
+    {
+        buf_.assign("{\"path\":");
+        utils::append_json_string(buf_, fe.path);
+        buf_ += ",\"size\":";
+        buf_ += std::to_string(fe.size);
+        buf_ += ",\"hash\":";
+        utils::append_json_string(buf_, fe.hash);
+        buf_ += ",\"mtime\":";
+        utils::append_json_string(buf_, fe.mtime);
+        if (fe.hasDedup)
+        {
+            buf_ += ",\"duplicate_bytes\":";
+            buf_ += std::to_string(fe.dupBytes);
+        }
+        buf_ += "}\n";
+        out_.write(buf_.data(), std::streamsize(buf_.size()));
+    }
+
+    void end(std::uintmax_t) override { out_.flush(); }
+
+private:
+    std::ostream& out_;
+    std::string buf_;
+};
+
+}  // namespace
+
+bool parse_inventory_format(const std::string& name, InventoryFormat& out)
+{
+    if (name == "json")
+        out = InventoryFormat::Json;
+    else if (name == "json-stream")
+        out = InventoryFormat::JsonStream;
+    else if (name == "ndjson")
+        out = InventoryFormat::Ndjson;
+    else
+        return false;
+    return true;
+}
+
+std::unique_ptr<InventoryWriter> make_inventory_writer(InventoryFormat format, std::ostream& out)
+{
+    if (format == InventoryFormat::Ndjson)
+        return std::make_unique<NdjsonWriter>(out);
+    return std::make_unique<PrettyJsonWriter>(out);
+}
+
+}  // namespace rogue
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+enum class InventoryFormat
+{
+    Json,        // buffered, sorted, pretty-printed (ScanResult::inventoryJson)
+    JsonStream,  // same document shape, entries written as they are hashed
+    Ndjson       // one JSON object per file per line, written as hashed
+};
+
+bool parse_inventory_format(const std::string& name, InventoryFormat& out);
+
+// Incremental inventory serializer. Calls are begin, entry*, end; the scanner
+// serializes calls, so implementations need no locking of their own.
+class InventoryWriter
+{
+public:
+    virtual ~InventoryWriter() = default;
+    virtual void begin(const std::string& root, const std::string& generatedAt) = 0;
+    virtual void entry(const FileEntry& fe) = 0;
+    // Workspace-wide unique byte count of a dedup scan, reported before end().
+    virtual void dedup_totals(std::uintmax_t) {}
+    virtual void end(std::uintmax_t totalSize) = 0;
+};
+
+std::unique_ptr<InventoryWriter> make_inventory_writer(InventoryFormat format, std::ostream& out);
+
+}  // namespace rogue
@@ -0,0 +1,276 @@
+#include "json_index.hpp"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROGUE_JSON_X86 1
+#include <immintrin.h>
+#endif
+
+namespace rogue
+{
+
+namespace
+{
+
+using State = JsonIndexer::State;
+
+struct BlockMasks
+{
+    std::uint64_t quote{0};
+    std::uint64_t backslash{0};
+    std::uint64_t op{0};  // { } [ ] : ,
+};
+
+inline unsigned ctz64(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return unsigned(__builtin_ctzll(x));
+#else
+    unsigned n = 0;
+    while (!(x & 1))
+    {
+        x >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+// Bits of the block that are escaped by a backslash, counting runs: in \\"
+// the quote is not escaped, in \\\" it is. `carry` says whether the first
+// byte of this block is escaped by the end of the previous one.
+inline std::uint64_t find_escaped(std::uint64_t backslash, std::uint64_t& carry)
+{
+    if (!backslash)
+    {
+        const std::uint64_t escaped = carry;
+        carry = 0;
+        return escaped;
+    }
+    const std::uint64_t even = 0x5555555555555555ULL;
+    backslash &= ~carry;
+    const std::uint64_t followsEscape = backslash << 1 | carry;
+    const std::uint64_t oddStarts = backslash & ~even & ~followsEscape;
+    const std::uint64_t evenSequences = oddStarts + backslash;
+    carry = evenSequences < oddStarts ? 1 : 0;
+    return (even ^ evenSequences << 1) & followsEscape;
+}
+
+// Bit i = xor of bits 0..i: set from an opening quote up to the byte before
+// its closing quote.
+inline std::uint64_t prefix_xor(std::uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+inline std::size_t finish_block(const BlockMasks& m, State& state, std::uint32_t at, std::uint32_t* out,
+                                std::size_t n)
+{
+    const std::uint64_t quotes = m.quote & ~find_escaped(m.backslash, state.escaped);
+    const std::uint64_t inside = prefix_xor(quotes) ^ state.inString;
+    state.inString = std::uint64_t(std::int64_t(inside) >> 63);
+    std::uint64_t s = (m.op & ~inside) | quotes;
+    while (s)
+    {
+        out[n++] = at + ctz64(s);
+        s &= s - 1;
+    }
+    return n;
+}
+
+struct ClassTable
+{
+    std::uint8_t c[256]{};
+    constexpr ClassTable()
+    {
+        c[std::uint8_t('"')] = 1;
+        c[std::uint8_t('\\')] = 2;
+        for (char op : {'{', '}', '[', ']', ':', ','})
+            c[std::uint8_t(op)] = 4;
+    }
+};
+constexpr ClassTable kClass;
+
+BlockMasks classify_portable(const std::uint8_t* p)
+{
+    BlockMasks m;
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        const std::uint64_t bit = std::uint64_t(1) << i;
+        const std::uint8_t c = kClass.c[p[i]];
+        if (c & 1)
+            m.quote |= bit;
+        if (c & 2)
+            m.backslash |= bit;
+        if (c & 4)
+            m.op |= bit;
+    }
+    return m;
+}
+
+// The last, partial block is padded with spaces, which are never structural.
+inline const std::uint8_t* pad_tail(const std::uint8_t* p, std::size_t len, std::uint8_t (&tmp)[64])
+{
+    std::memset(tmp, ' ', sizeof tmp);
+    std::memcpy(tmp, p, len);
+    return tmp;
+}
+
+std::size_t window_portable(const std::uint8_t* data, std::size_t len, State& state, std::uint32_t* out)
+{
+    std::size_t n = 0, i = 0;
+    for (; i + 64 <= len; i += 64)
+        n = finish_block(classify_portable(data + i), state, std::uint32_t(i), out, n);
+    std::uint8_t tmp[64];
+    if (i < len)
+        n = finish_block(classify_portable(pad_tail(data + i, len - i, tmp)), state, std::uint32_t(i), out, n);
+    return n;
+}
+
+#ifdef ROGUE_JSON_X86
+// Operators by equality: ':' and ',' directly; '{' '[' and '}' ']' differ
+// only in bit 0x20, so one compare each after setting it.
+__attribute__((target("sse2"))) BlockMasks classify_sse2(const std::uint8_t* p)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    BlockMasks m;
+    for (unsigned k = 0; k < 4; ++k)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k));
+        const __m128i folded = _mm_or_si128(v, lower);
+        const __m128i ops = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        const unsigned shift = 16 * k;
+        m.quote |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        m.op |= std::uint64_t(std::uint16_t(_mm_movemask_epi8(ops))) << shift;
+    }
+    return m;
+}
+
+__attribute__((target("sse2"))) std::size_t window_sse2(const std::uint8_t* data, std::size_t len, State& state,
+                                                        std::uint32_t* out)
+{
+    std::size_t n = 0, i = 0;
+    for (; i + 64 <= len; i += 64)
+        n = finish_block(classify_sse2(data + i), state, std::uint32_t(i), out, n);
+    std::uint8_t tmp[64];
+    if (i < len)
+        n = finish_block(classify_sse2(pad_tail(data + i, len - i, tmp)), state, std::uint32_t(i), out, n);
+    return n;
+}
+
+__attribute__((target("avx2"))) BlockMasks classify_avx2(const std::uint8_t* p)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    BlockMasks m;
+    for (unsigned k = 0; k < 2; ++k)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * k));
+        const __m256i folded = _mm256_or_si256(v, lower);
+        const __m256i ops =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        const unsigned shift = 32 * k;
+        m.quote |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        m.backslash |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        m.op |= std::uint64_t(std::uint32_t(_mm256_movemask_epi8(ops))) << shift;
+    }
+    return m;
+}
+
+__attribute__((target("avx2"))) std::size_t window_avx2(const std::uint8_t* data, std::size_t len, State& state,
+                                                        std::uint32_t* out)
+{
+    std::size_t n = 0, i = 0;
+    for (; i + 64 <= len; i += 64)
+        n = finish_block(classify_avx2(data + i), state, std::uint32_t(i), out, n);
+    std::uint8_t tmp[64];
+    if (i < len)
+        n = finish_block(classify_avx2(pad_tail(data + i, len - i, tmp)), state, std::uint32_t(i), out, n);
+    return n;
+}
+#endif
+
+}  // namespace
+
+bool JsonIndexer::kernel_available(Kernel kernel)
+{
+    switch (kernel)
+    {
+        case Kernel::Auto:
+        case Kernel::Portable:
+            return true;
+#ifdef ROGUE_JSON_X86
+        case Kernel::Sse2:
+        {
+            static const bool has = __builtin_cpu_supports("sse2");
+            return has;
+        }
+        case Kernel::Avx2:
+        {
+            static const bool has = __builtin_cpu_supports("avx2");
+            return has;
+        }
+#else
+        default:
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* JsonIndexer::active_kernel_name()
+{
+    if (kernel_available(Kernel::Avx2))
+        return "avx2";
+    return kernel_available(Kernel::Sse2) ? "sse2" : "portable";
+}
+
+JsonIndexer::JsonIndexer(std::string_view text, Kernel kernel)
+    : text_(text), window_(window_portable), offsets_(kWindow)
+{
+#ifdef ROGUE_JSON_X86
+    if ((kernel == Kernel::Auto || kernel == Kernel::Avx2) && kernel_available(Kernel::Avx2))
+        window_ = window_avx2;
+    else if ((kernel == Kernel::Auto || kernel == Kernel::Sse2) && kernel_available(Kernel::Sse2))
+        window_ = window_sse2;
+#else
+    (void)kernel;
+#endif
+}
+
+bool JsonIndexer::next_window()
+{
+    if (next_ >= text_.size())
+    {
+        count_ = 0;
+        return false;
+    }
+    base_ = next_;
+    const std::size_t len = text_.size() - base_ < kWindow ? text_.size() - base_ : kWindow;
+    count_ = window_(reinterpret_cast<const std::uint8_t*>(text_.data()) + base_, len, state_, offsets_.data());
+    next_ = base_ + len;
+    return true;
+}
+
+}  // namespace rogue
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace rogue
+{
+
+// First stage of the inventory reader: finds the structural characters of a
+// JSON text, i.e. every { } [ ] : , outside strings plus the opening and
+// closing quote of every string, 64 bytes at a time. The block masks (quotes,
+// backslashes, operators) come from SIMD compares; escapes and the in-string
+// region are then resolved with a few bit operations per block, carried from
+// one block to the next. Scalars (numbers, true, false, null) are whatever
+// lies between two structurals.
+//
+// The text is indexed one window at a time, so the index stays small (and in
+// cache) however large the document is.
+class JsonIndexer
+{
+public:
+    enum class Kernel
+    {
+        Auto,
+        Portable,
+        Sse2,
+        Avx2
+    };
+    static constexpr std::size_t kWindow = 16 * 1024;
+
+    explicit JsonIndexer(std::string_view text, Kernel kernel = Kernel::Auto);
+
+    // Indexes the next window. Offsets are relative to base(); false once the
+    // whole text has been indexed.
+    bool next_window();
+    const std::uint32_t* offsets() const { return offsets_.data(); }
+    std::size_t count() const { return count_; }
+    std::size_t base() const { return base_; }
+    // True when the text ends inside a string (only meaningful at the end).
+    bool in_string() const { return state_.inString != 0; }
+
+    static bool kernel_available(Kernel kernel);
+    static const char* active_kernel_name();
+
+    // Carry between blocks, exposed for the kernels.
+    struct State
+    {
+        std::uint64_t escaped{0};   // first byte of the next block is escaped
+        std::uint64_t inString{0};  // all ones inside a string
+    };
+    using WindowFn = std::size_t (*)(const std::uint8_t* data, std::size_t len, State& state,
+                                     std::uint32_t* out);
+
+private:
+    std::string_view text_;
+    WindowFn window_;
+    std::vector<std::uint32_t> offsets_;
+    std::size_t count_{0};
+    std::size_t base_{0};
+    std::size_t next_{0};
+    State state_;
+};
+
+}  // namespace rogue
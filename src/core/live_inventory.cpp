@@ -0,0 +1,331 @@
+#include "live_inventory.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+#include "dir_reader.hpp"
+#include "inventory_writer.hpp"
+#include "logger.hpp"
+#include "path_matcher.hpp"
+#include "utils.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace rogue
+{
+
+namespace
+{
+
+std::string join_rel(const std::string& dir, const std::string& name)
+{
+    return dir.empty() ? name : dir + "/" + name;
+}
+
+// Every key starting with "dir/": "/" sorts just before "0".
+template <typename Container>
+std::pair<typename Container::iterator, typename Container::iterator> under(Container& c, const std::string& dir)
+{
+    return {c.lower_bound(dir + "/"), c.lower_bound(dir + "0")};
+}
+
+#ifdef __linux__
+constexpr std::uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                     IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+#endif
+
+}  // namespace
+
+LiveInventory::LiveInventory(ScanOptions options, Logger& logger, unsigned settleMs)
+    : options_(std::move(options)), logger_(logger), settleMs_(settleMs)
+{
+    options_.sink = nullptr;
+    options_.paths.clear();
+    rootPrefix_ = options_.root;
+    if (rootPrefix_.empty() || rootPrefix_.back() != '/')
+        rootPrefix_ += '/';
+}
+
+LiveInventory::~LiveInventory()
+{
+#ifdef __linux__
+    if (fd_ >= 0)
+        ::close(fd_);
+#endif
+}
+
+bool LiveInventory::start()
+{
+#ifdef __linux__
+    std::error_code ec;
+    if (!std::filesystem::is_directory(options_.root, ec))
+    {
+        logger_.error("watch", "root is not a directory", LogField("root", options_.root));
+        return false;
+    }
+    full_rescan();
+    return fd_ >= 0;
+#else
+    logger_.error("watch", "file watching needs inotify (Linux)");
+    return false;
+#endif
+}
+
+void LiveInventory::full_rescan()
+{
+#ifdef __linux__
+    if (fd_ >= 0)
+        ::close(fd_);
+    dirs_.clear();
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0)
+    {
+        logger_.error("watch", "inotify_init1 failed");
+        return;
+    }
+    prune_ = std::make_unique<PathMatcher>(ignore_patterns(options_));
+    watch_tree("", false);
+#endif
+    ScanResult r = scan_workspace(options_, logger_);
+    files_.clear();
+    for (auto& fe : r.files)
+        files_.emplace(fe.path, std::move(fe));
+    secretFiles_ = std::set<std::string>(r.secretFiles.begin(), r.secretFiles.end());
+    totalSize_ = r.totalSize;
+    dirty_.clear();
+    newDirs_.clear();
+    removedDirs_.clear();
+    overflow_ = false;
+    logger_.info("watch", "inventory loaded", LogField("files", files_.size()), LogField("watches", dirs_.size()));
+}
+
+bool LiveInventory::pruned_dir(const std::string& parent, const std::string& name) const
+{
+    return name == ".git" || (parent.empty() && name == ".rogue") || prune_->matches_dir(join_rel(parent, name));
+}
+
+void LiveInventory::watch_tree(const std::string& rel, bool markFiles)
+{
+#ifdef __linux__
+    DirReader reader;
+    std::vector<DirEntry> entries;
+    std::vector<std::string> stack{rel};
+    while (!stack.empty())
+    {
+        const std::string dir = std::move(stack.back());
+        stack.pop_back();
+        const std::string path = dir.empty() ? rootPrefix_ : rootPrefix_ + dir;
+        const int wd = ::inotify_add_watch(fd_, path.c_str(), kWatchMask);
+        if (wd < 0)
+        {
+            // ENOSPC: fs.inotify.max_user_watches is too low for this tree.
+            logger_.warn("watch", "cannot watch", LogField("path", dir.empty() ? std::string(".") : dir));
+            continue;
+        }
+        dirs_[wd] = dir;
+        entries.clear();
+        if (!reader.open(path) || !reader.read_all(entries))
+            continue;
+        for (auto& entry : entries)
+        {
+            auto type = entry.type == DirEntryType::Unknown ? reader.resolve_type(entry.name) : entry.type;
+            std::string child = join_rel(dir, entry.name);
+            if (type == DirEntryType::Dir)
+            {
+                if (pruned_dir(dir, entry.name))
+                    continue;
+                stack.push_back(std::move(child));
+            }
+            else if (markFiles)
+                dirty_.insert(std::move(child));
+        }
+    }
+#else
+    (void)rel;
+    (void)markFiles;
+#endif
+}
+
+bool LiveInventory::drain_events()
+{
+    bool any = false;
+#ifdef __linux__
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;)
+    {
+        const ssize_t n = ::read(fd_, buf, sizeof(buf));
+        if (n <= 0)
+            break;
+        any = true;
+        for (ssize_t off = 0; off < n;)
+        {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            off += ssize_t(sizeof(inotify_event) + ev->len);
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                overflow_ = true;
+                continue;
+            }
+            auto it = dirs_.find(ev->wd);
+            if (it == dirs_.end())
+                continue;
+            if (ev->mask & IN_IGNORED)
+            {
+                dirs_.erase(it);
+                continue;
+            }
+            if (!ev->len)
+                continue;
+            const std::string rel = join_rel(it->second, ev->name);
+            if (!(ev->mask & IN_ISDIR))
+            {
+                // Excluded files (our own output, the log) are no update;
+                // counting them would have the caller rewrite its inventory
+                // for every write it makes.
+                if (!prune_->matches(rel))
+                    dirty_.insert(rel);
+            }
+            else if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                if (!pruned_dir(it->second, ev->name))
+                    newDirs_.insert(rel);
+            }
+            else if (ev->mask & (IN_DELETE | IN_MOVED_FROM))
+            {
+                removedDirs_.insert(rel);
+                if (ev->mask & IN_MOVED_FROM)
+                {
+                    // Its watches would keep reporting under the old name.
+                    const std::string prefix = rel + "/";
+                    for (auto w = dirs_.begin(); w != dirs_.end();)
+                    {
+                        if (w->second == rel || w->second.compare(0, prefix.size(), prefix) == 0)
+                        {
+                            ::inotify_rm_watch(fd_, w->first);
+                            w = dirs_.erase(w);
+                        }
+                        else
+                            ++w;
+                    }
+                }
+            }
+        }
+    }
+#endif
+    return any;
+}
+
+std::size_t LiveInventory::wait_and_apply(int timeoutMs, unsigned maxDelayMs)
+{
+#ifdef __linux__
+    if (fd_ < 0)
+        return 0;
+    pollfd p{fd_, POLLIN, 0};
+    if (::poll(&p, 1, timeoutMs) <= 0)
+        return 0;
+    const auto first = std::chrono::steady_clock::now();
+    drain_events();
+    for (;;)
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - first).count();
+        if (elapsed >= maxDelayMs)
+            break;
+        p.revents = 0;
+        if (::poll(&p, 1, int(std::min<long long>(settleMs_, maxDelayMs - elapsed))) <= 0)
+            break;
+        drain_events();
+    }
+    return apply();
+#else
+    (void)timeoutMs;
+    (void)maxDelayMs;
+    return 0;
+#endif
+}
+
+std::size_t LiveInventory::apply()
+{
+    if (overflow_ || dirty_.count(".rogueignore"))
+    {
+        // Lost events or new filter rules: only a full pass is trustworthy.
+        logger_.info("watch", overflow_ ? "event queue overflow, rescanning" : ".rogueignore changed, rescanning");
+        full_rescan();
+        return files_.size();
+    }
+    std::size_t touched = 0;
+    for (auto& dir : removedDirs_)
+    {
+        auto range = under(files_, dir);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            totalSize_ -= it->second.size;
+            ++touched;
+        }
+        files_.erase(range.first, range.second);
+        auto secrets = under(secretFiles_, dir);
+        secretFiles_.erase(secrets.first, secrets.second);
+    }
+    for (auto& dir : newDirs_)
+    {
+        std::error_code ec;
+        if (std::filesystem::is_directory(rootPrefix_ + dir, ec) && !std::filesystem::is_symlink(rootPrefix_ + dir, ec))
+            watch_tree(dir, true);
+    }
+    if (!dirty_.empty())
+    {
+        ScanOptions o = options_;
+        o.paths.assign(dirty_.begin(), dirty_.end());
+        o.useCache = false;  // every one of them was just touched
+        ScanResult r = scan_workspace(o, logger_);
+        for (auto& path : o.paths)
+        {
+            auto it = files_.find(path);
+            if (it != files_.end())
+            {
+                totalSize_ -= it->second.size;
+                files_.erase(it);
+            }
+            secretFiles_.erase(path);
+        }
+        for (auto& fe : r.files)
+        {
+            totalSize_ += fe.size;
+            std::string key = fe.path;
+            files_.emplace(std::move(key), std::move(fe));
+        }
+        secretFiles_.insert(r.secretFiles.begin(), r.secretFiles.end());
+        touched += o.paths.size();
+    }
+    dirty_.clear();
+    newDirs_.clear();
+    removedDirs_.clear();
+    if (touched)
+        logger_.info("watch", "inventory updated", LogField("changed", touched), LogField("files", files_.size()));
+    return touched;
+}
+
+ScanResult LiveInventory::snapshot() const
+{
+    ScanResult r;
+    r.files.reserve(files_.size());
+    for (auto& kv : files_)
+        r.files.push_back(kv.second);
+    r.totalSize = totalSize_;
+    r.secretFiles.assign(secretFiles_.begin(), secretFiles_.end());
+    std::ostringstream os;
+    auto writer = make_inventory_writer(InventoryFormat::Json, os);
+    writer->begin(options_.root, utils::iso_timestamp());
+    for (auto& fe : r.files)
+        writer->entry(fe);
+    writer->end(r.totalSize);
+    r.inventoryJson = os.str();
+    return r;
+}
+
+}  // namespace rogue
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+class Logger;
+class PathMatcher;
+
+// Inventory kept current from inotify events after one full scan, so it is
+// available at any time without walking the tree again. Events are only
+// recorded as dirty paths; a burst (a build, a checkout) is applied once the
+// tree has been quiet for settleMs, and only the touched files are hashed.
+// Linux only: start() fails elsewhere.
+class LiveInventory
+{
+public:
+    LiveInventory(ScanOptions options, Logger& logger, unsigned settleMs = 200);
+    ~LiveInventory();
+
+    LiveInventory(const LiveInventory&) = delete;
+    LiveInventory& operator=(const LiveInventory&) = delete;
+
+    // Watches every directory the scan would visit, then runs the full scan
+    // (watches first, so nothing changed in between is missed).
+    bool start();
+
+    // Waits up to timeoutMs for events. Once some arrive, keeps collecting
+    // until settleMs pass without any (but no longer than maxDelayMs), then
+    // updates the inventory. Returns the number of paths re-examined.
+    std::size_t wait_and_apply(int timeoutMs, unsigned maxDelayMs = 5000);
+
+    // Current inventory, sorted by path, with inventoryJson filled in.
+    ScanResult snapshot() const;
+    std::size_t file_count() const { return files_.size(); }
+    std::size_t watch_count() const { return dirs_.size(); }
+
+private:
+    void watch_tree(const std::string& rel, bool markFiles);
+    // .git, the top-level .rogue and ignored directories are never watched.
+    bool pruned_dir(const std::string& parent, const std::string& name) const;
+    bool drain_events();
+    std::size_t apply();
+    void full_rescan();
+
+    ScanOptions options_;
+    Logger& logger_;
+    unsigned settleMs_;
+    std::string rootPrefix_;
+    std::unique_ptr<PathMatcher> prune_;  // ignore_patterns(options_)
+    int fd_{-1};
+    std::unordered_map<int, std::string> dirs_;  // watch descriptor -> directory ("" = root)
+    std::map<std::string, FileEntry> files_;
+    std::set<std::string> secretFiles_;
+    std::uintmax_t totalSize_{0};
+
+    // Pending changes since the last apply()
+    std::set<std::string> dirty_;        // files to re-examine
+    std::set<std::string> newDirs_;      // directories to watch and list
+    std::set<std::string> removedDirs_;  // directories whose entries go away
+    bool overflow_{false};
+};
+
+}  // namespace rogue
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace rogue
+{
+
+// Bounded lock-free multi-producer / single-consumer ring of text lines
+// (Vyukov's sequence-numbered cells). Each cell keeps its string's capacity
+// between laps, so steady-state pushes do not allocate.
+class LogRing
+{
+public:
+    explicit LogRing(std::size_t capacity)
+    {
+        std::size_t cap = 2;
+        while (cap < capacity)
+            cap <<= 1;
+        cells_.reset(new Cell[cap]);
+        mask_ = cap - 1;
+        for (std::size_t i = 0; i < cap; ++i)
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns false when the ring is full; the caller decides whether to retry.
+    bool try_push(std::string_view line)
+    {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell& cell = cells_[pos & mask_];
+            std::size_t seq = cell.seq.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    cell.line.assign(line.data(), line.size());
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Consumer side only: true when the next line is ready to drain.
+    bool ready() const
+    {
+        return cells_[tail_ & mask_].seq.load(std::memory_order_acquire) == tail_ + 1;
+    }
+
+    // Consumer side only. Calls fn(const std::string&) for up to max ready
+    // lines in FIFO order and returns how many were consumed.
+    template <typename Fn>
+    std::size_t drain(Fn&& fn, std::size_t max)
+    {
+        std::size_t n = 0;
+        while (n < max)
+        {
+            Cell& cell = cells_[tail_ & mask_];
+            if (cell.seq.load(std::memory_order_acquire) != tail_ + 1)
+                break;
+            fn(cell.line);
+            cell.seq.store(tail_ + mask_ + 1, std::memory_order_release);
+            ++tail_;
+            ++n;
+        }
+        return n;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<std::size_t> seq{0};
+        std::string line;
+    };
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::size_t tail_{0};
+};
+
+}  // namespace rogue
@@ -1,50 +1,276 @@
 #include "logger.hpp"
+#include "log_ring.hpp"
+#include "multi_matcher.hpp"
+#include "profiler.hpp"
 #include "utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <ctime>
+#include <cstring>
+#include <cstdio>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <chrono>
-#include "../../third_party/json.hpp"
 
 namespace fs = std::filesystem;
 
 namespace rogue
 {
 
-    Logger::Logger() { open(); }
+    namespace
+    {
+        constexpr std::size_t kDrainChunk = 1024;
+        constexpr std::size_t kIntervalSpill = 256 * 1024; // Interval: write early past this
+        constexpr std::size_t kBufferCap = 1024 * 1024;    // any policy: never buffer more
+    }
+
+    namespace
+    {
+        LogLevel level_from_env()
+        {
+            LogLevel level = LogLevel::Info;
+            parse_log_level(utils::getenv("ROGUE_LOG_LEVEL", ""), level);
+            return level;
+        }
+
+        std::atomic<LogLevel> &default_level_slot()
+        {
+            static std::atomic<LogLevel> level{level_from_env()};
+            return level;
+        }
+
+        std::mutex &default_masks_mutex()
+        {
+            static std::mutex mu;
+            return mu;
+        }
+
+        std::vector<std::string> &default_masks_slot() // guarded by default_masks_mutex()
+        {
+            static std::vector<std::string> extra;
+            return extra;
+        }
+    }
+
+    bool parse_log_level(const std::string &name, LogLevel &out)
+    {
+        if (name == "debug")
+            out = LogLevel::Debug;
+        else if (name == "info")
+            out = LogLevel::Info;
+        else if (name == "warn" || name == "warning")
+            out = LogLevel::Warn;
+        else if (name == "error")
+            out = LogLevel::Error;
+        else if (name == "off")
+            out = LogLevel::Off;
+        else
+            return false;
+        return true;
+    }
+
+    void Logger::set_default_level(LogLevel level) { default_level_slot().store(level); }
+    LogLevel Logger::default_level() { return default_level_slot().load(); }
+
+    LoggerOptions Logger::options_from_env()
+    {
+        LoggerOptions o;
+        auto mode = utils::getenv("ROGUE_LOG_FLUSH", "");
+        if (mode == "interval")
+            o.flush = LogFlush::Interval;
+        else if (mode == "shutdown")
+            o.flush = LogFlush::OnShutdown;
+        return o;
+    }
+
+    Logger::Logger() : Logger(options_from_env()) {}
+
+    Logger::Logger(const LoggerOptions &options) : options_(options), minLevel_(default_level()) { open(); }
+
     Logger::~Logger() { close(); }
 
-    void Logger::open() { ensure_log_dir(); }
-    void Logger::close() {}
+    void Logger::open()
+    {
+        ensure_log_dir();
+        file_ = std::fopen(options_.path.c_str(), "ab");
+        if (file_)
+            std::setvbuf(static_cast<std::FILE *>(file_), nullptr, _IONBF, 0); // batches are written whole
+        ring_ = std::make_unique<LogRing>(options_.ringCapacity);
+        std::vector<std::string> extra;
+        {
+            std::lock_guard<std::mutex> lk(default_masks_mutex());
+            extra = default_masks_slot();
+        }
+        set_mask_patterns(extra);
+        writer_ = std::thread([this]
+                              { writer_loop(); });
+    }
+
+    void Logger::close()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_.store(true);
+            wake_.notify_one();
+        }
+        if (writer_.joinable())
+            writer_.join();
+        if (file_)
+            std::fclose(static_cast<std::FILE *>(file_));
+        file_ = nullptr;
+    }
 
     void Logger::ensure_log_dir()
     {
-        fs::create_directories("logs");
+        auto dir = fs::path(options_.path).parent_path();
+        if (!dir.empty())
+        {
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+        }
+    }
+
+    const std::vector<std::string> &Logger::default_mask_patterns()
+    {
+        static const std::vector<std::string> patterns{"ghp_", "github_pat_", "token", "apikey", "secret"};
+        return patterns;
+    }
+
+    void Logger::set_default_mask_patterns(const std::vector<std::string> &extra)
+    {
+        std::lock_guard<std::mutex> lk(default_masks_mutex());
+        default_masks_slot() = extra;
     }
 
-    void Logger::mask_secrets_inplace(std::string &line)
+    void Logger::set_mask_patterns(const std::vector<std::string> &extra)
     {
-        // Very basic masking for tokens and keys
-        const char *patterns[] = {"ghp_", "github_pat_", "token", "apikey", "secret", nullptr};
-        for (int i = 0; patterns[i]; ++i)
+        auto patterns = default_mask_patterns();
+        patterns.insert(patterns.end(), extra.begin(), extra.end());
+        std::atomic_store(&masker_, std::shared_ptr<const MultiPatternMatcher>(std::make_shared<MultiPatternMatcher>(patterns)));
+    }
+
+    void Logger::mask_secrets_inplace(const MultiPatternMatcher &masker, std::string &buf, std::size_t from)
+    {
+        // One pass over buf[from, end) finds every occurrence of every pattern;
+        // windows are applied afterwards so masking one secret cannot hide the
+        // prefix of the next. maskStarts_ is only touched by the writer thread.
+        char *line = buf.data() + from;
+        const std::size_t len = buf.size() - from;
+        maskStarts_.clear();
+        masker.scan(line, len, [&](std::uint32_t id, std::size_t end)
+                    { maskStarts_.push_back(end - masker.pattern(id).size()); });
+        for (std::size_t start : maskStarts_)
         {
-            auto pos = utils::ifind(line, patterns[i]);
-            if (pos != std::string::npos)
+            const std::size_t stop = std::min(len, start + 32);
+            for (std::size_t j = start + 4; j < stop; ++j)
+                line[j] = '*';
+        }
+    }
+
+    void Logger::write_line(std::string_view line)
+    {
+        while (!ring_->try_push(line))
+        {
+            // Full: the writer is behind. Wake it and back off rather than drop lines.
             {
-                for (size_t j = pos + 4; j < line.size() && j < pos + 32; ++j)
-                    line[j] = '*';
+                std::lock_guard<std::mutex> lk(mu_);
+                wake_.notify_one();
             }
+            std::this_thread::yield();
         }
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writerIdle_.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            wake_.notify_one();
+        }
+    }
+
+    void Logger::write_out(std::string &batch)
+    {
+        if (file_ && !batch.empty())
+            std::fwrite(batch.data(), 1, batch.size(), static_cast<std::FILE *>(file_));
+        batch.clear();
+    }
+
+    void Logger::flush()
+    {
+        const auto target = enqueued_.load();
+        std::unique_lock<std::mutex> lk(mu_);
+        flushRequested_ = true;
+        wake_.notify_one();
+        flushed_.wait(lk, [&]
+                      { return written_ >= target; });
     }
 
-    void Logger::write_line(const std::string &line)
+    void Logger::writer_loop()
     {
-        std::ofstream f("logs/rogue.log", std::ios::app);
-        if (f)
+        std::string batch;
+        batch.reserve(64 * 1024);
+        std::shared_ptr<const MultiPatternMatcher> masker;
+        std::uint64_t buffered = 0; // lines in batch, not yet written
+        auto lastWrite = std::chrono::steady_clock::now();
+        const auto interval = std::chrono::milliseconds(options_.flushIntervalMs);
+        for (;;)
         {
-            std::string masked = line;
-            mask_secrets_inplace(masked);
-            f << masked << "\n";
+            masker = std::atomic_load(&masker_);
+            std::size_t n = ring_->drain([&](const std::string &line)
+                                         {
+                const std::size_t at = batch.size();
+                batch += line;
+                mask_secrets_inplace(*masker, batch, at);
+                batch += '\n'; },
+                                         kDrainChunk);
+            buffered += n;
+            const bool stopping = stop_.load();
+            const bool drained = n < kDrainChunk;
+            bool forced;
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                forced = flushRequested_;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            bool write = forced || (stopping && drained) || batch.size() >= kBufferCap;
+            switch (options_.flush)
+            {
+                case LogFlush::EveryBatch:
+                    write = write || drained;
+                    break;
+                case LogFlush::Interval:
+                    write = write || batch.size() >= kIntervalSpill || (drained && now - lastWrite >= interval);
+                    break;
+                case LogFlush::OnShutdown:
+                    break;
+            }
+            if (write && buffered > 0)
+            {
+                write_out(batch);
+                rotate_if_needed();
+                lastWrite = now;
+            }
+            if (write)
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                written_ += buffered;
+                buffered = 0;
+                if (forced && drained)
+                    flushRequested_ = false;
+                flushed_.notify_all();
+            }
+            if (stopping && drained)
+                return;
+            if (!drained)
+                continue;
+
+            std::unique_lock<std::mutex> lk(mu_);
+            writerIdle_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto timeout = buffered > 0 && options_.flush == LogFlush::Interval ? interval : std::chrono::milliseconds(500);
+            wake_.wait_for(lk, timeout, [&]
+                           { return stop_.load() || flushRequested_ || ring_->ready(); });
+            writerIdle_.store(false);
         }
     }
 
@@ -53,24 +279,105 @@ namespace rogue
         // simple no-op for now
     }
 
-    void Logger::log(const std::string &level, const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv)
+    void Logger::log(LogLevel level, std::string_view ctx, std::string_view msg, const LogField *const *fields, std::size_t n)
     {
-        nlohmann::json j;
-        j["ts"] = utils::iso_timestamp();
-        j["level"] = level;
-        j["ctx"] = ctx;
-        j["msg"] = msg;
-        for (auto &p : kv)
-            j[p.first] = p.second;
-        auto line = j.dump();
-        // console readable
-        std::cout << '[' << level << "] " << ctx << ": " << msg << std::endl;
+        ProfileScope scope(Phase::Log);
+        static const char *names[] = {"debug", "info", "warn", "error", "off"};
+        const char *lvl = names[static_cast<int>(level)];
+        // Reused per thread: steady-state logging does not touch the allocator.
+        thread_local std::string line;
+        thread_local std::string console;
+        thread_local std::time_t tsSecond = -1;
+        thread_local char ts[32];
+
+        std::time_t now = std::time(nullptr);
+        if (now != tsSecond)
+        {
+            utils::format_local_time(now, ts, sizeof(ts));
+            tsSecond = now;
+        }
+
+        line.assign("{\"ts\":\"");
+        line += ts;
+        line += "\",\"level\":\"";
+        line += lvl;
+        line += "\",\"ctx\":";
+        utils::append_json_string(line, ctx);
+        line += ",\"msg\":";
+        utils::append_json_string(line, msg);
+
+        // console readable; one write per line so concurrent callers do not interleave
+        console.assign("[");
+        console += lvl;
+        console += "] ";
+        console += ctx;
+        console += ": ";
+        console += msg;
+
+        char num[24];
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            const LogField &f = *fields[k];
+            line += ',';
+            utils::append_json_string(line, f.key);
+            line += ':';
+            console += ' ';
+            console += f.key;
+            console += '=';
+            switch (f.kind)
+            {
+                case LogField::Kind::Str:
+                    utils::append_json_string(line, f.str);
+                    console += f.str;
+                    break;
+                case LogField::Kind::Int:
+                case LogField::Kind::Uint:
+                {
+                    auto res = f.kind == LogField::Kind::Int ? std::to_chars(num, num + sizeof(num), f.i) : std::to_chars(num, num + sizeof(num), f.u);
+                    line.append(num, res.ptr);
+                    console.append(num, res.ptr);
+                    break;
+                }
+                case LogField::Kind::Bool:
+                    line += f.b ? "true" : "false";
+                    console += f.b ? "true" : "false";
+                    break;
+            }
+        }
+        line += '}';
+        console += '\n';
+        (consoleStderr_.load(std::memory_order_relaxed) ? std::cerr : std::cout) << console;
         write_line(line);
     }
 
-    void Logger::info(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv) { log("info", ctx, msg, kv); }
-    void Logger::warn(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv) { log("warn", ctx, msg, kv); }
-    void Logger::error(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv) { log("error", ctx, msg, kv); }
-    void Logger::debug(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv) { log("debug", ctx, msg, kv); }
+    void Logger::log_map(LogLevel level, std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv)
+    {
+        if (!enabled(level))
+            return;
+        std::vector<LogField> storage;
+        storage.reserve(kv.size());
+        std::vector<const LogField *> ptrs;
+        ptrs.reserve(kv.size());
+        for (auto &p : kv)
+        {
+            storage.emplace_back(p.first, p.second);
+            ptrs.push_back(&storage.back());
+        }
+        log(level, ctx, msg, ptrs.data(), ptrs.size());
+    }
+
+    void Logger::info(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv) { log_map(LogLevel::Info, ctx, msg, kv); }
+    void Logger::warn(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv) { log_map(LogLevel::Warn, ctx, msg, kv); }
+    void Logger::error(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv) { log_map(LogLevel::Error, ctx, msg, kv); }
+    void Logger::debug(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv)
+    {
+#if ROGUE_LOG_COMPILE_LEVEL <= 0
+        log_map(LogLevel::Debug, ctx, msg, kv);
+#else
+        (void)ctx;
+        (void)msg;
+        (void)kv;
+#endif
+    }
 
 }
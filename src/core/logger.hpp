@@ -1,30 +1,192 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <vector>
-#include <map>
+
+// Calls below this level are compiled out entirely (0 debug, 1 info, 2 warn,
+// 3 error). Release builds drop debug unless told otherwise.
+#ifndef ROGUE_LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define ROGUE_LOG_COMPILE_LEVEL 1
+#else
+#define ROGUE_LOG_COMPILE_LEVEL 0
+#endif
+#endif
 
 namespace rogue
 {
 
+    class LogRing;
+    class MultiPatternMatcher;
+
+    enum class LogLevel
+    {
+        Debug = 0,
+        Info = 1,
+        Warn = 2,
+        Error = 3,
+        Off = 4
+    };
+
+    bool parse_log_level(const std::string &name, LogLevel &out);
+
+    // A structured key/value pair that borrows its key and string value, so
+    // building one never allocates. Only valid for the duration of the call.
+    struct LogField
+    {
+        enum class Kind
+        {
+            Str,
+            Int,
+            Uint,
+            Bool
+        };
+
+        LogField(std::string_view k, std::string_view v) : key(k), kind(Kind::Str), str(v) {}
+        LogField(std::string_view k, const char *v) : key(k), kind(Kind::Str), str(v) {}
+        LogField(std::string_view k, const std::string &v) : key(k), kind(Kind::Str), str(v) {}
+        LogField(std::string_view k, bool v) : key(k), kind(Kind::Bool), b(v) {}
+        template <typename T, std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value, int> = 0>
+        LogField(std::string_view k, T v) : key(k), kind(Kind::Int), i(v)
+        {
+        }
+        template <typename T, std::enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value, int> = 0>
+        LogField(std::string_view k, T v) : key(k), kind(Kind::Uint), u(v)
+        {
+        }
+
+        std::string_view key;
+        Kind kind;
+        std::string_view str;
+        std::int64_t i{0};
+        std::uint64_t u{0};
+        bool b{false};
+    };
+
+    // When buffered log lines are handed to the kernel.
+    enum class LogFlush
+    {
+        EveryBatch, // as soon as the writer has drained what is queued (default)
+        Interval,   // at most every flushIntervalMs, or when the buffer grows large
+        OnShutdown  // only when the buffer grows large and when the Logger is destroyed
+    };
+
+    struct LoggerOptions
+    {
+        std::string path{"logs/rogue.log"};
+        LogFlush flush{LogFlush::EveryBatch};
+        unsigned flushIntervalMs{200};
+        std::size_t ringCapacity{4096};
+    };
+
+    // Lines are formatted on the calling thread and queued on a lock-free ring;
+    // one background thread keeps the log file open and writes them in batches.
+    // Safe to call from any number of threads. The destructor drains the queue.
+    //
+    // Level checks happen before any formatting. The field overloads, e.g.
+    //   logger.debug("scan", "ignored", LogField("path", rel));
+    // encode straight into a per-thread buffer and do not allocate once warm.
     class Logger
     {
     public:
         Logger();
+        explicit Logger(const LoggerOptions &options);
         ~Logger();
-        void info(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv = {});
-        void warn(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv = {});
-        void error(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv = {});
-        void debug(const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv = {});
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
+
+        template <typename... F>
+        void debug(std::string_view ctx, std::string_view msg, const F &...fields) { log_fields<LogLevel::Debug>(ctx, msg, fields...); }
+        template <typename... F>
+        void info(std::string_view ctx, std::string_view msg, const F &...fields) { log_fields<LogLevel::Info>(ctx, msg, fields...); }
+        template <typename... F>
+        void warn(std::string_view ctx, std::string_view msg, const F &...fields) { log_fields<LogLevel::Warn>(ctx, msg, fields...); }
+        template <typename... F>
+        void error(std::string_view ctx, std::string_view msg, const F &...fields) { log_fields<LogLevel::Error>(ctx, msg, fields...); }
+
+        void info(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv);
+        void warn(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv);
+        void error(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv);
+        void debug(std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv);
+
+        bool enabled(LogLevel level) const
+        {
+            return static_cast<int>(level) >= ROGUE_LOG_COMPILE_LEVEL && level >= minLevel_.load(std::memory_order_relaxed);
+        }
+        void set_min_level(LogLevel level) { minLevel_.store(level, std::memory_order_relaxed); }
+        // Console lines go to stdout unless a command's own output owns it.
+        void set_console_to_stderr(bool on) { consoleStderr_.store(on, std::memory_order_relaxed); }
+
+        // Blocks until every line logged before the call is in the file.
+        void flush();
+
+        // Level new Loggers start with: --log-level, else ROGUE_LOG_LEVEL, else info.
+        static void set_default_level(LogLevel level);
+        static LogLevel default_level();
+
+        // Secret masking: every case-insensitive occurrence of a pattern has the
+        // bytes from its 5th character up to 32 past its start replaced by '*'.
+        // The extra patterns (config key mask_patterns) add to the built-in set;
+        // safe to call while other threads are logging.
+        void set_mask_patterns(const std::vector<std::string> &extra);
+        static const std::vector<std::string> &default_mask_patterns();
+        // Extra patterns new Loggers start with (the config's mask_patterns).
+        static void set_default_mask_patterns(const std::vector<std::string> &extra);
+
+        // Reads ROGUE_LOG_FLUSH (batch|interval|shutdown) on top of the defaults.
+        static LoggerOptions options_from_env();
 
     private:
-        void log(const std::string &level, const std::string &ctx, const std::string &msg, const std::map<std::string, std::string> &kv);
+        template <LogLevel L, typename... F>
+        void log_fields(std::string_view ctx, std::string_view msg, const F &...fields)
+        {
+            if constexpr (static_cast<int>(L) < ROGUE_LOG_COMPILE_LEVEL)
+                return;
+            else
+            {
+                static_assert((std::is_same<F, LogField>::value && ...), "log fields must be LogField");
+                if (!enabled(L))
+                    return;
+                const LogField *arr[sizeof...(F) + 1] = {&fields..., nullptr};
+                log(L, ctx, msg, arr, sizeof...(F));
+            }
+        }
+
+        void log(LogLevel level, std::string_view ctx, std::string_view msg, const LogField *const *fields, std::size_t n);
+        void log_map(LogLevel level, std::string_view ctx, std::string_view msg, const std::map<std::string, std::string> &kv);
         void open();
         void close();
         void ensure_log_dir();
-        void write_line(const std::string &line);
+        void write_line(std::string_view line);
         void rotate_if_needed();
-        void mask_secrets_inplace(std::string &line);
+        void mask_secrets_inplace(const MultiPatternMatcher &masker, std::string &buf, std::size_t from);
+        void writer_loop();
+        void write_out(std::string &batch);
+
+        LoggerOptions options_;
+        std::atomic<LogLevel> minLevel_;
+        std::atomic<bool> consoleStderr_{false};
         void *file_{nullptr};
+        std::unique_ptr<LogRing> ring_;
+        std::shared_ptr<const MultiPatternMatcher> masker_; // std::atomic_load/store
+        std::vector<std::size_t> maskStarts_; // writer thread scratch
+        std::thread writer_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> writerIdle_{false};
+        std::atomic<std::uint64_t> enqueued_{0};
+        std::uint64_t written_{0}; // guarded by mu_
+        bool flushRequested_{false}; // guarded by mu_
+        std::mutex mu_;
+        std::condition_variable wake_;
+        std::condition_variable flushed_;
     };
 
 }
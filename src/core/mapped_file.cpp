@@ -0,0 +1,77 @@
+#include "mapped_file.hpp"
+
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rogue
+{
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (mapped_)
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+#endif
+    mapped_ = false;
+    owned_.clear();
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool MappedFile::open(const std::string& file, std::string* error, [[maybe_unused]] bool sequential)
+{
+    close();
+    auto fail = [&](const std::string& what)
+    {
+        if (error)
+            *error = what;
+        return false;
+    };
+#ifndef _WIN32
+    const int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return fail("cannot open " + file);
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return fail("cannot stat " + file);
+    }
+    if (st.st_size == 0)
+    {
+        ::close(fd);
+        return true;  // mmap rejects empty files
+    }
+    void* p = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        return fail("cannot map " + file);
+    if (sequential)
+        ::madvise(p, std::size_t(st.st_size), MADV_SEQUENTIAL);
+    data_ = static_cast<const std::uint8_t*>(p);
+    size_ = std::size_t(st.st_size);
+    mapped_ = true;
+#else
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return fail("cannot open " + file);
+    owned_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = owned_.data();
+    size_ = owned_.size();
+#endif
+    return true;
+}
+
+}  // namespace rogue
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rogue
+{
+
+// Read-only view of a whole file: mmap where available, otherwise read into
+// memory. `sequential` tells the kernel the file is read front to back.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& file, std::string* error = nullptr, bool sequential = false);
+    void close();
+
+    const std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(reinterpret_cast<const char*>(data_), size_); }
+
+private:
+    const std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    bool mapped_{false};
+    std::vector<std::uint8_t> owned_;
+};
+
+}  // namespace rogue
@@ -0,0 +1,103 @@
+#include "multi_matcher.hpp"
+
+#include <cctype>
+#include <queue>
+
+namespace rogue
+{
+
+MultiPatternMatcher::MultiPatternMatcher(const std::vector<std::string>& patterns,
+                                         bool caseInsensitive)
+{
+    for (auto& p : patterns)
+    {
+        if (!p.empty())
+            patterns_.push_back(p);
+    }
+    if (patterns_.empty())
+        return;
+
+    auto fold = [&](unsigned char c) -> unsigned char
+    { return caseInsensitive ? static_cast<unsigned char>(std::tolower(c)) : c; };
+
+    // Byte classes: one per distinct (folded) pattern byte, 0 for the rest.
+    for (auto& p : patterns_)
+    {
+        for (unsigned char c : p)
+        {
+            unsigned char f = fold(c);
+            if (classOf_[f] == 0)
+                classOf_[f] = static_cast<std::uint8_t>(classes_++);
+        }
+    }
+    if (caseInsensitive)
+    {
+        for (int c = 0; c < 256; ++c)
+            classOf_[c] = classOf_[fold(static_cast<unsigned char>(c))];
+    }
+
+    // Trie with -1 for missing edges, then BFS to fill failure transitions.
+    const std::uint32_t none = UINT32_MAX;
+    std::vector<std::uint32_t> go(classes_, none);
+    std::vector<std::vector<std::uint32_t>> out(1);
+    for (std::uint32_t id = 0; id < patterns_.size(); ++id)
+    {
+        std::uint32_t s = 0;
+        for (unsigned char c : patterns_[id])
+        {
+            auto& edge = go[s * classes_ + classOf_[c]];
+            if (edge == none)
+            {
+                edge = static_cast<std::uint32_t>(out.size());
+                out.emplace_back();
+                go.resize(go.size() + classes_, none);
+            }
+            s = go[s * classes_ + classOf_[c]];
+        }
+        out[s].push_back(id);
+    }
+
+    const std::size_t states = out.size();
+    delta_.assign(states * classes_, 0);
+    std::vector<std::uint32_t> fail(states, 0);
+    std::queue<std::uint32_t> q;
+    for (std::uint32_t c = 0; c < classes_; ++c)
+    {
+        std::uint32_t t = go[c];
+        if (t != none && c != 0)
+        {
+            delta_[c] = t;
+            q.push(t);
+        }
+    }
+    while (!q.empty())
+    {
+        std::uint32_t s = q.front();
+        q.pop();
+        auto& inherited = out[fail[s]];
+        out[s].insert(out[s].end(), inherited.begin(), inherited.end());
+        for (std::uint32_t c = 0; c < classes_; ++c)
+        {
+            std::uint32_t t = go[s * classes_ + c];
+            if (t != none && c != 0)
+            {
+                fail[t] = delta_[fail[s] * classes_ + c];
+                delta_[s * classes_ + c] = t;
+                q.push(t);
+            }
+            else
+            {
+                delta_[s * classes_ + c] = delta_[fail[s] * classes_ + c];
+            }
+        }
+    }
+
+    outBegin_.assign(states + 1, 0);
+    for (std::size_t s = 0; s < states; ++s)
+    {
+        outBegin_[s + 1] = outBegin_[s] + static_cast<std::uint32_t>(out[s].size());
+        outIds_.insert(outIds_.end(), out[s].begin(), out[s].end());
+    }
+}
+
+}  // namespace rogue
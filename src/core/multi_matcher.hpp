@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rogue
+{
+
+// Aho-Corasick automaton compiled to a dense DFA over byte classes: bytes
+// that appear in no pattern share class 0, so the transition table stays a
+// few KB even with dozens of patterns. Optionally ASCII case-insensitive.
+//
+// One pass over the input reports every occurrence of every pattern,
+// including overlapping ones. The state can be carried across calls to
+// scan a stream in chunks.
+class MultiPatternMatcher
+{
+public:
+    MultiPatternMatcher() = default;
+    explicit MultiPatternMatcher(const std::vector<std::string>& patterns,
+                                 bool caseInsensitive = true);
+
+    bool empty() const { return patterns_.empty(); }
+    std::size_t pattern_count() const { return patterns_.size(); }
+    const std::string& pattern(std::size_t id) const { return patterns_[id]; }
+
+    // Calls onMatch(patternId, endOffset) where endOffset is the index one
+    // past the last byte of the match within [data, data + len). Returns the
+    // state to pass to the next call when scanning a stream.
+    template <typename Fn>
+    std::uint32_t scan(const char* data, std::size_t len, Fn&& onMatch,
+                       std::uint32_t state = 0) const
+    {
+        if (patterns_.empty())
+            return 0;
+        const auto* p = reinterpret_cast<const unsigned char*>(data);
+        std::size_t i = 0;
+        while (i < len)
+        {
+            if (state == 0)
+            {
+                // Fast skip over bytes that cannot start or continue a match.
+                while (i < len && classOf_[p[i]] == 0)
+                    ++i;
+                if (i == len)
+                    break;
+            }
+            state = delta_[state * classes_ + classOf_[p[i]]];
+            ++i;
+            if (outBegin_[state] != outBegin_[state + 1])
+            {
+                for (std::uint32_t k = outBegin_[state]; k < outBegin_[state + 1]; ++k)
+                    onMatch(outIds_[k], i);
+            }
+        }
+        return state;
+    }
+
+private:
+    std::vector<std::string> patterns_;
+    std::uint8_t classOf_[256] = {};
+    std::uint32_t classes_{1};
+    std::vector<std::uint32_t> delta_;     // state * classes_ + class -> state
+    std::vector<std::uint32_t> outBegin_;  // CSR index into outIds_, size states + 1
+    std::vector<std::uint32_t> outIds_;
+};
+
+}  // namespace rogue
@@ -0,0 +1,87 @@
+#include "object_store.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+std::uint32_t be32(const std::uint8_t* p)
+{
+    return std::uint32_t(p[0]) << 24 | std::uint32_t(p[1]) << 16 | std::uint32_t(p[2]) << 8 | p[3];
+}
+
+}  // namespace
+
+ObjectStore::ObjectStore(std::string objectsDir) : dir_(std::move(objectsDir))
+{
+    std::error_code ec;
+    for (fs::directory_iterator it(fs::path(dir_) / "pack", ec), end; !ec && it != end; it.increment(ec))
+    {
+        if (it->path().extension() != ".idx")
+            continue;
+        std::ifstream in(it->path(), std::ios::binary);
+        PackIndex idx;
+        idx.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        const auto& d = idx.data;
+        if (d.size() >= 8 && d[0] == 0xFF && d[1] == 't' && d[2] == 'O' && d[3] == 'c')
+        {
+            if (be32(d.data() + 4) != 2)
+                continue;
+            idx.fanout = 8;
+            idx.ids = 8 + 1024;
+            idx.stride = 20;
+        }
+        else
+        {
+            idx.fanout = 0;
+            idx.ids = 1024 + 4;
+            idx.stride = 24;
+        }
+        if (d.size() < idx.fanout + 1024)
+            continue;
+        const std::uint32_t count = be32(d.data() + idx.fanout + 255 * 4);
+        if (d.size() < idx.ids + std::size_t(count) * idx.stride)
+            continue;
+        packs_.push_back(std::move(idx));
+    }
+}
+
+bool ObjectStore::contains(const PackIndex& idx, const ObjectId& id)
+{
+    const std::uint8_t* fan = idx.data.data() + idx.fanout;
+    std::uint32_t lo = id[0] ? be32(fan + (id[0] - 1) * 4) : 0;
+    std::uint32_t hi = be32(fan + id[0] * 4);
+    while (lo < hi)
+    {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        const int c = std::memcmp(idx.data.data() + idx.ids + std::size_t(mid) * idx.stride, id.data(), 20);
+        if (c == 0)
+            return true;
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return false;
+}
+
+bool ObjectStore::has(const ObjectId& id) const
+{
+    for (auto& p : packs_)
+    {
+        if (contains(p, id))
+            return true;
+    }
+    const std::string hex = Sha1::to_hex(id);
+    std::error_code ec;
+    return fs::exists(fs::path(dir_) / hex.substr(0, 2) / hex.substr(2), ec);
+}
+
+}  // namespace rogue
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pack_writer.hpp"
+
+namespace rogue
+{
+
+// Read-only existence checks against a git object directory: loose objects
+// and every pack .idx (v1 or v2) present when constructed. Does not follow
+// alternates.
+class ObjectStore
+{
+public:
+    explicit ObjectStore(std::string objectsDir);
+
+    bool has(const ObjectId& id) const;
+    std::size_t pack_count() const { return packs_.size(); }
+
+private:
+    struct PackIndex
+    {
+        std::vector<std::uint8_t> data;
+        std::size_t fanout;   // offset of the 256-entry fan-out table
+        std::size_t ids;      // offset of the first object id
+        std::size_t stride;   // bytes between ids (20 in v2, 24 in v1)
+    };
+
+    static bool contains(const PackIndex& idx, const ObjectId& id);
+
+    std::string dir_;
+    std::vector<PackIndex> packs_;
+};
+
+}  // namespace rogue
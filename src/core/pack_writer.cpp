@@ -0,0 +1,471 @@
+#include "pack_writer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+#include <sys/stat.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+struct Crc32Table
+{
+    std::uint32_t t[256];
+    Crc32Table()
+    {
+        for (std::uint32_t i = 0; i < 256; ++i)
+        {
+            std::uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+    }
+};
+
+std::uint32_t crc32_update(std::uint32_t crc, const std::uint8_t* p, std::size_t n)
+{
+    static const Crc32Table table;
+    crc = ~crc;
+    for (std::size_t i = 0; i < n; ++i)
+        crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void put_be32(std::uint8_t* p, std::uint32_t v)
+{
+    p[0] = std::uint8_t(v >> 24);
+    p[1] = std::uint8_t(v >> 16);
+    p[2] = std::uint8_t(v >> 8);
+    p[3] = std::uint8_t(v);
+}
+
+// Appends a zlib stream of everything written to out.
+class Deflater
+{
+public:
+    Deflater(int level, std::vector<std::uint8_t>& out) : out_(out)
+    {
+#ifdef HAVE_ZLIB
+        std::memset(&zs_, 0, sizeof(zs_));
+        deflateInit(&zs_, level);
+#else
+        (void)level;
+        out_.push_back(0x78);
+        out_.push_back(0x01);
+#endif
+    }
+
+    void write(const std::uint8_t* p, std::size_t n)
+    {
+#ifdef HAVE_ZLIB
+        zs_.next_in = const_cast<Bytef*>(p);
+        zs_.avail_in = static_cast<uInt>(n);
+        run(Z_NO_FLUSH);
+#else
+        adlerA_ = adler(p, n);
+        while (n)
+        {
+            const std::size_t len = std::min<std::size_t>(n, 0xFFFF);
+            stored_block(p, len, false);
+            p += len;
+            n -= len;
+        }
+#endif
+    }
+
+    void finish()
+    {
+#ifdef HAVE_ZLIB
+        zs_.next_in = nullptr;
+        zs_.avail_in = 0;
+        run(Z_FINISH);
+        deflateEnd(&zs_);
+#else
+        stored_block(nullptr, 0, true);
+        std::uint8_t a[4];
+        put_be32(a, adlerA_);
+        out_.insert(out_.end(), a, a + 4);
+#endif
+    }
+
+private:
+#ifdef HAVE_ZLIB
+    void run(int flush)
+    {
+        for (;;)
+        {
+            const std::size_t at = out_.size();
+            const std::size_t room = std::max<std::size_t>(deflateBound(&zs_, zs_.avail_in), 4096);
+            out_.resize(at + room);
+            zs_.next_out = out_.data() + at;
+            zs_.avail_out = static_cast<uInt>(room);
+            int rc = deflate(&zs_, flush);
+            out_.resize(at + room - zs_.avail_out);
+            if (flush == Z_FINISH ? rc == Z_STREAM_END : (zs_.avail_in == 0 && zs_.avail_out != 0))
+                return;
+            if (rc != Z_OK && rc != Z_BUF_ERROR)
+                return;
+        }
+    }
+    z_stream zs_;
+#else
+    std::uint32_t adler(const std::uint8_t* p, std::size_t n)
+    {
+        std::uint32_t a = adlerA_ & 0xFFFF, b = adlerA_ >> 16;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            a = (a + p[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return (b << 16) | a;
+    }
+    void stored_block(const std::uint8_t* p, std::size_t len, bool final)
+    {
+        out_.push_back(final ? 1 : 0);
+        out_.push_back(std::uint8_t(len));
+        out_.push_back(std::uint8_t(len >> 8));
+        out_.push_back(std::uint8_t(~len));
+        out_.push_back(std::uint8_t(~len >> 8));
+        if (len)
+            out_.insert(out_.end(), p, p + len);
+    }
+    std::uint32_t adlerA_{1};
+#endif
+    std::vector<std::uint8_t>& out_;
+};
+
+const char* type_name(ObjectType t)
+{
+    switch (t)
+    {
+        case ObjectType::Commit:
+            return "commit";
+        case ObjectType::Tree:
+            return "tree";
+        default:
+            return "blob";
+    }
+}
+
+// "<type> <size>\0", the prefix hashed into every object id.
+std::string object_header(ObjectType type, std::uint64_t size)
+{
+    std::string h = type_name(type);
+    h += ' ';
+    h += std::to_string(size);
+    h.push_back('\0');
+    return h;
+}
+
+// Pack entry header: type and size, 4 then 7 bits per byte, low bits first.
+void pack_header(std::vector<std::uint8_t>& out, ObjectType type, std::uint64_t size)
+{
+    std::uint8_t c = std::uint8_t((std::uint8_t(type) << 4) | (size & 15));
+    size >>= 4;
+    while (size)
+    {
+        out.push_back(c | 0x80);
+        c = size & 0x7F;
+        size >>= 7;
+    }
+    out.push_back(c);
+}
+
+std::string temp_suffix()
+{
+    static std::atomic<unsigned> counter{0};
+    auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+    return std::to_string(now) + "_" + std::to_string(counter.fetch_add(1));
+}
+
+}  // namespace
+
+PackWriter::PackWriter(std::string packDir, int level) : dir_(std::move(packDir)), level_(level)
+{
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    const auto suffix = temp_suffix();
+    tmpPack_ = (fs::path(dir_) / ("tmp_pack_" + suffix)).string();
+    tmpIdx_ = (fs::path(dir_) / ("tmp_idx_" + suffix)).string();
+    file_ = std::fopen(tmpPack_.c_str(), "w+b");
+    if (!file_)
+        return;
+    const std::uint8_t header[12] = {'P', 'A', 'C', 'K', 0, 0, 0, 2, 0, 0, 0, 0};  // count patched by finish()
+    failed_ = std::fwrite(header, 1, sizeof(header), file_) != sizeof(header);
+    offset_ = sizeof(header);
+}
+
+PackWriter::~PackWriter()
+{
+    if (file_)
+        std::fclose(file_);
+    if (!finished_)
+        remove_temps();
+}
+
+void PackWriter::remove_temps()
+{
+    std::error_code ec;
+    fs::remove(tmpPack_, ec);
+    fs::remove(tmpIdx_, ec);
+}
+
+std::size_t PackWriter::object_count() const
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    return entries_.size();
+}
+
+void PackWriter::append(const ObjectId& oid, const std::vector<std::uint8_t>& record)
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!file_ || failed_)
+        return;
+    if (!seen_.insert(std::string(oid.begin(), oid.end())).second)
+        return;
+    if (std::fwrite(record.data(), 1, record.size(), file_) != record.size())
+    {
+        failed_ = true;
+        return;
+    }
+    entries_.push_back(Entry{oid, crc32_update(0, record.data(), record.size()), offset_});
+    offset_ += record.size();
+}
+
+ObjectId PackWriter::add(ObjectType type, const void* data, std::size_t len)
+{
+    const auto header = object_header(type, len);
+    Sha1 sha;
+    sha.update(header.data(), header.size());
+    sha.update(data, len);
+    const ObjectId oid = sha.finish();
+
+    std::vector<std::uint8_t> record;
+    record.reserve(len / 2 + 64);
+    pack_header(record, type, len);
+    Deflater z(level_, record);
+    z.write(static_cast<const std::uint8_t*>(data), len);
+    z.finish();
+    append(oid, record);
+    return oid;
+}
+
+bool PackWriter::add_file(const std::string& path, ObjectId& oid, bool& executable)
+{
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    std::setvbuf(f, nullptr, _IONBF, 0);
+    std::uint64_t size = 0;
+    executable = false;
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_fstat64(_fileno(f), &st) == 0)
+        size = std::uint64_t(st.st_size);
+#else
+    struct stat st;
+    if (::fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        std::fclose(f);
+        return false;
+    }
+    size = std::uint64_t(st.st_size);
+    executable = (st.st_mode & S_IXUSR) != 0;
+#endif
+    const auto header = object_header(ObjectType::Blob, size);
+    Sha1 sha;
+    sha.update(header.data(), header.size());
+    std::vector<std::uint8_t> record;
+    record.reserve(std::size_t(std::min<std::uint64_t>(size, 1 << 20)) + 64);
+    pack_header(record, ObjectType::Blob, size);
+    Deflater z(level_, record);
+    std::uint8_t buf[64 * 1024];
+    std::uint64_t total = 0;
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    {
+        sha.update(buf, n);
+        z.write(buf, n);
+        total += n;
+    }
+    const bool readError = std::ferror(f) != 0;
+    std::fclose(f);
+    z.finish();
+    // A file that changed size under us would make the header lie.
+    if (readError || total != size)
+        return false;
+    oid = sha.finish();
+    append(oid, record);
+    return true;
+}
+
+bool PackWriter::finish(std::string* packName)
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!file_ || failed_)
+        return false;
+
+    std::uint8_t count[4];
+    put_be32(count, std::uint32_t(entries_.size()));
+    Sha1 packSum;
+    bool good = std::fseek(file_, 8, SEEK_SET) == 0 && std::fwrite(count, 1, 4, file_) == 4 &&
+                std::fflush(file_) == 0 && std::fseek(file_, 0, SEEK_SET) == 0;
+    std::vector<std::uint8_t> buf(1 << 20);
+    std::size_t n;
+    while (good && (n = std::fread(buf.data(), 1, buf.size(), file_)) > 0)
+        packSum.update(buf.data(), n);
+    const ObjectId trailer = packSum.finish();
+    good = good && !std::ferror(file_) && std::fseek(file_, 0, SEEK_END) == 0 &&
+           std::fwrite(trailer.data(), 1, trailer.size(), file_) == trailer.size();
+    good = std::fclose(file_) == 0 && good;
+    file_ = nullptr;
+    if (!good)
+        return false;
+
+    // Index v2: fan-out, sorted ids, CRCs, 31-bit offsets (+ 64-bit table).
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) { return a.oid < b.oid; });
+    std::FILE* idx = std::fopen(tmpIdx_.c_str(), "wb");
+    if (!idx)
+        return false;
+    Sha1 idxSum;
+    bool idxGood = true;
+    auto put = [&](const void* p, std::size_t len)
+    {
+        idxSum.update(p, len);
+        idxGood = idxGood && std::fwrite(p, 1, len, idx) == len;
+    };
+    auto put32 = [&](std::uint32_t v)
+    {
+        std::uint8_t b[4];
+        put_be32(b, v);
+        put(b, 4);
+    };
+    const std::uint8_t magic[8] = {0xFF, 't', 'O', 'c', 0, 0, 0, 2};
+    put(magic, sizeof(magic));
+    std::uint32_t fan = 0;
+    std::size_t e = 0;
+    for (int b = 0; b < 256; ++b)
+    {
+        while (e < entries_.size() && entries_[e].oid[0] == b)
+        {
+            ++fan;
+            ++e;
+        }
+        put32(fan);
+    }
+    for (auto& en : entries_)
+        put(en.oid.data(), en.oid.size());
+    for (auto& en : entries_)
+        put32(en.crc);
+    std::vector<std::uint64_t> large;
+    for (auto& en : entries_)
+    {
+        if (en.offset < 0x80000000ull)
+            put32(std::uint32_t(en.offset));
+        else
+        {
+            put32(0x80000000u | std::uint32_t(large.size()));
+            large.push_back(en.offset);
+        }
+    }
+    for (auto off : large)
+    {
+        put32(std::uint32_t(off >> 32));
+        put32(std::uint32_t(off));
+    }
+    put(trailer.data(), trailer.size());
+    const ObjectId idxTrailer = idxSum.finish();
+    idxGood = idxGood && std::fwrite(idxTrailer.data(), 1, idxTrailer.size(), idx) == idxTrailer.size();
+    idxGood = std::fclose(idx) == 0 && idxGood;
+    if (!idxGood)
+        return false;
+
+    // The .idx is what makes a pack visible, so it goes last.
+    const std::string name = "pack-" + Sha1::to_hex(trailer);
+    std::error_code ec;
+    fs::rename(tmpPack_, fs::path(dir_) / (name + ".pack"), ec);
+    if (ec)
+        return false;
+    fs::rename(tmpIdx_, fs::path(dir_) / (name + ".idx"), ec);
+    if (ec)
+    {
+        fs::remove(fs::path(dir_) / (name + ".pack"), ec);
+        return false;
+    }
+    finished_ = true;
+    if (packName)
+        *packName = name;
+    return true;
+}
+
+namespace
+{
+
+struct TreeNode
+{
+    std::map<std::string, TreeNode> dirs;
+    std::vector<std::pair<std::string, const TreeFile*>> files;
+};
+
+ObjectId write_node(PackWriter& pack, const TreeNode& node)
+{
+    struct Item
+    {
+        std::string key;  // git orders directories as if named "name/"
+        const char* mode;
+        const std::string* name;
+        ObjectId oid;
+    };
+    std::vector<Item> items;
+    items.reserve(node.dirs.size() + node.files.size());
+    for (auto& d : node.dirs)
+        items.push_back(Item{d.first + "/", "40000", &d.first, write_node(pack, d.second)});
+    for (auto& f : node.files)
+        items.push_back(Item{f.first, f.second->symlink ? "120000" : f.second->executable ? "100755" : "100644", &f.first, f.second->oid});
+    std::sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return a.key < b.key; });
+    std::string body;
+    for (auto& it : items)
+    {
+        body += it.mode;
+        body += ' ';
+        body += *it.name;
+        body.push_back('\0');
+        body.append(reinterpret_cast<const char*>(it.oid.data()), it.oid.size());
+    }
+    return pack.add(ObjectType::Tree, body.data(), body.size());
+}
+
+}  // namespace
+
+ObjectId write_trees(PackWriter& pack, const std::vector<TreeFile>& files)
+{
+    TreeNode root;
+    for (auto& f : files)
+    {
+        TreeNode* node = &root;
+        std::size_t start = 0, slash;
+        while ((slash = f.path.find('/', start)) != std::string::npos)
+        {
+            node = &node->dirs[f.path.substr(start, slash - start)];
+            start = slash + 1;
+        }
+        node->files.emplace_back(f.path.substr(start), &f);
+    }
+    return write_node(pack, root);
+}
+
+}  // namespace rogue
@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "sha1.hpp"
+
+namespace rogue
+{
+
+using ObjectId = Sha1::Digest;
+
+enum class ObjectType : std::uint8_t
+{
+    Commit = 1,
+    Tree = 2,
+    Blob = 3
+};
+
+// Builds one git packfile (v2) and its index (v2) without going through git.
+// add/add_file may be called from many threads: hashing and deflating run on
+// the caller's thread and only the append to the pack is serialized. Objects
+// are written whole (no deltas); an id added twice is stored once.
+//
+// Like fast-import, the object count in the header is patched at the end and
+// the trailing checksum is computed by reading the pack back once.
+//
+// Deflate uses zlib when built with HAVE_ZLIB; otherwise objects are stored
+// as uncompressed zlib streams, which git reads the same way.
+class PackWriter
+{
+public:
+    // packDir is usually .git/objects/pack. level is the zlib level; the
+    // default favours speed since imports are large and pushed once.
+    explicit PackWriter(std::string packDir, int level = 1);
+    ~PackWriter();
+    PackWriter(const PackWriter&) = delete;
+    PackWriter& operator=(const PackWriter&) = delete;
+
+    bool ok() const { return file_ != nullptr && !failed_; }
+
+    ObjectId add(ObjectType type, const void* data, std::size_t len);
+    // Blob from a file in one read. executable reports the owner x bit.
+    bool add_file(const std::string& path, ObjectId& oid, bool& executable);
+
+    std::size_t object_count() const;
+
+    // Writes the trailer and the .idx, then moves both into packDir as
+    // pack-<checksum>.{pack,idx}. Nothing is left behind when this is not
+    // called or fails.
+    bool finish(std::string* packName = nullptr);
+
+private:
+    struct Entry
+    {
+        ObjectId oid;
+        std::uint32_t crc;
+        std::uint64_t offset;
+    };
+
+    void append(const ObjectId& oid, const std::vector<std::uint8_t>& record);
+    void remove_temps();
+
+    std::string dir_;
+    std::string tmpPack_;
+    std::string tmpIdx_;
+    int level_;
+    std::FILE* file_{nullptr};
+    bool failed_{false};
+    bool finished_{false};
+    mutable std::mutex mu_;
+    std::uint64_t offset_{0};
+    std::vector<Entry> entries_;
+    std::unordered_set<std::string> seen_;  // raw ids
+};
+
+// A path in the commit tree, '/'-separated, with the blob it points at.
+// For a symlink the blob holds the link target.
+struct TreeFile
+{
+    std::string path;
+    ObjectId oid;
+    bool executable{false};
+    bool symlink{false};
+};
+
+// Writes the tree objects for files (any order) and returns the root tree id.
+ObjectId write_trees(PackWriter& pack, const std::vector<TreeFile>& files);
+
+}  // namespace rogue
@@ -0,0 +1,275 @@
+#include "path_matcher.hpp"
+
+#include <algorithm>
+
+namespace rogue
+{
+
+namespace
+{
+
+bool has_wildcard(std::string_view s) { return s.find_first_of("*?") != std::string_view::npos; }
+
+std::string_view basename_of(std::string_view rel)
+{
+    auto slash = rel.rfind('/');
+    return slash == std::string_view::npos ? rel : rel.substr(slash + 1);
+}
+
+// "a**b" and "a*b" are equivalent; collapsing runs keeps the NFA epsilon
+// closure to a single shift.
+std::string collapse_stars(const std::string& p)
+{
+    std::string out;
+    out.reserve(p.size());
+    for (char c : p)
+    {
+        if (c == '*' && !out.empty() && out.back() == '*')
+            continue;
+        out.push_back(c);
+    }
+    return out;
+}
+
+// Backtracking matcher with the same semantics as utils::glob_match_simple.
+bool glob_match(std::string_view pattern, std::string_view text)
+{
+    std::size_t p = 0, t = 0, star = std::string_view::npos, match = 0;
+    while (t < text.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t]))
+        {
+            p++;
+            t++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            match = t;
+        }
+        else if (star != std::string_view::npos)
+        {
+            p = star + 1;
+            t = ++match;
+        }
+        else
+            return false;
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+bool ends_with(std::string_view s, std::string_view suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+PathMatcher::PathMatcher(const std::vector<std::string>& patterns)
+{
+    for (auto raw : patterns)
+    {
+        while (!raw.empty() && (raw.back() == '\r' || raw.back() == ' '))
+            raw.pop_back();
+        if (raw.empty() || raw[0] == '#')
+            continue;
+        bool dirOnly = false;
+        for (std::string_view tail : {"/**", "/*", "/"})
+        {
+            if (raw.size() > tail.size() && ends_with(raw, tail))
+            {
+                raw.resize(raw.size() - tail.size());
+                dirOnly = true;
+                break;
+            }
+        }
+        (dirOnly ? dirOnly_ : any_).add(collapse_stars(raw));
+    }
+    any_.finalize();
+    dirOnly_.finalize();
+}
+
+bool PathMatcher::matches(std::string_view relPath) const
+{
+    return any_.match(relPath, basename_of(relPath));
+}
+
+bool PathMatcher::matches_under(std::string_view relPath) const
+{
+    if (matches(relPath))
+        return true;
+    for (auto slash = relPath.find('/'); slash != std::string_view::npos; slash = relPath.find('/', slash + 1))
+    {
+        if (matches_dir(relPath.substr(0, slash)))
+            return true;
+    }
+    return false;
+}
+
+bool PathMatcher::matches_dir(std::string_view relDir) const
+{
+    auto base = basename_of(relDir);
+    return any_.match(relDir, base) || dirOnly_.match(relDir, base);
+}
+
+void PathMatcher::CompiledSet::add(const std::string& p)
+{
+    ++count_;
+    auto star = p.find('*');
+    if (!has_wildcard(p))
+    {
+        exactSrc_.push_back(p);
+    }
+    else if (star == 0 && !has_wildcard(std::string_view(p).substr(1)))
+    {
+        // "*.pem": matching the full path's suffix also covers the basename.
+        suffixSrc_.push_back(p.substr(1));
+    }
+    else if (star == p.size() - 1 && !has_wildcard(std::string_view(p).substr(0, star)))
+    {
+        if (trie_.empty())
+            trie_.emplace_back();
+        std::uint32_t node = 0;
+        for (std::size_t i = 0; i < star; ++i)
+        {
+            auto& next = trie_[node].next;
+            auto it = std::find_if(next.begin(), next.end(),
+                                   [&](const auto& e) { return e.first == p[i]; });
+            if (it != next.end())
+            {
+                node = it->second;
+                continue;
+            }
+            auto child = static_cast<std::uint32_t>(trie_.size());
+            trie_[node].next.emplace_back(p[i], child);
+            trie_.emplace_back();
+            node = child;
+        }
+        trie_[node].terminal = true;
+    }
+    else
+    {
+        add_nfa(p);
+    }
+}
+
+void PathMatcher::CompiledSet::add_nfa(const std::string& p)
+{
+    // One state per token plus the accepting state.
+    const std::size_t need = p.size() + 1;
+    if (need > 64)
+    {
+        // Does not fit in a machine word; rare enough to match the slow way.
+        slow_.push_back(p);
+        return;
+    }
+    if (nfa_.empty() || nfa_.back().used + need > 64)
+        nfa_.emplace_back();
+    auto& b = nfa_.back();
+    const unsigned base = b.used;
+    b.start |= 1ULL << base;
+    for (unsigned i = 0; i < p.size(); ++i)
+    {
+        const std::uint64_t bit = 1ULL << (base + i);
+        if (p[i] == '*')
+            b.star |= bit;
+        else if (p[i] == '?')
+            for (auto& a : b.advance)
+                a |= bit;
+        else
+            b.advance[static_cast<unsigned char>(p[i])] |= bit;
+    }
+    b.accept |= 1ULL << (base + p.size());
+    b.used += static_cast<unsigned>(need);
+}
+
+PathMatcher::CompiledSet& PathMatcher::CompiledSet::operator=(const CompiledSet& o)
+{
+    if (this == &o)
+        return *this;
+    count_ = o.count_;
+    exactSrc_ = o.exactSrc_;
+    suffixSrc_ = o.suffixSrc_;
+    trie_ = o.trie_;
+    nfa_ = o.nfa_;
+    slow_ = o.slow_;
+    finalize();
+    return *this;
+}
+
+void PathMatcher::CompiledSet::finalize()
+{
+    exact_.clear();
+    suffixes_.clear();
+    suffixLens_.clear();
+    for (auto& s : exactSrc_)
+        exact_.insert(s);
+    for (auto& s : suffixSrc_)
+    {
+        suffixes_.insert(s);
+        if (std::find(suffixLens_.begin(), suffixLens_.end(), s.size()) == suffixLens_.end())
+            suffixLens_.push_back(s.size());
+    }
+}
+
+bool PathMatcher::CompiledSet::trie_match(std::string_view s) const
+{
+    if (trie_.empty())
+        return false;
+    std::uint32_t node = 0;
+    for (char c : s)
+    {
+        if (trie_[node].terminal)
+            return true;
+        const auto& next = trie_[node].next;
+        auto it = std::find_if(next.begin(), next.end(), [&](const auto& e) { return e.first == c; });
+        if (it == next.end())
+            return false;
+        node = it->second;
+    }
+    return trie_[node].terminal;
+}
+
+bool PathMatcher::CompiledSet::nfa_match(const NfaBlock& b, std::string_view s) const
+{
+    std::uint64_t state = b.start;
+    state |= (state & b.star) << 1;
+    for (char c : s)
+    {
+        state = ((state & b.advance[static_cast<unsigned char>(c)]) << 1) | (state & b.star);
+        if (state == 0)
+            return false;
+        state |= (state & b.star) << 1;
+    }
+    return (state & b.accept) != 0;
+}
+
+bool PathMatcher::CompiledSet::match(std::string_view rel, std::string_view base) const
+{
+    if (count_ == 0)
+        return false;
+    if (!exact_.empty() && (exact_.count(rel) || exact_.count(base)))
+        return true;
+    for (auto len : suffixLens_)
+    {
+        if (rel.size() >= len && suffixes_.count(rel.substr(rel.size() - len)))
+            return true;
+    }
+    if (trie_match(rel) || (base.size() != rel.size() && trie_match(base)))
+        return true;
+    for (const auto& b : nfa_)
+    {
+        if (nfa_match(b, rel) || (base.size() != rel.size() && nfa_match(b, base)))
+            return true;
+    }
+    for (const auto& p : slow_)
+    {
+        if (glob_match(p, rel) || glob_match(p, base))
+            return true;
+    }
+    return false;
+}
+
+}  // namespace rogue
@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace rogue
+{
+
+// A set of .rogueignore-style glob patterns compiled once for fast repeated
+// matching. Semantics follow utils::is_ignored: '*' matches any run of
+// characters (including '/'), '?' matches one character, and a pattern hits
+// when it matches either the full relative path or its last component.
+//
+// Patterns ending in '/' (or "/*", "/**") only apply to directories. Any
+// pattern that matches a directory prunes the whole subtree.
+class PathMatcher
+{
+public:
+    PathMatcher() = default;
+    explicit PathMatcher(const std::vector<std::string>& patterns);
+
+    bool empty() const { return any_.empty() && dirOnly_.empty(); }
+    bool matches(std::string_view relPath) const;
+    // matches(), or relPath lies in a directory matches_dir() accepts. For
+    // selecting files by pattern ("--include src/") rather than pruning a walk.
+    bool matches_under(std::string_view relPath) const;
+    bool matches_dir(std::string_view relDir) const;
+
+private:
+    // Patterns are sorted into the cheapest structure that can answer them:
+    // literals and "*suffix" go to hash sets, "prefix*" to a trie, everything
+    // else to a bit-parallel NFA that runs up to 64 pattern states per word.
+    class CompiledSet
+    {
+    public:
+        CompiledSet() = default;
+        // The lookup sets hold views into *Src_, so copies must rebuild them.
+        CompiledSet(const CompiledSet& o) { *this = o; }
+        CompiledSet& operator=(const CompiledSet& o);
+        CompiledSet(CompiledSet&&) = default;
+        CompiledSet& operator=(CompiledSet&&) = default;
+
+        void add(const std::string& pattern);
+        void finalize();
+        bool empty() const { return count_ == 0; }
+        bool match(std::string_view rel, std::string_view base) const;
+
+    private:
+        struct TrieNode
+        {
+            std::vector<std::pair<char, std::uint32_t>> next;
+            bool terminal{false};
+        };
+        struct NfaBlock
+        {
+            std::array<std::uint64_t, 256> advance{};  // states consuming byte c
+            std::uint64_t star{0};
+            std::uint64_t start{0};
+            std::uint64_t accept{0};
+            unsigned used{0};
+        };
+
+        bool trie_match(std::string_view s) const;
+        bool nfa_match(const NfaBlock& b, std::string_view s) const;
+        void add_nfa(const std::string& pattern);
+
+        std::size_t count_{0};
+        // Own the bytes the views point to; frozen once finalize() has run.
+        std::vector<std::string> exactSrc_;
+        std::vector<std::string> suffixSrc_;
+        std::unordered_set<std::string_view> exact_;
+        std::unordered_set<std::string_view> suffixes_;
+        std::vector<std::size_t> suffixLens_;
+        std::vector<TrieNode> trie_;
+        std::vector<NfaBlock> nfa_;
+        std::vector<std::string> slow_;  // patterns too long for one NFA word
+    };
+
+    CompiledSet any_;
+    CompiledSet dirOnly_;
+};
+
+}  // namespace rogue
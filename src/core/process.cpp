@@ -0,0 +1,357 @@
+#include "process.hpp"
+#include "profiler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace rogue
+{
+
+std::string describe_command(const std::vector<std::string>& argv)
+{
+    std::string s;
+    for (auto& a : argv)
+    {
+        if (!s.empty())
+            s += ' ';
+        if (!a.empty() && a.find_first_of(" \t\"'\\$&|;<>*?") == std::string::npos)
+            s += a;
+        else
+        {
+            s += '"';
+            for (char c : a)
+            {
+                if (c == '"' || c == '\\')
+                    s += '\\';
+                s += c;
+            }
+            s += '"';
+        }
+    }
+    return s;
+}
+
+#ifndef _WIN32
+
+namespace
+{
+
+// posix_spawn_file_actions_addchdir_np: glibc 2.29+, also on macOS/BSDs.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define ROGUE_HAVE_SPAWN_CHDIR 1
+#elif defined(__APPLE__)
+#define ROGUE_HAVE_SPAWN_CHDIR 1
+#endif
+
+struct Pipe
+{
+    int r{-1};
+    int w{-1};
+    bool open()
+    {
+        int fds[2];
+#ifdef __linux__
+        if (::pipe2(fds, O_CLOEXEC) != 0)
+            return false;
+#else
+        if (::pipe(fds) != 0)
+            return false;
+        ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#endif
+        r = fds[0];
+        w = fds[1];
+        return true;
+    }
+    void close_r()
+    {
+        if (r >= 0)
+            ::close(r);
+        r = -1;
+    }
+    void close_w()
+    {
+        if (w >= 0)
+            ::close(w);
+        w = -1;
+    }
+};
+
+void route(posix_spawn_file_actions_t& fa, ProcessOutput mode, Pipe& p, int fd)
+{
+    if (mode == ProcessOutput::Capture)
+        posix_spawn_file_actions_adddup2(&fa, p.w, fd);
+    else if (mode == ProcessOutput::Discard)
+        posix_spawn_file_actions_addopen(&fa, fd, "/dev/null", O_WRONLY, 0);
+}
+
+// Writes what the pipe takes without blocking; false once the input is done
+// or the child stopped reading. SIGPIPE is held for the write so a child
+// exiting early shows up as EPIPE instead of killing us.
+bool write_input(int fd, const std::string& input, std::size_t& sent)
+{
+    sigset_t pipeSet, oldSet;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+    const ssize_t n = ::write(fd, input.data() + sent, input.size() - sent);
+    const int err = errno;
+    if (n < 0 && err == EPIPE)
+    {
+        const timespec zero{0, 0};
+        while (sigtimedwait(&pipeSet, nullptr, &zero) > 0)
+        {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+    if (n > 0)
+        sent += std::size_t(n);
+    if (n < 0 && (err == EAGAIN || err == EINTR))
+        return true;
+    return n >= 0 && sent < input.size();
+}
+
+ProcessResult& decode(int status, ProcessResult& r)
+{
+    if (WIFEXITED(status))
+        r.exitCode = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status))
+        r.signal = WTERMSIG(status);
+    return r;
+}
+
+}  // namespace
+
+ProcessResult run_process(const std::vector<std::string>& argv, const ProcessOptions& options)
+{
+    ProcessResult r;
+    if (argv.empty())
+    {
+        r.error = "empty command";
+        return r;
+    }
+    ProfileScope scope(Phase::Subprocess);
+    if (scope.active())
+        scope.set_detail(describe_command(argv));
+    Pipe inPipe, outPipe, errPipe;
+    if ((!options.input.empty() && !inPipe.open()) ||
+        (options.stdoutMode == ProcessOutput::Capture && !outPipe.open()) ||
+        (options.stderrMode == ProcessOutput::Capture && !errPipe.open()))
+    {
+        r.error = std::strerror(errno);
+        for (Pipe* p : {&inPipe, &outPipe, &errPipe})
+        {
+            p->close_r();
+            p->close_w();
+        }
+        return r;
+    }
+
+    std::vector<char*> args;
+    for (auto& a : argv)
+        args.push_back(const_cast<char*>(a.c_str()));
+    args.push_back(nullptr);
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    if (inPipe.r >= 0)
+        posix_spawn_file_actions_adddup2(&fa, inPipe.r, 0);
+    else
+        posix_spawn_file_actions_addopen(&fa, 0, "/dev/null", O_RDONLY, 0);
+    route(fa, options.stdoutMode, outPipe, 1);
+    route(fa, options.stderrMode, errPipe, 2);
+
+    pid_t pid = -1;
+    int rc;
+#ifdef ROGUE_HAVE_SPAWN_CHDIR
+    if (!options.cwd.empty())
+        posix_spawn_file_actions_addchdir_np(&fa, options.cwd.c_str());
+    rc = posix_spawnp(&pid, args[0], &fa, nullptr, args.data(), environ);
+#else
+    if (options.cwd.empty())
+        rc = posix_spawnp(&pid, args[0], &fa, nullptr, args.data(), environ);
+    else
+    {
+        // No spawn-time chdir: fork, then do the same redirections by hand.
+        pid = ::fork();
+        if (pid == 0)
+        {
+            int devnull = ::open("/dev/null", O_RDWR);
+            ::dup2(inPipe.r >= 0 ? inPipe.r : devnull, 0);
+            if (options.stdoutMode != ProcessOutput::Inherit)
+                ::dup2(options.stdoutMode == ProcessOutput::Capture ? outPipe.w : devnull, 1);
+            if (options.stderrMode != ProcessOutput::Inherit)
+                ::dup2(options.stderrMode == ProcessOutput::Capture ? errPipe.w : devnull, 2);
+            if (::chdir(options.cwd.c_str()) != 0)
+                ::_exit(127);
+            ::execvp(args[0], args.data());
+            ::_exit(127);
+        }
+        rc = pid < 0 ? errno : 0;
+    }
+#endif
+    posix_spawn_file_actions_destroy(&fa);
+    inPipe.close_r();
+    outPipe.close_w();
+    errPipe.close_w();
+    if (rc != 0)
+    {
+        r.error = std::strerror(rc);
+        inPipe.close_w();
+        outPipe.close_r();
+        errPipe.close_r();
+        return r;
+    }
+    if (inPipe.w >= 0)
+        ::fcntl(inPipe.w, F_SETFL, ::fcntl(inPipe.w, F_GETFL) | O_NONBLOCK);
+    std::size_t inputSent = 0;
+    r.started = true;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+    char buf[16 * 1024];
+    while (inPipe.w >= 0 || outPipe.r >= 0 || errPipe.r >= 0)
+    {
+        pollfd fds[3];
+        nfds_t n = 0;
+        if (inPipe.w >= 0)
+            fds[n++] = pollfd{inPipe.w, POLLOUT, 0};
+        if (outPipe.r >= 0)
+            fds[n++] = pollfd{outPipe.r, POLLIN, 0};
+        if (errPipe.r >= 0)
+            fds[n++] = pollfd{errPipe.r, POLLIN, 0};
+        int wait = -1;
+        if (options.timeoutMs)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0)
+            {
+                r.timedOut = true;
+                break;
+            }
+            wait = int(left);
+        }
+        int ready = ::poll(fds, n, wait);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready < 0)
+            break;
+        for (nfds_t i = 0; i < n; ++i)
+        {
+            if (!fds[i].revents)
+                continue;
+            if (fds[i].fd == inPipe.w)
+            {
+                if (!write_input(inPipe.w, options.input, inputSent))
+                    inPipe.close_w();
+                continue;
+            }
+            const bool isOut = fds[i].fd == outPipe.r;
+            ssize_t got = ::read(fds[i].fd, buf, sizeof(buf));
+            if (got > 0)
+                (isOut ? r.out : r.err).append(buf, std::size_t(got));
+            else if (got == 0 || errno != EINTR)
+                (isOut ? outPipe : errPipe).close_r();
+        }
+    }
+    inPipe.close_w();
+    outPipe.close_r();
+    errPipe.close_r();
+
+    int status = 0;
+    if (options.timeoutMs)
+    {
+        // Output may close before the child exits; keep honouring the deadline.
+        while (!r.timedOut)
+        {
+            pid_t w = ::waitpid(pid, &status, WNOHANG);
+            if (w == pid)
+                return decode(status, r);
+            if (w < 0 && errno != EINTR)
+                return r;
+            if (std::chrono::steady_clock::now() >= deadline)
+                r.timedOut = true;
+            else
+                ::usleep(2000);
+        }
+        ::kill(pid, SIGKILL);
+    }
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    return decode(status, r);
+}
+
+#else  // _WIN32
+
+// Minimal fallback: one cmd.exe line through _popen. Only stdout can be
+// captured, input goes through a temporary file and timeouts are not
+// enforced.
+ProcessResult run_process(const std::vector<std::string>& argv, const ProcessOptions& options)
+{
+    ProcessResult r;
+    if (argv.empty())
+    {
+        r.error = "empty command";
+        return r;
+    }
+    ProfileScope scope(Phase::Subprocess);
+    if (scope.active())
+        scope.set_detail(describe_command(argv));
+    std::string line;
+    if (!options.cwd.empty())
+        line = "cd /d \"" + options.cwd + "\" && ";
+    line += describe_command(argv);
+    if (options.stdoutMode == ProcessOutput::Discard)
+        line += " >nul";
+    if (options.stderrMode != ProcessOutput::Inherit)
+        line += " 2>nul";
+    std::filesystem::path inputFile;
+    if (!options.input.empty())
+    {
+        inputFile = std::filesystem::temp_directory_path() / ("rogue_in_" + std::to_string(std::rand()) + ".tmp");
+        std::ofstream(inputFile, std::ios::binary) << options.input;
+        line += " <\"" + inputFile.string() + "\"";
+    }
+    std::FILE* p = _popen(line.c_str(), "r");
+    if (!p)
+    {
+        r.error = "cannot start cmd.exe";
+        return r;
+    }
+    r.started = true;
+    char buf[4096];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), p)) > 0)
+    {
+        if (options.stdoutMode == ProcessOutput::Capture)
+            r.out.append(buf, n);
+    }
+    r.exitCode = _pclose(p);
+    if (!inputFile.empty())
+    {
+        std::error_code ec;
+        std::filesystem::remove(inputFile, ec);
+    }
+    return r;
+}
+
+#endif
+
+}  // namespace rogue
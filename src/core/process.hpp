@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace rogue
+{
+
+enum class ProcessOutput
+{
+    Inherit,  // share the parent's stream
+    Capture,  // collect into ProcessResult::out / err
+    Discard   // /dev/null
+};
+
+struct ProcessOptions
+{
+    std::string cwd;  // empty = current directory
+    ProcessOutput stdoutMode{ProcessOutput::Capture};
+    ProcessOutput stderrMode{ProcessOutput::Capture};
+    unsigned timeoutMs{0};  // 0 = wait forever; on expiry the child is killed
+    std::string input;      // written to the child's stdin (empty = /dev/null)
+};
+
+struct ProcessResult
+{
+    bool started{false};  // false: the program could not be run at all
+    int exitCode{-1};     // valid when the child exited normally
+    int signal{0};        // terminating signal, 0 if it exited
+    bool timedOut{false};
+    std::string out;
+    std::string err;
+    std::string error;  // why it did not start
+
+    bool ok() const { return started && !timedOut && signal == 0 && exitCode == 0; }
+};
+
+// Runs argv[0] (looked up in PATH) with exactly these arguments: no shell,
+// so nothing needs quoting. On POSIX this is
+// posix_spawn with pipes drained through poll(); stdout and stderr are read
+// concurrently (and stdin fed alongside) so no pipe can fill up and stall
+// the child.
+ProcessResult run_process(const std::vector<std::string>& argv, const ProcessOptions& options = {});
+
+// Human-readable command line for logs (arguments quoted when needed).
+std::string describe_command(const std::vector<std::string>& argv);
+
+}  // namespace rogue
@@ -0,0 +1,222 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "utils.hpp"
+
+namespace rogue
+{
+
+namespace
+{
+
+struct PhaseInfo
+{
+    const char* name;
+    const char* category;
+};
+
+const PhaseInfo kPhases[] = {
+    {"scan", "scan"},           {"list_dir", "scan"}, {"ignore_match", "scan"}, {"stat", "scan"},
+    {"hash", "scan"},           {"cache_load", "scan"}, {"inventory_json", "scan"}, {"log", "log"},
+    {"git", "git"},             {"subprocess", "process"}, {"http", "github"},
+};
+static_assert(sizeof(kPhases) / sizeof(kPhases[0]) == std::size_t(Phase::Count_), "one entry per phase");
+
+const char* const kCounters[] = {"dirs_visited", "dirs_pruned",   "files_visited", "files_ignored", "files_skipped",
+                                 "files_hashed", "files_batched", "cache_hits",    "bytes_read"};
+static_assert(sizeof(kCounters) / sizeof(kCounters[0]) == std::size_t(Counter::Count_), "one name per counter");
+
+// Events kept per thread; beyond this a trace would be unwieldy anyway.
+constexpr std::size_t kMaxEventsPerThread = 2000000;
+
+std::atomic<std::uint64_t> g_generation{0};
+
+struct LocalSlot
+{
+    void* data{nullptr};
+    std::uint64_t generation{0};
+};
+thread_local LocalSlot t_slot;
+
+void append_us(std::string& out, std::int64_t ns)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.3f", double(ns) / 1000.0);
+    out += buf;
+}
+
+}  // namespace
+
+std::atomic<Profiler*> Profiler::active_{nullptr};
+
+Profiler::Profiler(bool keepEvents) : keepEvents_(keepEvents), generation_(++g_generation) {}
+
+Profiler::~Profiler()
+{
+    stop();
+}
+
+void Profiler::start()
+{
+    startNs_ = now_ns();
+    active_.store(this, std::memory_order_release);
+}
+
+void Profiler::stop()
+{
+    Profiler* self = this;
+    if (active_.compare_exchange_strong(self, nullptr))
+        stopNs_ = now_ns();
+}
+
+Profiler::ThreadData& Profiler::local()
+{
+    if (t_slot.generation != generation_)
+    {
+        auto data = std::make_unique<ThreadData>();
+        std::lock_guard<std::mutex> lk(mu_);
+        data->tid = std::uint32_t(threads_.size() + 1);
+        t_slot.data = data.get();
+        t_slot.generation = generation_;
+        threads_.push_back(std::move(data));
+    }
+    return *static_cast<ThreadData*>(t_slot.data);
+}
+
+void Profiler::record(Phase phase, std::int64_t startNs, std::int64_t durNs, std::string_view detail)
+{
+    ThreadData& t = local();
+    const std::size_t i = std::size_t(phase);
+    t.phaseNs[i].store(t.phaseNs[i].load(std::memory_order_relaxed) + durNs, std::memory_order_relaxed);
+    t.phaseCalls[i].store(t.phaseCalls[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if ((keepEvents_ || phase == Phase::Subprocess || phase == Phase::Http) && t.events.size() < kMaxEventsPerThread)
+        t.events.push_back(Event{startNs, durNs, phase, std::string(detail)});
+}
+
+void Profiler::count(Counter counter, std::uint64_t n)
+{
+    ThreadData& t = local();
+    const std::size_t i = std::size_t(counter);
+    t.counters[i].store(t.counters[i].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+std::uint64_t Profiler::counter(Counter c) const
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    std::uint64_t total = 0;
+    for (const auto& t : threads_)
+        total += t->counters[std::size_t(c)].load(std::memory_order_relaxed);
+    return total;
+}
+
+std::uint64_t Profiler::phase_calls(Phase p) const
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    std::uint64_t total = 0;
+    for (const auto& t : threads_)
+        total += t->phaseCalls[std::size_t(p)].load(std::memory_order_relaxed);
+    return total;
+}
+
+std::int64_t Profiler::phase_ns(Phase p) const
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    std::int64_t total = 0;
+    for (const auto& t : threads_)
+        total += t->phaseNs[std::size_t(p)].load(std::memory_order_relaxed);
+    return total;
+}
+
+void Profiler::write_summary(std::ostream& out) const
+{
+    const std::int64_t end = stopNs_ ? stopNs_ : now_ns();
+    char line[256];
+    std::snprintf(line, sizeof line, "profile: %.1f ms wall, %zu thread(s)\n", double(end - startNs_) / 1e6,
+                  threads_.size());
+    out << line;
+    out << "  phase               calls     total ms  (summed over threads; phases nest)\n";
+    for (std::size_t i = 0; i < std::size_t(Phase::Count_); ++i)
+    {
+        const std::uint64_t calls = phase_calls(Phase(i));
+        if (!calls)
+            continue;
+        std::snprintf(line, sizeof line, "  %-16s %8llu %12.1f\n", kPhases[i].name, (unsigned long long)calls,
+                      double(phase_ns(Phase(i))) / 1e6);
+        out << line;
+    }
+    out << "  counters:";
+    for (std::size_t i = 0; i < std::size_t(Counter::Count_); ++i)
+        out << ' ' << kCounters[i] << '=' << counter(Counter(i));
+    out << '\n';
+
+    std::vector<const Event*> slow;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        for (const auto& t : threads_)
+            for (const auto& e : t->events)
+                if (e.phase == Phase::Subprocess || e.phase == Phase::Http)
+                    slow.push_back(&e);
+    }
+    if (slow.empty())
+        return;
+    std::sort(slow.begin(), slow.end(), [](const Event* a, const Event* b) { return a->durNs > b->durNs; });
+    out << "  slowest subprocesses and requests:\n";
+    for (std::size_t i = 0; i < slow.size() && i < 10; ++i)
+    {
+        std::snprintf(line, sizeof line, "  %10.1f ms  ", double(slow[i]->durNs) / 1e6);
+        out << line << slow[i]->detail << '\n';
+    }
+}
+
+void Profiler::write_chrome_trace(std::ostream& out) const
+{
+    std::lock_guard<std::mutex> lk(mu_);
+    std::string buf = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"roguebox\"}}";
+    for (const auto& t : threads_)
+        for (const auto& e : t->events)
+        {
+            const PhaseInfo& info = kPhases[std::size_t(e.phase)];
+            buf += ",\n{\"name\":\"";
+            buf += info.name;
+            buf += "\",\"cat\":\"";
+            buf += info.category;
+            buf += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            buf += std::to_string(t->tid);
+            buf += ",\"ts\":";
+            append_us(buf, e.startNs - startNs_);
+            buf += ",\"dur\":";
+            append_us(buf, e.durNs);
+            if (!e.detail.empty())
+            {
+                buf += ",\"args\":{\"detail\":";
+                utils::append_json_string(buf, e.detail);
+                buf += '}';
+            }
+            buf += '}';
+            if (buf.size() >= 1 << 16)
+            {
+                out << buf;
+                buf.clear();
+            }
+        }
+    // Final counter values, as counter tracks at the end of the run.
+    const std::int64_t end = (stopNs_ ? stopNs_ : now_ns()) - startNs_;
+    for (std::size_t i = 0; i < std::size_t(Counter::Count_); ++i)
+    {
+        std::uint64_t total = 0;
+        for (const auto& t : threads_)
+            total += t->counters[i].load(std::memory_order_relaxed);
+        buf += ",\n{\"name\":\"";
+        buf += kCounters[i];
+        buf += "\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":";
+        append_us(buf, end);
+        buf += ",\"args\":{\"value\":" + std::to_string(total) + "}}";
+    }
+    buf += "\n]}\n";
+    out << buf;
+}
+
+}  // namespace rogue
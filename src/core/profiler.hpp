@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// -DROGUE_PROFILE=0 compiles every probe out; otherwise a disabled profiler
+// costs one relaxed load and a branch per probe.
+#ifndef ROGUE_PROFILE
+#define ROGUE_PROFILE 1
+#endif
+
+namespace rogue
+{
+
+// Where the time goes. Phases nest (a log line written while walking counts
+// in both), and times are summed over threads.
+enum class Phase : std::uint8_t
+{
+    Scan,           // scan_workspace as a whole
+    ListDir,        // reading one directory
+    IgnoreMatch,    // name filters (.rogueignore, --include, sensitive names)
+    Stat,           // one stat per file
+    Hash,           // reading and hashing one file
+    CacheLoad,      // reading the scan cache
+    InventoryJson,  // sorting and serializing the inventory
+    Log,            // formatting and queueing a log line
+    Git,            // git work done in-process (index, pack, objects)
+    Subprocess,     // one child process (git, gh)
+    Http,           // one GitHub API request
+    Count_
+};
+
+enum class Counter : std::uint8_t
+{
+    DirsVisited,
+    DirsPruned,    // skipped by an ignore pattern without being listed
+    FilesVisited,  // files and symlinks seen by the walk
+    FilesIgnored,  // by pattern or --include
+    FilesSkipped,  // sensitive name, too large, secret content
+    FilesHashed,   // read from disk (cache misses)
+    FilesBatched,  // of those, read whole by the batched reader
+    CacheHits,
+    BytesRead,
+    Count_
+};
+
+// Scoped timers and counters for one run. Start one to enable the probes
+// below process-wide; each thread records into its own buffer, so probes
+// take no lock. Span events (for the Chrome trace) are only kept when asked
+// for, except subprocesses and HTTP requests, which the summary lists.
+class Profiler
+{
+public:
+    explicit Profiler(bool keepEvents);
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Install as the active profiler / uninstall. Call stop() once the
+    // threads being measured are done.
+    void start();
+    void stop();
+
+    static Profiler* active()
+    {
+#if ROGUE_PROFILE
+        return active_.load(std::memory_order_relaxed);
+#else
+        return nullptr;
+#endif
+    }
+
+    void record(Phase phase, std::int64_t startNs, std::int64_t durNs, std::string_view detail);
+    void count(Counter counter, std::uint64_t n);
+
+    // Human-readable totals (for --stats).
+    void write_summary(std::ostream& out) const;
+    // Chrome trace-event JSON ("X" spans plus final counter values), for
+    // chrome://tracing or Perfetto.
+    void write_chrome_trace(std::ostream& out) const;
+
+    std::uint64_t counter(Counter c) const;
+    std::uint64_t phase_calls(Phase p) const;
+    std::int64_t phase_ns(Phase p) const;
+
+    static std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    struct Event
+    {
+        std::int64_t startNs;
+        std::int64_t durNs;
+        Phase phase;
+        std::string detail;
+    };
+    // Written by its thread only; the atomics let stop() read them safely.
+    struct ThreadData
+    {
+        std::uint32_t tid{0};
+        std::atomic<std::int64_t> phaseNs[std::size_t(Phase::Count_)]{};
+        std::atomic<std::uint64_t> phaseCalls[std::size_t(Phase::Count_)]{};
+        std::atomic<std::uint64_t> counters[std::size_t(Counter::Count_)]{};
+        std::vector<Event> events;
+    };
+    ThreadData& local();
+
+    static std::atomic<Profiler*> active_;
+    const bool keepEvents_;
+    const std::uint64_t generation_;
+    std::int64_t startNs_{0};
+    std::int64_t stopNs_{0};
+    mutable std::mutex mu_;
+    std::vector<std::unique_ptr<ThreadData>> threads_;
+};
+
+// Times its scope into the active profiler, if any.
+class ProfileScope
+{
+public:
+    explicit ProfileScope(Phase phase, std::string_view detail = {})
+        : profiler_(Profiler::active()), phase_(phase), detail_(detail)
+    {
+        if (profiler_)
+            startNs_ = Profiler::now_ns();
+    }
+    ~ProfileScope()
+    {
+        if (profiler_)
+            profiler_->record(phase_, startNs_, Profiler::now_ns() - startNs_, detail_.empty() ? ownDetail_ : detail_);
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    // For details that cost something to build: `if (scope.active()) scope.set_detail(...)`.
+    bool active() const { return profiler_ != nullptr; }
+    void set_detail(std::string detail)
+    {
+        ownDetail_ = std::move(detail);
+        detail_ = {};
+    }
+
+private:
+    Profiler* profiler_;
+    Phase phase_;
+    std::int64_t startNs_{0};
+    std::string_view detail_;
+    std::string ownDetail_;
+};
+
+inline void profile_count(Counter counter, std::uint64_t n = 1)
+{
+    if (Profiler* p = Profiler::active())
+        p->count(counter, n);
+}
+
+}  // namespace rogue
@@ -0,0 +1,48 @@
+#include "push_pipeline.hpp"
+
+#include "gitops.hpp"
+
+namespace rogue
+{
+
+PushPipeline::PushPipeline(GitOps& git, std::string root, std::string branch, std::size_t window)
+    : git_(git), root_(std::move(root)), branch_(std::move(branch)), queue_(window), worker_([this] { run(); })
+{
+}
+
+PushPipeline::~PushPipeline()
+{
+    finish();
+}
+
+bool PushPipeline::submit(std::string commit)
+{
+    if (failed_)
+        return false;
+    queue_.push(std::move(commit));
+    return !failed_;
+}
+
+bool PushPipeline::finish()
+{
+    queue_.close();
+    if (worker_.joinable())
+        worker_.join();
+    return !failed_;
+}
+
+void PushPipeline::run()
+{
+    while (auto commit = queue_.pop())
+    {
+        if (!git_.push_commit(root_, *commit, branch_))
+        {
+            failed_ = true;
+            queue_.close();  // unblocks a submitter waiting for room
+            return;
+        }
+        ++pushed_;
+    }
+}
+
+}  // namespace rogue
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+
+#include "work_queue.hpp"
+
+namespace rogue
+{
+
+class GitOps;
+
+// Pushes commits on a background thread, in submission order, while the
+// caller keeps staging and committing the next chunks. At most `window`
+// commits wait behind the push in progress; submit() blocks beyond that, so
+// local work never runs far ahead of the network. The first failed push
+// stops the pipeline: later submissions are refused and nothing else is
+// pushed.
+class PushPipeline
+{
+public:
+    PushPipeline(GitOps& git, std::string root, std::string branch, std::size_t window);
+    ~PushPipeline();
+
+    PushPipeline(const PushPipeline&) = delete;
+    PushPipeline& operator=(const PushPipeline&) = delete;
+
+    // Queues a commit id; false once a push has failed.
+    bool submit(std::string commit);
+    // Waits for queued pushes; true if every push succeeded.
+    bool finish();
+
+    bool failed() const { return failed_.load(); }
+    std::size_t pushed() const { return pushed_.load(); }
+
+private:
+    void run();
+
+    GitOps& git_;
+    std::string root_;
+    std::string branch_;
+    BoundedQueue<std::string> queue_;
+    std::atomic<bool> failed_{false};
+    std::atomic<std::size_t> pushed_{0};
+    std::thread worker_;
+};
+
+}  // namespace rogue
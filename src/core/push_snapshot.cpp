@@ -0,0 +1,186 @@
+#include "push_snapshot.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+const char kMagic[4] = {'R', 'P', 'S', '1'};
+const std::uint32_t kVersion = 1;
+// Fixed part of an entry: size, sha256, path length.
+const std::uint64_t kMinEntry = 8 + 32 + 2;
+
+template <typename T>
+bool read_pod(std::istream& in, T& v)
+{
+    return bool(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& v)
+{
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+void append_paths(std::string& out, const char* key, const std::vector<std::string>& paths)
+{
+    out += '"';
+    out += key;
+    out += "\":[";
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        if (i)
+            out += ',';
+        utils::append_json_string(out, paths[i]);
+    }
+    out += ']';
+}
+
+}  // namespace
+
+std::string PushSnapshot::default_path(const std::string& root)
+{
+    return (fs::path(root) / ".rogue" / "pushed").string();
+}
+
+bool PushSnapshot::load(const std::string& file, const std::string& branch)
+{
+    entries_.clear();
+    std::ifstream in(file, std::ios::binary);
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint16_t branchLen = 0;
+    std::uint64_t count = 0;
+    if (!in || !in.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0 || !read_pod(in, version) ||
+        version != kVersion || !read_pod(in, branchLen))
+        return false;
+    std::string recorded(branchLen, '\0');
+    if (!in.read(&recorded[0], branchLen) || recorded != branch || !read_pod(in, count))
+        return false;
+    // A count the rest of the file cannot hold means a corrupt snapshot.
+    const std::streamoff body = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff end = in.tellg();
+    if (body < 0 || end < body || count > std::uint64_t(end - body) / kMinEntry)
+        return false;
+    in.seekg(body);
+    entries_.reserve(std::size_t(count));
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        Entry e;
+        std::uint16_t len = 0;
+        if (!read_pod(in, e.size) || !in.read(reinterpret_cast<char*>(e.sha256.data()), 32) || !read_pod(in, len))
+        {
+            entries_.clear();
+            return false;
+        }
+        e.path.resize(len);
+        if (!in.read(&e.path[0], len))
+        {
+            entries_.clear();
+            return false;
+        }
+        entries_.push_back(std::move(e));
+    }
+    return true;
+}
+
+bool PushSnapshot::save(const std::string& file, const std::string& branch, const std::vector<FileEntry>& files)
+{
+    std::error_code ec;
+    const fs::path target(file);
+    fs::create_directories(target.parent_path(), ec);
+    // Same folder as the scan cache: keep it out of commits.
+    auto ignore = target.parent_path() / ".gitignore";
+    if (!fs::exists(ignore, ec))
+        std::ofstream(ignore) << "*\n";
+    const std::string tmp = file + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return false;
+        out.write(kMagic, 4);
+        write_pod(out, kVersion);
+        write_pod(out, std::uint16_t(branch.size()));
+        out.write(branch.data(), std::streamsize(branch.size()));
+        std::uint64_t count = 0;
+        for (auto& fe : files)
+            count += fe.path.size() <= 0xFFFF ? 1 : 0;
+        write_pod(out, count);
+        Sha256::Digest digest{};
+        for (auto& fe : files)
+        {
+            if (fe.path.size() > 0xFFFF)
+                continue;
+            // An unreadable file has no digest: it will show up as modified.
+            if (!Sha256::from_hex(fe.hash, digest))
+                digest.fill(0);
+            write_pod(out, std::uint64_t(fe.size));
+            out.write(reinterpret_cast<const char*>(digest.data()), 32);
+            write_pod(out, std::uint16_t(fe.path.size()));
+            out.write(fe.path.data(), std::streamsize(fe.path.size()));
+        }
+        if (!out.flush())
+        {
+            out.close();
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp, file, ec);
+    return !ec;
+}
+
+InventoryDiff diff_inventory(const std::vector<PushSnapshot::Entry>& before, const std::vector<FileEntry>& now)
+{
+    InventoryDiff d;
+    std::size_t i = 0, j = 0;
+    Sha256::Digest digest{};
+    while (i < before.size() || j < now.size())
+    {
+        const int c = i == before.size() ? 1 : j == now.size() ? -1 : before[i].path.compare(now[j].path);
+        if (c < 0)
+            d.deleted.push_back(before[i++].path);
+        else if (c > 0)
+            d.added.push_back(j++);
+        else
+        {
+            if (before[i].size != now[j].size || !Sha256::from_hex(now[j].hash, digest) || digest != before[i].sha256)
+                d.modified.push_back(j);
+            ++i;
+            ++j;
+        }
+    }
+    return d;
+}
+
+std::string inventory_diff_json(const InventoryDiff& diff, const std::vector<FileEntry>& now)
+{
+    auto paths = [&](const std::vector<std::size_t>& idx)
+    {
+        std::vector<std::string> out;
+        out.reserve(idx.size());
+        for (std::size_t i : idx)
+            out.push_back(now[i].path);
+        return out;
+    };
+    std::string out = "{";
+    append_paths(out, "added", paths(diff.added));
+    out += ',';
+    append_paths(out, "modified", paths(diff.modified));
+    out += ',';
+    append_paths(out, "deleted", diff.deleted);
+    out += '}';
+    return out;
+}
+
+}  // namespace rogue
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "scanner.hpp"
+#include "sha256.hpp"
+
+namespace rogue
+{
+
+// The inventory as of the last successful push of a branch, so the next run
+// only has to deal with what changed since.
+//
+// On-disk layout (host endianness, written to a temp file then renamed):
+//   "RPS1" | u32 version | u16 branch_len | branch | u64 count
+//   count x { u64 size | u8 sha256[32] | u16 path_len | path bytes }
+// Records are sorted by path.
+class PushSnapshot
+{
+public:
+    struct Entry
+    {
+        std::string path;
+        std::uint64_t size{0};
+        Sha256::Digest sha256{};
+    };
+
+    static std::string default_path(const std::string& root);
+
+    // False (and empty) when missing, corrupt or recorded for another branch.
+    bool load(const std::string& file, const std::string& branch);
+    // Records `files` (a sorted scan result) as pushed to `branch`.
+    static bool save(const std::string& file, const std::string& branch, const std::vector<FileEntry>& files);
+
+    const std::vector<Entry>& entries() const { return entries_; }
+
+private:
+    std::vector<Entry> entries_;
+};
+
+struct InventoryDiff
+{
+    std::vector<std::size_t> added;     // indexes into the current files
+    std::vector<std::size_t> modified;  // same path, different size or content
+    std::vector<std::string> deleted;   // in the snapshot, no longer inventoried
+
+    bool empty() const { return added.empty() && modified.empty() && deleted.empty(); }
+};
+
+// One merge pass over two path-sorted lists.
+InventoryDiff diff_inventory(const std::vector<PushSnapshot::Entry>& before, const std::vector<FileEntry>& now);
+
+// {"added":[...],"modified":[...],"deleted":[...]} with paths, for scan --diff.
+std::string inventory_diff_json(const InventoryDiff& diff, const std::vector<FileEntry>& now);
+
+}  // namespace rogue
@@ -0,0 +1,387 @@
+#include "rinv.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+#include "inventory_writer.hpp"
+#include "sha256.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+const char kMagic[4] = {'R', 'I', 'N', 'V'};
+const std::uint32_t kVersion = 1;
+const std::uint32_t kNoIndex = 0xFFFFFFFFu;
+
+// Interned names and the directory tree, built while records are added.
+// Keys are views into the caller's strings, which outlive the builder.
+class TableBuilder
+{
+public:
+    explicit TableBuilder(std::size_t files)
+    {
+        names_.reserve(files);
+        dirs_.push_back(RinvDir{0, 0, 0, 0});
+        dirIndex_.emplace(std::string_view(), 0);
+    }
+
+    bool intern(std::string_view s, std::uint32_t& off, std::uint32_t& len)
+    {
+        if (s.size() > 0xFFFFFFFFu)
+            return false;
+        auto it = names_.find(s);
+        if (it == names_.end())
+        {
+            if (strings_.size() + s.size() > 0xFFFFFFFFu)
+                return false;
+            it = names_.emplace(s, std::uint32_t(strings_.size())).first;
+            strings_.append(s.data(), s.size());
+        }
+        off = it->second;
+        len = std::uint32_t(s.size());
+        return true;
+    }
+
+    // Index of directory `dir` ("" = root), adding it and its parents.
+    std::uint32_t dir(std::string_view dir)
+    {
+        auto it = dirIndex_.find(dir);
+        if (it != dirIndex_.end())
+            return it->second;
+        const std::size_t slash = dir.rfind('/');
+        const std::uint32_t parent = slash == std::string_view::npos ? 0 : this->dir(dir.substr(0, slash));
+        if (parent == kNoIndex || dirs_.size() >= kNoIndex)
+            return kNoIndex;
+        RinvDir d{parent, 0, 0, 0};
+        if (!intern(slash == std::string_view::npos ? dir : dir.substr(slash + 1), d.nameOff, d.nameLen))
+            return kNoIndex;
+        dirs_.push_back(d);
+        const std::uint32_t index = std::uint32_t(dirs_.size() - 1);
+        dirIndex_.emplace(dir, index);
+        return index;
+    }
+
+    const std::vector<RinvDir>& dirs() const { return dirs_; }
+    const std::string& strings() const { return strings_; }
+
+private:
+    std::string strings_;
+    std::unordered_map<std::string_view, std::uint32_t> names_;
+    std::vector<RinvDir> dirs_;
+    std::unordered_map<std::string_view, std::uint32_t> dirIndex_;
+};
+
+// ISO local times to Unix seconds. mktime is slow (time zone rules on every
+// call) and inventories share a handful of hours, so the start of the last
+// hour seen is kept; offsets only change on hour boundaries.
+class LocalTimeParser
+{
+public:
+    bool parse(const std::string& iso, std::int64_t& out)
+    {
+        auto two = [&](std::size_t at) { return (iso[at] - '0') * 10 + (iso[at + 1] - '0'); };
+        auto digits = [&](std::size_t at) { return std::isdigit((unsigned char)iso[at]) && std::isdigit((unsigned char)iso[at + 1]); };
+        if (iso.size() != 19 || iso[13] != ':' || iso[16] != ':' || !digits(14) || !digits(17))
+            return false;
+        const int minute = two(14), second = two(17);
+        if (iso.compare(0, 13, hour_) != 0)
+        {
+            std::time_t t;
+            if (!utils::parse_local_time(iso.substr(0, 13) + ":00:00", t))
+                return false;
+            hour_.assign(iso, 0, 13);
+            hourStart_ = std::int64_t(t);
+        }
+        out = hourStart_ + minute * 60 + second;
+        return true;
+    }
+
+private:
+    std::string hour_;
+    std::int64_t hourStart_{0};
+};
+
+std::int64_t unix_seconds(std::int64_t ns)
+{
+    return ns / 1000000000LL - (ns % 1000000000LL < 0 ? 1 : 0);
+}
+
+}  // namespace
+
+bool write_rinv(const std::string& file, const std::string& root, const std::string& generatedAt,
+                const std::vector<FileEntry>& files, std::uintmax_t totalSize, std::string* error)
+{
+    auto fail = [&](const std::string& what)
+    {
+        if (error)
+            *error = what;
+        return false;
+    };
+    std::vector<std::size_t> order(files.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    auto byPath = [&](std::size_t a, std::size_t b) { return files[a].path < files[b].path; };
+    if (!std::is_sorted(order.begin(), order.end(), byPath))
+        std::sort(order.begin(), order.end(), byPath);
+
+    TableBuilder tables(files.size());
+    RinvHeader h{};
+    std::memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.count = files.size();
+    h.totalSize = totalSize;
+    if (!tables.intern(root, h.rootOff, h.rootLen) || !tables.intern(generatedAt, h.generatedAtOff, h.generatedAtLen))
+        return fail("string table too large");
+
+    std::vector<RinvRecord> records(files.size());
+    std::string_view lastDir;
+    std::uint32_t lastDirIndex = 0;
+    Sha256::Digest digest{};
+    LocalTimeParser localTime;
+    for (std::size_t k = 0; k < order.size(); ++k)
+    {
+        const FileEntry& fe = files[order[k]];
+        RinvRecord& r = records[k];
+        r.size = fe.size;
+        const std::string_view path(fe.path);
+        const std::size_t slash = path.rfind('/');
+        const std::string_view dir = slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+        // Sorted input: runs of files share their directory.
+        if (k == 0 || dir != lastDir)
+        {
+            lastDirIndex = tables.dir(dir);
+            lastDir = dir;
+        }
+        if (lastDirIndex == kNoIndex || !tables.intern(path.substr(slash + 1), r.nameOff, r.nameLen))
+            return fail("string table too large");
+        r.dir = lastDirIndex;
+        if (Sha256::from_hex(fe.hash, digest))
+        {
+            std::memcpy(r.sha256, digest.data(), 32);
+            r.flags |= RinvRecord::HashKnown;
+        }
+#ifndef _WIN32
+        if (fe.stat.mtimeNs)
+        {
+            r.mtime = unix_seconds(fe.stat.mtimeNs);
+            r.flags |= RinvRecord::MtimeKnown;
+        }
+        else
+#endif
+        if (localTime.parse(fe.mtime, r.mtime))
+            r.flags |= RinvRecord::MtimeKnown;
+    }
+
+    h.recordsOffset = sizeof(RinvHeader);
+    h.dirsOffset = h.recordsOffset + records.size() * sizeof(RinvRecord);
+    h.dirCount = tables.dirs().size();
+    h.stringsOffset = h.dirsOffset + tables.dirs().size() * sizeof(RinvDir);
+    h.stringsSize = tables.strings().size();
+
+    const std::string tmp = file + ".tmp";
+    std::error_code ec;
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            return fail("cannot write " + tmp);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(RinvRecord)));
+        out.write(reinterpret_cast<const char*>(tables.dirs().data()), std::streamsize(tables.dirs().size() * sizeof(RinvDir)));
+        out.write(tables.strings().data(), std::streamsize(tables.strings().size()));
+        if (!out.flush())
+        {
+            out.close();
+            fs::remove(tmp, ec);
+            return fail("cannot write " + tmp);
+        }
+    }
+    fs::rename(tmp, file, ec);
+    if (ec)
+        return fail("cannot rename " + tmp + ": " + ec.message());
+    return true;
+}
+
+RinvView::~RinvView()
+{
+    close();
+}
+
+void RinvView::close()
+{
+    file_.close();
+    header_ = nullptr;
+    records_ = nullptr;
+    dirs_ = nullptr;
+    strings_ = nullptr;
+    count_ = dirCount_ = stringsSize_ = 0;
+}
+
+bool RinvView::open(const std::string& file, std::string* error)
+{
+    close();
+    auto fail = [&](const std::string& what)
+    {
+        close();
+        if (error)
+            *error = what;
+        return false;
+    };
+    std::string why;
+    if (!file_.open(file, &why))
+        return fail(why);
+    const std::uint8_t* data = file_.data();
+    const std::size_t len = file_.size();
+    if (len < sizeof(RinvHeader))
+        return fail("not a rinv file: " + file);
+    header_ = reinterpret_cast<const RinvHeader*>(data);
+    const RinvHeader& h = *header_;
+    if (std::memcmp(h.magic, kMagic, 4) != 0)
+        return fail("not a rinv file: " + file);
+    if (h.version != kVersion)
+        return fail("unsupported rinv version " + std::to_string(h.version));
+    auto fits = [&](std::uint64_t off, std::uint64_t n, std::uint64_t width)
+    { return off % 8 == 0 && off <= len && n <= (len - off) / width; };
+    if (!fits(h.recordsOffset, h.count, sizeof(RinvRecord)) || !fits(h.dirsOffset, h.dirCount, sizeof(RinvDir)) ||
+        h.dirCount == 0 || h.stringsOffset > len || h.stringsSize > len - h.stringsOffset)
+        return fail("truncated or corrupt rinv file: " + file);
+    records_ = reinterpret_cast<const RinvRecord*>(data + h.recordsOffset);
+    dirs_ = reinterpret_cast<const RinvDir*>(data + h.dirsOffset);
+    strings_ = reinterpret_cast<const char*>(data + h.stringsOffset);
+    count_ = std::size_t(h.count);
+    dirCount_ = std::size_t(h.dirCount);
+    stringsSize_ = std::size_t(h.stringsSize);
+    // Parents come first, so path() always terminates.
+    for (std::size_t d = 1; d < dirCount_; ++d)
+        if (dirs_[d].parent >= d)
+            return fail("corrupt rinv directory table: " + file);
+    return true;
+}
+
+std::string_view RinvView::str(std::uint32_t off, std::uint32_t len) const
+{
+    if (off > stringsSize_ || len > stringsSize_ - off)
+        return {};
+    return std::string_view(strings_ + off, len);
+}
+
+std::string_view RinvView::name(std::size_t i) const
+{
+    return str(records_[i].nameOff, records_[i].nameLen);
+}
+
+std::string_view RinvView::root() const
+{
+    return header_ ? str(header_->rootOff, header_->rootLen) : std::string_view();
+}
+
+std::string_view RinvView::generated_at() const
+{
+    return header_ ? str(header_->generatedAtOff, header_->generatedAtLen) : std::string_view();
+}
+
+void RinvView::path(std::size_t i, std::string& out) const
+{
+    out.clear();
+    std::string_view parts[64];
+    std::size_t depth = 0;
+    std::vector<std::string_view> deep;  // only past 64 levels
+    for (std::uint32_t d = records_[i].dir; d != 0 && d < dirCount_; d = dirs_[d].parent)
+    {
+        const std::string_view part = str(dirs_[d].nameOff, dirs_[d].nameLen);
+        if (depth < 64)
+            parts[depth++] = part;
+        else
+            deep.push_back(part);
+    }
+    for (auto it = deep.rbegin(); it != deep.rend(); ++it)
+        out.append(it->data(), it->size()).push_back('/');
+    while (depth)
+    {
+        const std::string_view part = parts[--depth];
+        out.append(part.data(), part.size()).push_back('/');
+    }
+    const std::string_view base = name(i);
+    out.append(base.data(), base.size());
+}
+
+std::string RinvView::path(std::size_t i) const
+{
+    std::string out;
+    path(i, out);
+    return out;
+}
+
+std::string RinvView::hash_hex(std::size_t i) const
+{
+    if (!(records_[i].flags & RinvRecord::HashKnown))
+        return {};
+    Sha256::Digest d;
+    std::memcpy(d.data(), records_[i].sha256, 32);
+    return Sha256::to_hex(d);
+}
+
+std::string RinvView::mtime_iso(std::size_t i) const
+{
+    if (!(records_[i].flags & RinvRecord::MtimeKnown))
+        return {};
+    char buf[32];
+    utils::format_local_time(static_cast<std::time_t>(records_[i].mtime), buf, sizeof(buf));
+    return buf;
+}
+
+std::optional<std::size_t> RinvView::find(std::string_view target) const
+{
+    std::size_t lo = 0, hi = count_;
+    std::string probe;
+    while (lo < hi)
+    {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        path(mid, probe);
+        const int c = std::string_view(probe).compare(target);
+        if (c == 0)
+            return mid;
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return std::nullopt;
+}
+
+FileEntry RinvView::entry(std::size_t i) const
+{
+    FileEntry fe;
+    path(i, fe.path);
+    fe.size = records_[i].size;
+    fe.hash = hash_hex(i);
+    fe.mtime = mtime_iso(i);
+    return fe;
+}
+
+bool is_rinv_file(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    char magic[4];
+    return in.read(magic, 4) && std::memcmp(magic, kMagic, 4) == 0;
+}
+
+void write_rinv_as_json(const RinvView& view, std::ostream& out)
+{
+    auto writer = make_inventory_writer(InventoryFormat::Json, out);
+    writer->begin(std::string(view.root()), std::string(view.generated_at()));
+    for (std::size_t i = 0; i < view.size(); ++i)
+        writer->entry(view.entry(i));
+    writer->end(view.total_size());
+}
+
+}  // namespace rogue
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "scanner.hpp"
+
+namespace rogue
+{
+
+// Binary inventory (.rinv), laid out to be mapped and read in place.
+//
+//   RinvHeader | RinvRecord[count] | RinvDir[dirCount] | string table
+//
+// Records are sorted by path and fixed-width, so record i is at a known
+// offset and a path lookup is a binary search. A path is its directory chain
+// plus a basename; directories are stored once with their parent, and every
+// name is interned in the string table, so shared prefixes and repeated
+// basenames cost nothing per file. Integers are host-endian; the header's
+// version changes with the layout.
+struct RinvHeader
+{
+    char magic[4];  // "RINV"
+    std::uint32_t version;
+    std::uint64_t count;
+    std::uint64_t totalSize;
+    std::uint64_t recordsOffset;
+    std::uint64_t dirsOffset;
+    std::uint64_t dirCount;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint32_t rootOff, rootLen;  // in the string table
+    std::uint32_t generatedAtOff, generatedAtLen;
+};
+
+struct RinvRecord
+{
+    enum Flags : std::uint32_t
+    {
+        HashKnown = 1,   // sha256 is valid (the file was readable)
+        MtimeKnown = 2,  // mtime is valid
+    };
+    std::uint64_t size;
+    std::int64_t mtime;  // Unix seconds
+    std::uint8_t sha256[32];
+    std::uint32_t dir;  // index into the directory table, 0 = root
+    std::uint32_t nameOff, nameLen;
+    std::uint32_t flags;
+};
+
+struct RinvDir
+{
+    std::uint32_t parent;  // lower index; the root (0) is its own parent
+    std::uint32_t nameOff, nameLen;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(RinvHeader) == 80, "rinv header layout");
+static_assert(sizeof(RinvRecord) == 64, "rinv record layout");
+static_assert(sizeof(RinvDir) == 16, "rinv directory layout");
+
+// Writes `files` (sorted by path, as scan_workspace returns them) to `file`
+// through a temp file and a rename. mtime comes from the stat when the
+// entry has one, otherwise from its ISO string (JSON input).
+bool write_rinv(const std::string& file, const std::string& root, const std::string& generatedAt,
+                const std::vector<FileEntry>& files, std::uintmax_t totalSize, std::string* error = nullptr);
+
+// Read-only view of a .rinv file: open() maps it and checks the header and
+// the directory table, so it costs the same for ten entries or ten million.
+// Record fields are read straight from the mapping.
+class RinvView
+{
+public:
+    RinvView() = default;
+    ~RinvView();
+    RinvView(const RinvView&) = delete;
+    RinvView& operator=(const RinvView&) = delete;
+
+    bool open(const std::string& file, std::string* error = nullptr);
+    void close();
+
+    std::size_t size() const { return count_; }
+    const RinvRecord& record(std::size_t i) const { return records_[i]; }
+    std::string_view name(std::size_t i) const;
+    // Full '/'-separated path of record i (appended to out after clearing it).
+    void path(std::size_t i, std::string& out) const;
+    std::string path(std::size_t i) const;
+    std::string hash_hex(std::size_t i) const;  // "" unless HashKnown
+    std::string mtime_iso(std::size_t i) const;
+    // Record with exactly this path.
+    std::optional<std::size_t> find(std::string_view path) const;
+
+    std::string_view root() const;
+    std::string_view generated_at() const;
+    std::uint64_t total_size() const { return header_ ? header_->totalSize : 0; }
+
+    // The record as a scanner entry (path, size, hash, mtime).
+    FileEntry entry(std::size_t i) const;
+
+private:
+    std::string_view str(std::uint32_t off, std::uint32_t len) const;
+
+    MappedFile file_;
+    const RinvHeader* header_{nullptr};
+    const RinvRecord* records_{nullptr};
+    const RinvDir* dirs_{nullptr};
+    std::size_t count_{0};
+    std::size_t dirCount_{0};
+    const char* strings_{nullptr};
+    std::size_t stringsSize_{0};
+};
+
+// True if the file starts with the .rinv magic.
+bool is_rinv_file(const std::string& file);
+
+// The JSON inventory of a .rinv file, in the scanner's layout.
+void write_rinv_as_json(const RinvView& view, std::ostream& out);
+
+}  // namespace rogue
@@ -0,0 +1,210 @@
+#include "scan_cache.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace rogue
+{
+
+namespace
+{
+
+const char kMagic[4] = {'R', 'S', 'C', '1'};
+const std::uint32_t kVersion = 3;
+// Fixed part of a record: stat tuple, sha256, flags, git oid, path length.
+const std::uint64_t kMinRecord = 4 * 8 + 32 + 1 + 20 + 2;
+
+int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool hex_to_bytes(const std::string& hex, std::uint8_t out[32])
+{
+    if (hex.size() != 64)
+        return false;
+    for (int i = 0; i < 32; ++i)
+    {
+        int hi = hex_value(hex[2 * i]);
+        int lo = hex_value(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out[i] = std::uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+std::string bytes_to_hex(const std::uint8_t in[32])
+{
+    static const char* digits = "0123456789abcdef";
+    std::string s(64, '0');
+    for (int i = 0; i < 32; ++i)
+    {
+        s[2 * i] = digits[in[i] >> 4];
+        s[2 * i + 1] = digits[in[i] & 15];
+    }
+    return s;
+}
+
+template <typename T>
+bool read_pod(std::istream& in, T& v)
+{
+    return bool(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+template <typename T>
+void write_pod(std::ostream& out, const T& v)
+{
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+}  // namespace
+
+std::string ScanCache::default_path(const std::string& root)
+{
+    return (fs::path(root) / ".rogue" / "scancache").string();
+}
+
+bool ScanCache::load(const std::string& file)
+{
+    records_.clear();
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return false;
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint64_t count = 0;
+    if (!in.read(magic, 4) || std::memcmp(magic, kMagic, 4) != 0 || !read_pod(in, version) ||
+        version != kVersion || !read_pod(in, count))
+        return false;
+    // A count the rest of the file cannot hold is corruption, not a reason
+    // to reserve (and fail to allocate) that many records.
+    const std::streamoff body = in.tellg();
+    in.seekg(0, std::ios::end);
+    const std::streamoff end = in.tellg();
+    if (body < 0 || end < body || count > std::uint64_t(end - body) / kMinRecord)
+        return false;
+    in.seekg(body);
+    records_.reserve(std::size_t(count));
+    std::string path;
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        Record rec;
+        std::uint16_t len = 0;
+        if (!read_pod(in, rec.stat.dev) || !read_pod(in, rec.stat.ino) ||
+            !read_pod(in, rec.stat.size) || !read_pod(in, rec.stat.mtimeNs) ||
+            !in.read(reinterpret_cast<char*>(rec.sha256), 32) || !read_pod(in, rec.flags) ||
+            !in.read(reinterpret_cast<char*>(rec.gitOid), 20) || !read_pod(in, len))
+        {
+            records_.clear();
+            return false;
+        }
+        path.resize(len);
+        if (!in.read(&path[0], len))
+        {
+            records_.clear();
+            return false;
+        }
+        records_.emplace(path, rec);
+    }
+    return true;
+}
+
+ScanCache::Writer::Writer(std::string file) : file_(std::move(file)), tmp_(file_ + ".tmp")
+{
+    std::error_code ec;
+    fs::path target(file_);
+    fs::create_directories(target.parent_path(), ec);
+    // Keep the cache out of commits made from this workspace.
+    auto ignore = target.parent_path() / ".gitignore";
+    if (!fs::exists(ignore, ec))
+        std::ofstream(ignore) << "*\n";
+    out_.open(tmp_, std::ios::binary | std::ios::trunc);
+    if (!out_)
+        return;
+    out_.write(kMagic, 4);
+    write_pod(out_, kVersion);
+    write_pod(out_, count_);  // patched by commit()
+}
+
+ScanCache::Writer::~Writer()
+{
+    if (!committed_)
+    {
+        out_.close();
+        std::error_code ec;
+        fs::remove(tmp_, ec);
+    }
+}
+
+void ScanCache::Writer::add(const std::string& rel, const FileStat& st, const std::string& hex,
+                            std::uint8_t flags, const std::uint8_t* gitOid)
+{
+    Record rec;
+    rec.stat = st;
+    rec.flags = flags;
+    if (gitOid)
+        std::memcpy(rec.gitOid, gitOid, 20);
+    else
+        rec.flags &= std::uint8_t(~GitOidKnown);
+    if (hex_to_bytes(hex, rec.sha256))
+        add(rel, rec);
+}
+
+void ScanCache::Writer::add(const std::string& rel, const Record& rec)
+{
+    if (!out_ || rel.size() > 0xFFFF)
+        return;
+    write_pod(out_, rec.stat.dev);
+    write_pod(out_, rec.stat.ino);
+    write_pod(out_, rec.stat.size);
+    write_pod(out_, rec.stat.mtimeNs);
+    out_.write(reinterpret_cast<const char*>(rec.sha256), 32);
+    write_pod(out_, rec.flags);
+    out_.write(reinterpret_cast<const char*>(rec.gitOid), 20);
+    write_pod(out_, std::uint16_t(rel.size()));
+    out_.write(rel.data(), std::streamsize(rel.size()));
+    ++count_;
+}
+
+bool ScanCache::Writer::commit()
+{
+    if (!out_)
+        return false;
+    out_.seekp(8);
+    write_pod(out_, count_);
+    out_.close();
+    if (out_.fail())
+        return false;
+    std::error_code ec;
+    fs::rename(tmp_, file_, ec);
+    if (ec)
+        return false;
+    committed_ = true;
+    return true;
+}
+
+const ScanCache::Record* ScanCache::find(const std::string& rel, const FileStat& st) const
+{
+    auto it = records_.find(rel);
+    if (it == records_.end())
+        return nullptr;
+    const auto& c = it->second.stat;
+    if (c.dev != st.dev || c.ino != st.ino || c.size != st.size || c.mtimeNs != st.mtimeNs)
+        return nullptr;
+    return &it->second;
+}
+
+std::string ScanCache::sha256_hex(const Record& rec) { return bytes_to_hex(rec.sha256); }
+
+}  // namespace rogue
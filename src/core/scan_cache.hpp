@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+
+#include "file_stat.hpp"
+
+namespace rogue
+{
+
+// Persistent map of relative path -> (stat tuple, SHA-256) used to skip
+// rehashing files that have not changed since the previous scan.
+//
+// On-disk layout (host endianness, written to a temp file then renamed):
+//   "RSC1" | u32 version | u64 count
+//   count x { u64 dev | u64 ino | u64 size | i64 mtime_ns | u8 sha256[32] |
+//             u8 flags | u8 git_oid[20] | u16 path_len | path bytes }
+// Files from another version are ignored (the next scan rehashes).
+class ScanCache
+{
+public:
+    // Content facts that stay valid as long as the stat tuple matches.
+    enum Flags : std::uint8_t
+    {
+        SecretsChecked = 1,  // content went through --detect-secrets
+        SecretFound = 2,     // ... and was flagged
+        GitOidKnown = 4      // git_oid holds the git blob id of the content
+    };
+
+    struct Record
+    {
+        FileStat stat;
+        std::uint8_t sha256[32];
+        std::uint8_t flags{0};
+        std::uint8_t gitOid[20] = {};
+    };
+
+    // Streams records straight to "<file>.tmp"; commit() patches the count
+    // and renames over the target, so memory does not grow with the tree.
+    class Writer
+    {
+    public:
+        explicit Writer(std::string file);
+        ~Writer();
+        bool ok() const { return bool(out_); }
+        void add(const std::string& rel, const FileStat& st, const std::string& hex, std::uint8_t flags = 0,
+                 const std::uint8_t* gitOid = nullptr);
+        void add(const std::string& rel, const Record& rec);
+        bool commit();
+
+    private:
+        std::string file_;
+        std::string tmp_;
+        std::ofstream out_;
+        std::uint64_t count_{0};
+        bool committed_{false};
+    };
+
+    static std::string default_path(const std::string& root);
+
+    // A missing or corrupt file yields an empty cache.
+    bool load(const std::string& file);
+
+    // The record for rel when its stat tuple matches exactly, else nullptr.
+    const Record* find(const std::string& rel, const FileStat& st) const;
+    static std::string sha256_hex(const Record& rec);
+
+    std::size_t size() const { return records_.size(); }
+
+private:
+    std::unordered_map<std::string, Record> records_;
+};
+
+}  // namespace rogue
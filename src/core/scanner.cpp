@@ -1,81 +1,566 @@
 #include "scanner.hpp"
+#include "cdc.hpp"
+#include "dir_reader.hpp"
+#include "inventory_writer.hpp"
 #include "logger.hpp"
+#include "path_matcher.hpp"
+#include "profiler.hpp"
+#include "scan_cache.hpp"
+#include "secret_detector.hpp"
+#include "sha1.hpp"
+#include "sha256.hpp"
 #include "utils.hpp"
+#include "work_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
-#include <sstream>
-#include <chrono>
+#include <functional>
 #include <iomanip>
-
-// minimal nlohmann/json header (vendored simplified include path)
-#include "../../third_party/json.hpp"
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
 
 namespace fs = std::filesystem;
 
 namespace rogue
 {
 
-    static bool is_sensitive(const fs::path &p)
+    static bool is_sensitive(const std::string &name)
     {
-        auto name = p.filename().string();
         std::string lower = name;
         for (auto &c : lower)
             c = (char)tolower((unsigned char)c);
         return lower == ".env" || lower.find(".pem") != std::string::npos || lower.find(".key") != std::string::npos || lower.find(".pfx") != std::string::npos || lower.find("token") != std::string::npos;
     }
 
+    namespace
+    {
+        struct HashJob
+        {
+            std::string rel;
+            std::string full;
+            FileStat stat;
+        };
+
+        struct ScanPlan
+        {
+            std::size_t walkers;
+            std::size_t hashers;
+        };
+
+        // Walking is metadata-bound and hashing is read/CPU-bound, so most of
+        // the thread budget goes to the hash pool.
+        ScanPlan plan_threads(int requested)
+        {
+            std::size_t total = requested > 0 ? (std::size_t)requested : std::thread::hardware_concurrency();
+            if (total == 0)
+                total = 1;
+            std::size_t walkers = std::max<std::size_t>(1, total / 4);
+            std::size_t hashers = std::max<std::size_t>(1, total - std::min(total, walkers));
+            return {walkers, hashers};
+        }
+
+        // From the stat taken while walking, so no second stat per file.
+        std::string mtime_iso(const FileStat &st, [[maybe_unused]] const std::string &full)
+        {
+#ifdef _WIN32
+            return utils::file_mtime_iso(full); // mtimeNs is not Unix time here
+#else
+            std::int64_t sec = st.mtimeNs / 1000000000LL - (st.mtimeNs % 1000000000LL < 0 ? 1 : 0);
+            char buf[32];
+            utils::format_local_time(static_cast<std::time_t>(sec), buf, sizeof(buf));
+            return buf;
+#endif
+        }
+
+        std::string join_rel(const std::string &dir, const std::string &name)
+        {
+            return dir.empty() ? name : dir + "/" + name;
+        }
+    }
+
+    std::vector<std::string> ignore_patterns(const ScanOptions &options)
+    {
+        // --exclude patterns share .rogueignore's semantics
+        auto patterns = utils::load_ignore_patterns(fs::path(options.root) / ".rogueignore");
+        patterns.insert(patterns.end(), options.excludes.begin(), options.excludes.end());
+        const std::string log = utils::path_under(options.root, Logger::options_from_env().path);
+        if (!log.empty())
+            patterns.push_back(log);
+        return patterns;
+    }
+
     ScanResult scan_workspace(const ScanOptions &options, Logger &logger)
     {
-        using nlohmann::json;
-        json j;
-        j["root"] = options.root;
-        j["generated_at"] = utils::iso_timestamp();
-        j["files"] = json::array();
+        ProfileScope scanScope(Phase::Scan, options.root);
+        ScanResult r;
+        std::error_code rootEc;
+        if (!fs::is_directory(options.root, rootEc))
+        {
+            r.ok = false;
+            r.errorMessage = "scan root is not a directory: " + options.root;
+            return r;
+        }
 
-        // Load .rogueignore
-        auto ignore = utils::load_ignore_patterns(fs::path(options.root) / ".rogueignore");
+        // --include narrows files further
+        const PathMatcher ignore(ignore_patterns(options));
+        const PathMatcher include(options.includes);
+        std::string rootPrefix = options.root;
+        if (rootPrefix.back() != '/')
+            rootPrefix += '/';
+        const auto plan = plan_threads(options.threads);
 
-        ScanResult r; // declare early for use in loop
-        std::uintmax_t total = 0;
-        for (auto &entry : fs::recursive_directory_iterator(options.root))
+        ScanCache cache;
+        const std::string cacheFile = options.cachePath.empty() ? ScanCache::default_path(options.root) : options.cachePath;
+        if (options.useCache)
+        {
+            ProfileScope loadScope(Phase::CacheLoad);
+            cache.load(cacheFile);
+        }
+        std::atomic<std::size_t> hits{0}, misses{0};
+
+        WorkStealingQueues<std::string> dirs(plan.walkers);
+        BoundedQueue<HashJob> jobs(plan.hashers * 64);
+        std::atomic<std::size_t> pending{1}; // directories queued or being listed
+        dirs.push(0, std::string());
+
+        // Name-based filters, before any stat.
+        auto admit_name = [&](const std::string &rel, const std::string &name)
+        {
+            bool ignored, sensitive;
+            {
+                ProfileScope matchScope(Phase::IgnoreMatch);
+                ignored = ignore.matches(rel) || (!include.empty() && !include.matches_under(rel));
+                sensitive = !ignored && !options.includeSecrets && is_sensitive(name);
+            }
+            if (ignored)
+            {
+                profile_count(Counter::FilesIgnored);
+                logger.debug("scan", "ignored", LogField("path", rel));
+                return false;
+            }
+            if (sensitive)
+            {
+                profile_count(Counter::FilesSkipped);
+                logger.warn("scan", "sensitive skipped", LogField("path", rel));
+                return false;
+            }
+            return true;
+        };
+        auto admit_file = [&](std::string rel, const FileStat &st)
+        {
+            if ((st.size / (1024 * 1024)) > (std::uintmax_t)options.maxSizeMb)
+            {
+                profile_count(Counter::FilesSkipped);
+                logger.warn("scan", "too large, skipped", LogField("path", rel), LogField("size", st.size));
+                return;
+            }
+            std::string full = rootPrefix + rel;
+            jobs.push(HashJob{std::move(rel), std::move(full), st});
+        };
+
+        // Targeted mode: the same checks a walk would apply on the way down.
+        auto visit_paths = [&]
+        {
+            for (auto &rel : options.paths)
+            {
+                bool pruned = false;
+                for (std::size_t slash = rel.find('/'); slash != std::string::npos && !pruned; slash = rel.find('/', slash + 1))
+                {
+                    const std::string dir = rel.substr(0, slash);
+                    const std::string name = dir.substr(dir.rfind('/') + 1);
+                    pruned = name == ".git" || dir == ".rogue" || ignore.matches_dir(dir);
+                }
+                const std::string name = rel.substr(rel.rfind('/') + 1);
+                if (pruned || rel.empty())
+                    continue;
+                profile_count(Counter::FilesVisited);
+                if (!admit_name(rel, name))
+                    continue;
+                FileStat st;
+                bool statted;
+                {
+                    ProfileScope statScope(Phase::Stat);
+                    statted = utils::stat_file(rootPrefix + rel, st);
+                }
+                if (statted)
+                    admit_file(rel, st);
+            }
+        };
+
+        auto walk = [&](std::size_t id)
         {
-            if (!entry.is_regular_file())
-                continue;
-            auto rel = fs::relative(entry.path(), options.root).generic_string();
-            if (utils::is_ignored(rel, ignore))
+            DirReader reader;
+            std::vector<DirEntry> entries;
+            unsigned idle = 0;
+            while (true)
             {
-                logger.debug("scan", std::string("ignored ") + rel);
-                continue;
+                auto dir = dirs.pop(id);
+                if (!dir)
+                {
+                    if (pending.load(std::memory_order_acquire) == 0)
+                        return;
+                    if (++idle < 64)
+                        std::this_thread::yield();
+                    else
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    continue;
+                }
+                idle = 0;
+                std::string_view shown = dir->empty() ? std::string_view(".") : std::string_view(*dir);
+                profile_count(Counter::DirsVisited);
+                {
+                    ProfileScope listScope(Phase::ListDir, shown);
+                    if (!reader.open(dir->empty() ? rootPrefix : rootPrefix + *dir))
+                        logger.warn("scan", "cannot list", LogField("path", shown));
+                    else
+                    {
+                        entries.clear();
+                        if (!reader.read_all(entries))
+                            logger.warn("scan", "cannot list", LogField("path", shown));
+                        // Visiting entries in inode order keeps reads close together on disks
+                        // that care; hashing order is still up to the pool.
+                        if (options.inodeOrder)
+                            std::sort(entries.begin(), entries.end(), [](const DirEntry &a, const DirEntry &b)
+                                      { return a.ino < b.ino; });
+                    }
+                }
+                for (auto &entry : entries)
+                {
+                    auto type = entry.type == DirEntryType::Unknown ? reader.resolve_type(entry.name) : entry.type;
+                    auto rel = join_rel(*dir, entry.name);
+                    if (type == DirEntryType::Dir)
+                    {
+                        if (entry.name == ".git" || (dir->empty() && entry.name == ".rogue"))
+                            continue; // VCS metadata and our own state (scan cache)
+                        bool pruned;
+                        {
+                            ProfileScope matchScope(Phase::IgnoreMatch);
+                            pruned = ignore.matches_dir(rel);
+                        }
+                        if (pruned)
+                        {
+                            profile_count(Counter::DirsPruned);
+                            logger.debug("scan", "pruned", LogField("path", rel));
+                            continue;
+                        }
+                        pending.fetch_add(1, std::memory_order_relaxed);
+                        dirs.push(id, std::move(rel));
+                        continue;
+                    }
+                    // Symlinks are followed to files (not to directories)
+                    if (type != DirEntryType::File && type != DirEntryType::Symlink)
+                        continue;
+                    profile_count(Counter::FilesVisited);
+                    if (!admit_name(rel, entry.name))
+                        continue;
+                    FileStat st;
+                    bool statted;
+                    {
+                        ProfileScope statScope(Phase::Stat);
+                        statted = reader.stat_file(entry.name, st);
+                    }
+                    if (statted)
+                        admit_file(std::move(rel), st);
+                }
+                entries.clear();
+                pending.fetch_sub(1, std::memory_order_acq_rel);
             }
-            if (!options.includeSecrets && is_sensitive(entry.path()))
+        };
+
+        // Cache records and streamed entries are written as files complete, so
+        // neither needs the full file list in memory.
+        std::unique_ptr<ScanCache::Writer> cacheOut;
+        if (options.useCache && options.paths.empty())
+            cacheOut = std::make_unique<ScanCache::Writer>(cacheFile);
+#ifndef _WIN32
+        // Files modified in the last couple of seconds are not cached: a write
+        // landing in the same mtime tick after we hashed would be masked.
+        const std::int64_t racyCutoff = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::system_clock::now().time_since_epoch())
+                                            .count() -
+                                        2000000000LL;
+#endif
+        const std::string generatedAt = utils::iso_timestamp();
+        r.generatedAt = generatedAt;
+        if (options.sink)
+            options.sink->begin(options.root, generatedAt);
+        std::mutex emitMu;
+        std::uintmax_t total = 0;
+        std::uintmax_t dupTotal = 0;
+        ChunkIndex chunks; // shared by the hashers (dedup only)
+
+        // Cache records are only enough if they carry what this scan was
+        // asked for beyond the digest.
+        auto usable_record = [&](const HashJob &job) -> const ScanCache::Record *
+        {
+            const ScanCache::Record *rec = options.useCache ? cache.find(job.rel, job.stat) : nullptr;
+            if (rec && !options.dedup && (!options.detectSecrets || (rec->flags & ScanCache::SecretsChecked)) &&
+                (!options.gitOids || (rec->flags & ScanCache::GitOidKnown)))
+                return rec;
+            return nullptr;
+        };
+        const bool readsContents = options.detectSecrets || options.gitOids || options.dedup || options.hashContents;
+        const bool batched = readsContents && options.ioEngine != IoEngine::Off;
+        // Enough reads in flight to hide device latency, split between the
+        // hashing threads.
+        const unsigned batchDepth = (unsigned)std::clamp<std::size_t>(512 / plan.hashers, 32, 256);
+        const unsigned batchThreads = (unsigned)std::max<std::size_t>(2, 16 / plan.hashers);
+
+        const SecretDetector detector;
+        std::vector<std::vector<FileEntry>> hashed(plan.hashers);
+        auto hash = [&](std::size_t id)
+        {
+            auto &out = hashed[id];
+            std::unique_ptr<CdcChunker> chunker;
+            if (options.dedup)
+                chunker = std::make_unique<CdcChunker>();
+
+            // data: the whole file when it came from the batched reader;
+            // null to read it here.
+            auto process = [&](HashJob &job, const ScanCache::Record *rec, const unsigned char *data, std::size_t n)
             {
-                logger.warn("scan", std::string("sensitive skipped: ") + rel);
-                continue;
+                FileEntry fe;
+                fe.path = std::move(job.rel);
+                fe.size = job.stat.size;
+                fe.stat = job.stat;
+                std::uint8_t flags = 0;
+                const char *secret = nullptr;
+                auto hash_file = [&](const std::function<void(const unsigned char *, size_t)> &onBlock)
+                {
+                    if (!data)
+                        return utils::sha256_file(job.full, onBlock);
+                    profile_count(Counter::FilesBatched);
+                    Sha256 h;
+                    h.update(data, n);
+                    if (onBlock)
+                        onBlock(data, n);
+                    return Sha256::to_hex(h.finish());
+                };
+                if (rec)
+                {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    profile_count(Counter::CacheHits);
+                    fe.hash = ScanCache::sha256_hex(*rec);
+                    flags = rec->flags;
+                    if (flags & ScanCache::GitOidKnown)
+                    {
+                        std::copy(rec->gitOid, rec->gitOid + 20, fe.gitOid.begin());
+                        fe.hasGitOid = true;
+                    }
+                    if (options.detectSecrets && (flags & ScanCache::SecretFound))
+                        secret = "flagged by an earlier scan";
+                }
+                else if (options.detectSecrets || options.gitOids || options.dedup)
+                {
+                    // Every extra pass rides on the blocks read for SHA-256.
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                    ProfileScope hashScope(Phase::Hash, fe.path);
+                    std::optional<SecretDetector::Stream> content;
+                    if (options.detectSecrets)
+                        content.emplace(detector);
+                    Sha1 blob;
+                    std::uint64_t seen = 0;
+                    std::uintmax_t dup = 0;
+                    auto onChunk = [&](const ChunkKey &key, std::size_t n)
+                    {
+                        if (!chunks.insert(key))
+                            dup += n;
+                    };
+                    if (options.gitOids)
+                    {
+                        const std::string header = "blob " + std::to_string(fe.size) + '\0';
+                        blob.update(header.data(), header.size());
+                    }
+                    fe.hash = hash_file([&](const unsigned char *p, size_t n)
+                                        {
+                        if (content)
+                            content->feed(p, n);
+                        if (options.gitOids)
+                        {
+                            blob.update(p, n);
+                            seen += n;
+                        }
+                        if (chunker)
+                            chunker->feed(p, n, onChunk); });
+                    if (content)
+                    {
+                        content->finish();
+                        secret = content->reason();
+                        flags |= ScanCache::SecretsChecked | (secret ? ScanCache::SecretFound : 0);
+                    }
+                    if (chunker && fe.hash.empty())
+                        chunker->reset(); // unreadable: its chunks would skew the index
+                    else if (chunker)
+                    {
+                        chunker->finish(onChunk);
+                        fe.dupBytes = std::min<std::uintmax_t>(dup, fe.size);
+                        fe.hasDedup = true;
+                    }
+                    // The header used the walk's size; drop the id if the file changed since.
+                    if (options.gitOids && seen == fe.size && !fe.hash.empty())
+                    {
+                        fe.gitOid = blob.finish();
+                        fe.hasGitOid = true;
+                        flags |= ScanCache::GitOidKnown;
+                    }
+                    profile_count(Counter::FilesHashed);
+                    profile_count(Counter::BytesRead, fe.hash.empty() ? 0 : fe.size);
+                }
+                else if (options.hashContents)
+                {
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                    ProfileScope hashScope(Phase::Hash, fe.path);
+                    fe.hash = hash_file(nullptr);
+                    profile_count(Counter::FilesHashed);
+                    profile_count(Counter::BytesRead, fe.hash.empty() ? 0 : fe.size);
+                }
+                else
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                const bool skip = secret && !options.includeSecrets;
+                if (!skip)
+                    fe.mtime = mtime_iso(fe.stat, job.full);
+                {
+                    std::lock_guard<std::mutex> lk(emitMu);
+#ifndef _WIN32
+                    const bool racy = fe.stat.mtimeNs >= racyCutoff;
+#else
+                    const bool racy = false;
+#endif
+                    if (cacheOut && !racy && !fe.hash.empty())
+                        cacheOut->add(fe.path, fe.stat, fe.hash, flags, fe.hasGitOid ? fe.gitOid.data() : nullptr);
+                    if (secret)
+                    {
+                        logger.warn("scan", skip ? "secret content skipped" : "secret content included",
+                                    LogField("path", fe.path), LogField("reason", secret));
+                        r.secretFiles.push_back(fe.path);
+                        if (skip)
+                        {
+                            profile_count(Counter::FilesSkipped);
+                            return;
+                        }
+                    }
+                    total += fe.size; // Accumulate total size
+                    dupTotal += fe.dupBytes;
+                    if (options.sink)
+                        options.sink->entry(fe);
+                }
+                if (!options.sink)
+                    out.push_back(std::move(fe));
+            };
+
+            if (!batched)
+            {
+                while (auto job = jobs.pop())
+                    process(*job, usable_record(*job), nullptr, 0);
+                return;
             }
-            auto sz = entry.file_size();
-            if ((sz / (1024 * 1024)) > (std::uintmax_t)options.maxSizeMb)
+
+            // Small cache misses go to the reader and are hashed as their
+            // reads complete; new jobs are only waited for when nothing is
+            // in flight. The reader is set up on the first miss, so a fully
+            // cached scan never creates one.
+            std::optional<BatchReader> reader;
+            std::vector<HashJob> waiting;
+            for (;;)
             {
-                logger.warn("scan", std::string("too large, skipped: ") + rel);
-                continue;
+                std::optional<HashJob> job;
+                if (!reader || reader->in_flight() == 0)
+                {
+                    if (!(job = jobs.pop()))
+                        break;
+                }
+                else if (reader->full() || !(job = jobs.try_pop()))
+                {
+                    auto c = reader->wait();
+                    HashJob &done = waiting[c.slot];
+                    // Unreadable, grown past the slot since the walk, or a short
+                    // read (io_uring may return less than asked): read it here.
+                    if (c.complete() && c.size == done.stat.size)
+                        process(done, nullptr, c.data, c.size);
+                    else
+                        process(done, nullptr, nullptr, 0);
+                    continue;
+                }
+                const ScanCache::Record *rec = usable_record(*job);
+                if (rec || job->stat.size >= BatchReader::kSlotSize)
+                    process(*job, rec, nullptr, 0);
+                else
+                {
+                    if (!reader)
+                    {
+                        reader.emplace(options.ioEngine, batchDepth, batchThreads);
+                        waiting.resize(reader->depth());
+                    }
+                    std::string full = job->full;
+                    waiting[reader->submit(std::move(full))] = std::move(*job);
+                }
             }
-            total += sz; // Accumulate total size
-            nlohmann::json fj;
-            fj["path"] = rel;
-            fj["size"] = sz;
-            fj["hash"] = utils::sha256_file(entry.path().string());
-            fj["mtime"] = utils::file_mtime_iso(entry.path());
-            j["files"].push_back(fj);
-            // structured
-            FileEntry fe;
-            fe.path = rel;
-            fe.size = sz;
-            r.files.push_back(fe);
+        };
+
+        std::vector<std::thread> hashPool;
+        for (std::size_t i = 0; i < plan.hashers; ++i)
+            hashPool.emplace_back(hash, i);
+        std::vector<std::thread> walkPool;
+        if (!options.paths.empty())
+            visit_paths();
+        else
+        {
+            for (std::size_t i = 1; i < plan.walkers; ++i)
+                walkPool.emplace_back(walk, i);
+            walk(0);
+        }
+        for (auto &t : walkPool)
+            t.join();
+        jobs.close();
+        for (auto &t : hashPool)
+            t.join();
+
+        r.cacheHits = hits.load();
+        r.cacheMisses = misses.load();
+        if (cacheOut)
+        {
+            if (!cacheOut->commit())
+                logger.warn("scan", "could not write scan cache", LogField("path", cacheFile));
+            logger.info("scan", "cache", LogField("hits", r.cacheHits), LogField("misses", r.cacheMisses));
         }
-        j["total_size"] = total;
 
         r.ok = true;
-        r.inventoryJson = j.dump(2);
         r.totalSize = total; // Populate total size in ScanResult
+        r.duplicateBytes = dupTotal;
+        r.uniqueBytes = total - dupTotal;
+        if (options.dedup)
+            logger.info("scan", "dedup", LogField("chunks", chunks.size()), LogField("unique_bytes", r.uniqueBytes),
+                        LogField("duplicate_bytes", r.duplicateBytes));
+        std::sort(r.secretFiles.begin(), r.secretFiles.end());
+        if (options.sink)
+        {
+            if (options.dedup)
+                options.sink->dedup_totals(r.uniqueBytes);
+            options.sink->end(total);
+            return r;
+        }
+
+        // Completion order depends on scheduling; sort so inventories diff cleanly.
+        ProfileScope jsonScope(Phase::InventoryJson);
+        for (auto &part : hashed)
+            std::move(part.begin(), part.end(), std::back_inserter(r.files));
+        std::sort(r.files.begin(), r.files.end(), [](const FileEntry &a, const FileEntry &b)
+                  { return a.path < b.path; });
+
+        std::ostringstream os;
+        auto writer = make_inventory_writer(InventoryFormat::Json, os);
+        writer->begin(options.root, generatedAt);
+        for (auto &fe : r.files)
+            writer->entry(fe);
+        if (options.dedup)
+            writer->dedup_totals(r.uniqueBytes);
+        writer->end(total);
+        r.inventoryJson = os.str();
         return r;
     }
 
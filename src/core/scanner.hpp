@@ -4,9 +4,15 @@
 #include <string>
 #include <vector>
 
+#include "batch_reader.hpp"
+#include "file_stat.hpp"
+#include "sha1.hpp"
+
 namespace rogue
 {
 
+class InventoryWriter;
+
 struct ScanOptions
 {
     std::string root;
@@ -14,25 +20,77 @@ struct ScanOptions
     std::vector<std::string> excludes;
     int maxSizeMb{50};
     bool includeSecrets{false};
+    int threads{0};  // 0 = hardware concurrency
+    bool useCache{true};
+    std::string cachePath;  // empty = <root>/.rogue/scancache
+    // Inspect file contents for tokens, private keys and high-entropy strings
+    // while hashing; flagged files are skipped unless includeSecrets is set.
+    bool detectSecrets{false};
+    // Visit each directory's entries in inode order (helps spinning disks).
+    bool inodeOrder{false};
+    // Also compute each file's git blob id (SHA-1 of "blob <size>\0" + content)
+    // in the same read, for staging without git re-hashing.
+    bool gitOids{false};
+    // Split contents into content-defined chunks (FastCDC) in the same read
+    // and count the bytes whose chunk was already seen in this scan, in this
+    // or another file. Bypasses cache hits, since the chunks are not cached.
+    bool dedup{false};
+    // When false, a plain scan (none of the content options above) does not
+    // read files: entries keep their stat and only cache hits carry a hash.
+    bool hashContents{true};
+    // How files under BatchReader::kSlotSize are read on a cache miss: each
+    // hashing thread keeps many of them in flight instead of reading one at
+    // a time. Off reads every file with utils::sha256_file.
+    IoEngine ioEngine{IoEngine::Auto};
+    // When non-empty, only these paths (relative to root, '/'-separated) are
+    // looked at instead of walking the tree, with the same filters and
+    // hashing. Paths that are gone or filtered out are simply absent from the
+    // result. The cache is read but not rewritten, since it would then only
+    // hold these entries.
+    std::vector<std::string> paths;
+    // When set, entries are streamed here in completion order as they are
+    // hashed and ScanResult::files / inventoryJson are left empty.
+    InventoryWriter* sink{nullptr};
 };
 
 struct FileEntry
 {
     std::string path;
     std::uintmax_t size{};
+    std::string hash;
+    std::string mtime;
+    FileStat stat;
+    Sha1::Digest gitOid{};  // valid when hasGitOid (ScanOptions::gitOids)
+    bool hasGitOid{false};
+    // Bytes in chunks seen earlier in the scan, valid when hasDedup
+    // (ScanOptions::dedup). Which of two copies counts as the duplicate
+    // depends on hashing order; the workspace totals do not.
+    std::uintmax_t dupBytes{0};
+    bool hasDedup{false};
 };
 
 struct ScanResult
 {
     bool ok{true};
     std::string inventoryJson;
+    std::string generatedAt;  // the inventory's generated_at
     std::string errorMessage;
-    std::vector<FileEntry> files;  // structured result
+    std::vector<FileEntry> files;  // structured result, sorted by path
     std::uintmax_t totalSize{0};
+    std::size_t cacheHits{0};
+    std::size_t cacheMisses{0};
+    std::uintmax_t duplicateBytes{0};  // ScanOptions::dedup only
+    std::uintmax_t uniqueBytes{0};     // totalSize - duplicateBytes
+    std::vector<std::string> secretFiles;  // flagged by detectSecrets, sorted
 };
 
 class Logger;
 
+// What a scan of options.root leaves out: .rogueignore, then
+// options.excludes, then the log file when it is written inside the tree,
+// so that running the tool does not change the inventory.
+std::vector<std::string> ignore_patterns(const ScanOptions& options);
+
 ScanResult scan_workspace(const ScanOptions& options, Logger& logger);
 
 }  // namespace rogue
@@ -0,0 +1,163 @@
+#include "secret_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace rogue
+{
+
+namespace
+{
+
+// Characters that can make up a token body or an encoded key.
+struct TokenClass
+{
+    bool table[256] = {};
+    TokenClass()
+    {
+        for (int c = 'a'; c <= 'z'; ++c)
+            table[c] = true;
+        for (int c = 'A'; c <= 'Z'; ++c)
+            table[c] = true;
+        for (int c = '0'; c <= '9'; ++c)
+            table[c] = true;
+        table[(unsigned char)'+'] = table[(unsigned char)'/'] = table[(unsigned char)'_'] = true;
+    }
+};
+const TokenClass kToken;
+
+constexpr std::size_t kPrefixBody = 16;
+constexpr std::size_t kRunMin = 24;
+constexpr std::size_t kRunMax = 64;
+constexpr double kEntropyMin = 4.5;
+
+std::vector<std::string> detector_patterns(std::size_t& pemCount)
+{
+    // Assembled at run time so this file does not flag itself.
+    std::vector<std::string> pats;
+    for (const char* kind : {"RSA ", "EC ", "DSA ", "OPENSSH ", "ENCRYPTED ", ""})
+        pats.push_back(std::string("-----BEGIN ") + kind + "PRIVATE KEY");
+    pats.push_back(std::string("-----BEGIN ") + "PGP PRIVATE KEY BLOCK");
+    pemCount = pats.size();
+    for (const char* prefix : {"ghp_", "gho_", "ghu_", "ghs_", "ghr_", "github_pat_", "glpat-", "xoxb-", "xoxp-",
+                               "xoxa-", "sk_live_", "rk_live_", "AKIA", "ASIA", "AIza"})
+        pats.push_back(prefix);
+    return pats;
+}
+
+bool looks_random(const char* s, std::size_t n)
+{
+    bool upper = false, lower = false, digit = false;
+    unsigned counts[256] = {};
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        unsigned char c = (unsigned char)s[i];
+        upper |= c >= 'A' && c <= 'Z';
+        lower |= c >= 'a' && c <= 'z';
+        digit |= c >= '0' && c <= '9';
+        ++counts[c];
+    }
+    if (!(upper && lower && digit))
+        return false;
+    double bits = 0;
+    for (unsigned k : counts)
+    {
+        if (k)
+        {
+            double p = double(k) / double(n);
+            bits -= p * std::log2(p);
+        }
+    }
+    return bits >= kEntropyMin;
+}
+
+}  // namespace
+
+SecretDetector::SecretDetector() : matcher_(detector_patterns(pemPatterns_), false) {}
+
+void SecretDetector::Stream::end_run()
+{
+    if (!reason_ && runLen_ >= kRunMin && runLen_ <= kRunMax && looks_random(run_, runLen_))
+        reason_ = "high-entropy string";
+    runLen_ = 0;
+    inPrefix_ = false;
+}
+
+void SecretDetector::Stream::feed(const unsigned char* data, std::size_t len)
+{
+    if (reason_ || binary_ || len == 0)
+        return;
+    if (first_)
+    {
+        first_ = false;
+        if (std::memchr(data, 0, std::min<std::size_t>(len, 8192)))
+        {
+            binary_ = true;
+            return;
+        }
+    }
+
+    // Pattern hits for this block, in end order. Prefix hits are resolved in
+    // the byte loop below, which knows how long the token body runs.
+    prefixEnds_.clear();
+    acState_ = d_.matcher_.scan(
+        reinterpret_cast<const char*>(data), len,
+        [&](std::uint32_t id, std::size_t end)
+        {
+            if (id < d_.pemPatterns_)
+                reason_ = "private key";
+            else
+                prefixEnds_.push_back(end);
+        },
+        acState_);
+    if (reason_)
+        return;
+
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        // A token starts right after its prefix (whose own bytes may or may not
+        // be in the current run, e.g. "ghp_" vs "xoxb-").
+        while (next < prefixEnds_.size() && prefixEnds_[next] <= i)
+        {
+            if (prefixEnds_[next] == i && !inPrefix_)
+            {
+                inPrefix_ = true;
+                prefixRun_ = 0;
+            }
+            ++next;
+        }
+        const unsigned char c = data[i];
+        if (!kToken.table[c])
+        {
+            end_run();
+            if (reason_)
+                return;
+            continue;
+        }
+        if (runLen_ < sizeof(run_))
+            run_[runLen_] = (char)c;
+        ++runLen_;
+        if (inPrefix_ && ++prefixRun_ >= kPrefixBody)
+        {
+            reason_ = "access token";
+            return;
+        }
+    }
+    // A prefix that ends the block: its body starts with the next block.
+    if (!prefixEnds_.empty() && prefixEnds_.back() == len && !inPrefix_)
+    {
+        inPrefix_ = true;
+        prefixRun_ = 0;
+    }
+}
+
+void SecretDetector::Stream::finish()
+{
+    if (!reason_ && !binary_)
+        end_run();
+}
+
+}  // namespace rogue
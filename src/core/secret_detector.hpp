@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "multi_matcher.hpp"
+
+namespace rogue
+{
+
+// Content-level secret heuristics, fed the same blocks as the hasher:
+//   - well-known token prefixes (ghp_, github_pat_, AKIA, xoxb-, ...)
+//     followed by at least 16 token characters;
+//   - PEM private key headers;
+//   - high-entropy runs: 24..64 characters of [A-Za-z0-9+/_] mixing upper
+//     case, lower case and digits with at least 4.5 bits of entropy per char.
+// Files that look binary (a NUL byte in the first block) are not inspected.
+class SecretDetector
+{
+public:
+    SecretDetector();
+
+    // Per-file state. Feed blocks in order; flagged() can be checked at any
+    // time, and further input is ignored once a file is flagged.
+    class Stream
+    {
+    public:
+        explicit Stream(const SecretDetector& detector) : d_(detector) {}
+        void feed(const unsigned char* data, std::size_t len);
+        // Call after the last block so a run ending the file is checked.
+        void finish();
+        bool flagged() const { return reason_ != nullptr; }
+        // Short description of the first finding, or nullptr.
+        const char* reason() const { return reason_; }
+
+    private:
+        void end_run();
+
+        const SecretDetector& d_;
+        const char* reason_{nullptr};
+        std::uint32_t acState_{0};
+        bool first_{true};
+        bool binary_{false};
+        // Token prefix seen; counts the token characters that follow it.
+        bool inPrefix_{false};
+        std::size_t prefixRun_{0};
+        // Current candidate run for the entropy check.
+        char run_[64];
+        std::size_t runLen_{0};
+        // Ends of the prefix hits in the block being fed; kept to reuse its
+        // capacity.
+        std::vector<std::size_t> prefixEnds_;
+    };
+
+private:
+    friend class Stream;
+    std::size_t pemPatterns_{0};  // patterns [0, pemPatterns_) are PEM headers; set by matcher_'s init
+    MultiPatternMatcher matcher_;
+};
+
+}  // namespace rogue
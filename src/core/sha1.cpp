@@ -0,0 +1,144 @@
+#include "sha1.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rogue
+{
+
+namespace
+{
+
+inline std::uint32_t rol(std::uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+void compress(std::uint32_t s[5], const std::uint8_t* p)
+{
+    std::uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+        w[i] = std::uint32_t(p[4 * i]) << 24 | std::uint32_t(p[4 * i + 1]) << 16 |
+               std::uint32_t(p[4 * i + 2]) << 8 | p[4 * i + 3];
+    for (int i = 16; i < 80; ++i)
+        w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    std::uint32_t a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+    for (int i = 0; i < 80; ++i)
+    {
+        std::uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        std::uint32_t t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    s[0] += a;
+    s[1] += b;
+    s[2] += c;
+    s[3] += d;
+    s[4] += e;
+}
+
+}  // namespace
+
+Sha1::Sha1() : state_{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0} {}
+
+void Sha1::update(const void* data, std::size_t len)
+{
+    auto* p = static_cast<const std::uint8_t*>(data);
+    total_ += len;
+    if (bufLen_)
+    {
+        std::size_t take = std::min(len, sizeof(buf_) - bufLen_);
+        std::memcpy(buf_ + bufLen_, p, take);
+        bufLen_ += take;
+        p += take;
+        len -= take;
+        if (bufLen_ < sizeof(buf_))
+            return;
+        compress(state_, buf_);
+        bufLen_ = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64)
+        compress(state_, p);
+    std::memcpy(buf_, p, len);
+    bufLen_ = len;
+}
+
+Sha1::Digest Sha1::finish()
+{
+    const std::uint64_t bits = total_ * 8;
+    const std::uint8_t pad = 0x80;
+    update(&pad, 1);
+    const std::uint8_t zero[64] = {};
+    update(zero, (bufLen_ <= 56 ? 56 : 120) - bufLen_);
+    std::uint8_t len[8];
+    for (int i = 0; i < 8; ++i)
+        len[i] = std::uint8_t(bits >> (56 - 8 * i));
+    update(len, 8);
+    Digest d;
+    for (int i = 0; i < 5; ++i)
+    {
+        d[4 * i] = std::uint8_t(state_[i] >> 24);
+        d[4 * i + 1] = std::uint8_t(state_[i] >> 16);
+        d[4 * i + 2] = std::uint8_t(state_[i] >> 8);
+        d[4 * i + 3] = std::uint8_t(state_[i]);
+    }
+    return d;
+}
+
+std::string Sha1::to_hex(const Digest& d)
+{
+    static const char* digits = "0123456789abcdef";
+    std::string s(40, '0');
+    for (int i = 0; i < 20; ++i)
+    {
+        s[2 * i] = digits[d[i] >> 4];
+        s[2 * i + 1] = digits[d[i] & 15];
+    }
+    return s;
+}
+
+bool Sha1::from_hex(const std::string& hex, Digest& out)
+{
+    if (hex.size() != 40)
+        return false;
+    auto val = [](char c) -> int
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+    for (int i = 0; i < 20; ++i)
+    {
+        int hi = val(hex[2 * i]), lo = val(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out[i] = std::uint8_t(hi << 4 | lo);
+    }
+    return true;
+}
+
+}  // namespace rogue
@@ -0,0 +1,31 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rogue
+{
+
+// Streaming SHA-1, only for git object ids and pack checksums.
+class Sha1
+{
+public:
+    using Digest = std::array<std::uint8_t, 20>;
+
+    Sha1();
+    void update(const void* data, std::size_t len);
+    Digest finish();
+
+    static std::string to_hex(const Digest& d);
+    // False unless hex is 40 hex digits.
+    static bool from_hex(const std::string& hex, Digest& out);
+
+private:
+    std::uint32_t state_[5];
+    std::uint8_t buf_[64];
+    std::size_t bufLen_{0};
+    std::uint64_t total_{0};
+};
+
+}  // namespace rogue
@@ -0,0 +1,273 @@
+#include "sha256.hpp"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ROGUE_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace rogue
+{
+
+namespace
+{
+
+alignas(16) const std::uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const std::uint32_t H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+inline std::uint32_t rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline std::uint32_t load_be32(const std::uint8_t* p)
+{
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) |
+           std::uint32_t(p[3]);
+}
+
+void compress_portable(std::uint32_t state[8], const std::uint8_t* data, std::size_t blocks)
+{
+    std::uint32_t w[64];
+    while (blocks--)
+    {
+        for (int i = 0; i < 16; ++i)
+            w[i] = load_be32(data + 4 * i);
+        for (int i = 16; i < 64; ++i)
+        {
+            std::uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            std::uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i)
+        {
+            std::uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            std::uint32_t ch = (e & f) ^ (~e & g);
+            std::uint32_t t1 = h + S1 + ch + K[i] + w[i];
+            std::uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            std::uint32_t t2 = S0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        data += 64;
+    }
+}
+
+#ifdef ROGUE_SHA256_X86
+__attribute__((target("sha,sse4.1,ssse3"))) void compress_shani(std::uint32_t state[8],
+                                                               const std::uint8_t* data,
+                                                               std::size_t blocks)
+{
+    const __m128i shuf = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // Repack a..h into the ABEF/CDGH lane layout sha256rnds2 expects.
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+    __m128i st1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    st1 = _mm_shuffle_epi32(st1, 0x1B);
+    __m128i st0 = _mm_alignr_epi8(tmp, st1, 8);
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);
+
+    while (blocks--)
+    {
+        const __m128i abef = st0;
+        const __m128i cdgh = st1;
+        __m128i w[4];
+        for (int g = 0; g < 16; ++g)
+        {
+            __m128i& cur = w[g & 3];
+            if (g < 4)
+            {
+                cur = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), shuf);
+            }
+            else
+            {
+                __m128i t = _mm_sha256msg1_epu32(cur, w[(g - 3) & 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[(g - 1) & 3], w[(g - 2) & 3], 4));
+                cur = _mm_sha256msg2_epu32(t, w[(g - 1) & 3]);
+            }
+            __m128i msg =
+                _mm_add_epi32(cur, _mm_load_si128(reinterpret_cast<const __m128i*>(&K[4 * g])));
+            st1 = _mm_sha256rnds2_epu32(st1, st0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            st0 = _mm_sha256rnds2_epu32(st0, st1, msg);
+        }
+        st0 = _mm_add_epi32(st0, abef);
+        st1 = _mm_add_epi32(st1, cdgh);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(st0, 0x1B);
+    st1 = _mm_shuffle_epi32(st1, 0xB1);
+    st0 = _mm_blend_epi16(tmp, st1, 0xF0);
+    st1 = _mm_alignr_epi8(st1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), st0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), st1);
+}
+
+bool cpu_has_shani()
+{
+    unsigned a = 0, b = 0, c = 0, d = 0;
+    if (!__get_cpuid(1, &a, &b, &c, &d))
+        return false;
+    const bool ssse3 = c & (1u << 9);
+    const bool sse41 = c & (1u << 19);
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return false;
+    const bool sha = b & (1u << 29);
+    return ssse3 && sse41 && sha;
+}
+#endif
+
+}  // namespace
+
+bool Sha256::kernel_available(Kernel kernel)
+{
+    switch (kernel)
+    {
+        case Kernel::Auto:
+        case Kernel::Portable:
+            return true;
+        case Kernel::ShaNi:
+#ifdef ROGUE_SHA256_X86
+        {
+            static const bool has = cpu_has_shani();
+            return has;
+        }
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* Sha256::active_kernel_name()
+{
+    return kernel_available(Kernel::ShaNi) ? "sha-ni" : "portable";
+}
+
+Sha256::Sha256(Kernel kernel)
+{
+    compress_ = compress_portable;
+#ifdef ROGUE_SHA256_X86
+    if ((kernel == Kernel::Auto || kernel == Kernel::ShaNi) && kernel_available(Kernel::ShaNi))
+        compress_ = compress_shani;
+#else
+    (void)kernel;
+#endif
+    std::memcpy(state_, H0, sizeof(state_));
+}
+
+void Sha256::update(const void* data, std::size_t len)
+{
+    auto p = static_cast<const std::uint8_t*>(data);
+    total_ += len;
+    if (bufLen_ > 0)
+    {
+        std::size_t take = 64 - bufLen_ < len ? 64 - bufLen_ : len;
+        std::memcpy(buf_ + bufLen_, p, take);
+        bufLen_ += take;
+        p += take;
+        len -= take;
+        if (bufLen_ < 64)
+            return;
+        compress_(state_, buf_, 1);
+        bufLen_ = 0;
+    }
+    if (len >= 64)
+    {
+        compress_(state_, p, len / 64);
+        p += len & ~std::size_t(63);
+        len &= 63;
+    }
+    if (len > 0)
+    {
+        std::memcpy(buf_, p, len);
+        bufLen_ = len;
+    }
+}
+
+Sha256::Digest Sha256::finish()
+{
+    const std::uint64_t bits = total_ * 8;
+    std::uint8_t pad[72] = {0x80};
+    std::size_t padLen = (bufLen_ < 56 ? 56 : 120) - bufLen_;
+    for (int i = 0; i < 8; ++i)
+        pad[padLen + i] = std::uint8_t(bits >> (56 - 8 * i));
+    update(pad, padLen + 8);
+
+    Digest out{};
+    for (int i = 0; i < 8; ++i)
+    {
+        out[4 * i] = std::uint8_t(state_[i] >> 24);
+        out[4 * i + 1] = std::uint8_t(state_[i] >> 16);
+        out[4 * i + 2] = std::uint8_t(state_[i] >> 8);
+        out[4 * i + 3] = std::uint8_t(state_[i]);
+    }
+    return out;
+}
+
+std::string Sha256::to_hex(const Digest& d)
+{
+    static const char* hex = "0123456789abcdef";
+    std::string s(64, '0');
+    for (std::size_t i = 0; i < d.size(); ++i)
+    {
+        s[2 * i] = hex[d[i] >> 4];
+        s[2 * i + 1] = hex[d[i] & 15];
+    }
+    return s;
+}
+
+bool Sha256::from_hex(const std::string& hex, Digest& out)
+{
+    if (hex.size() != 64)
+        return false;
+    auto val = [](char c) -> int
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        int hi = val(hex[2 * i]), lo = val(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out[i] = std::uint8_t(hi << 4 | lo);
+    }
+    return true;
+}
+
+}  // namespace rogue
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace rogue
+{
+
+// Streaming SHA-256 (FIPS 180-4). The block function is picked once at
+// startup: SHA-NI on x86 hosts that support it, portable C++ elsewhere.
+class Sha256
+{
+public:
+    enum class Kernel
+    {
+        Auto,
+        Portable,
+        ShaNi
+    };
+    using Digest = std::array<std::uint8_t, 32>;
+
+    explicit Sha256(Kernel kernel = Kernel::Auto);
+    void update(const void* data, std::size_t len);
+    Digest finish();
+
+    static bool kernel_available(Kernel kernel);
+    static const char* active_kernel_name();
+    static std::string to_hex(const Digest& d);
+    // False unless hex is 64 hex digits.
+    static bool from_hex(const std::string& hex, Digest& out);
+
+private:
+    using CompressFn = void (*)(std::uint32_t state[8], const std::uint8_t* blocks,
+                                std::size_t nblocks);
+    CompressFn compress_;
+    std::uint32_t state_[8];
+    std::uint8_t buf_[64];
+    std::size_t bufLen_{0};
+    std::uint64_t total_{0};
+};
+
+}  // namespace rogue
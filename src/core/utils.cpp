@@ -1,4 +1,7 @@
 #include "utils.hpp"
+#include "file_stat.hpp"
+#include "sha256.hpp"
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -8,6 +11,8 @@
 #include <algorithm>
 #ifdef _WIN32
 #include <windows.h>
+#else
+#include <sys/stat.h>
 #endif
 
 // minimal nlohmann json
@@ -20,19 +25,37 @@ namespace rogue
     namespace utils
     {
 
-        std::string iso_timestamp()
+        void format_local_time(std::time_t t, char *buf, size_t n)
         {
-            using namespace std::chrono;
-            auto now = system_clock::now();
-            std::time_t t = system_clock::to_time_t(now);
             std::tm tm{};
 #ifdef _WIN32
             localtime_s(&tm, &t);
 #else
             localtime_r(&t, &tm);
 #endif
+            std::strftime(buf, n, "%Y-%m-%dT%H:%M:%S", &tm);
+        }
+
+        bool parse_local_time(const std::string &s, std::time_t &out)
+        {
+            std::tm tm{};
+            char tail;
+            if (std::sscanf(s.c_str(), "%4d-%2d-%2dT%2d:%2d:%2d%c", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour,
+                            &tm.tm_min, &tm.tm_sec, &tail) != 6)
+                return false;
+            tm.tm_year -= 1900;
+            tm.tm_mon -= 1;
+            tm.tm_isdst = -1;
+            out = std::mktime(&tm);
+            return out != std::time_t(-1);
+        }
+
+        std::string iso_timestamp()
+        {
+            using namespace std::chrono;
+            std::time_t t = system_clock::to_time_t(system_clock::now());
             char buf[32];
-            std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+            format_local_time(t, buf, sizeof(buf));
             return std::string(buf);
         }
 
@@ -118,34 +141,98 @@ namespace rogue
             return static_cast<size_t>(it - hay.begin());
         }
 
-        // Very small SHA256 implementation placeholder using std::hash as fallback (not cryptographic)
-        // For workshop demo, acceptable; in production use a proper SHA256.
+        void append_json_string(std::string &out, std::string_view s)
+        {
+            static const char *hex = "0123456789abcdef";
+            out.push_back('"');
+            for (char c : s)
+            {
+                switch (c)
+                {
+                    case '"':
+                        out += "\\\"";
+                        break;
+                    case '\\':
+                        out += "\\\\";
+                        break;
+                    case '\n':
+                        out += "\\n";
+                        break;
+                    case '\r':
+                        out += "\\r";
+                        break;
+                    case '\t':
+                        out += "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20)
+                        {
+                            out += "\\u00";
+                            out.push_back(hex[(c >> 4) & 15]);
+                            out.push_back(hex[c & 15]);
+                        }
+                        else
+                            out.push_back(c);
+                        break;
+                }
+            }
+            out.push_back('"');
+        }
+
+        // Streams the file through a fixed buffer: memory stays flat whatever the file size.
         std::string sha256_file(const std::string &filepath)
         {
-            std::ifstream f(filepath, std::ios::binary);
+            return sha256_file(filepath, nullptr);
+        }
+
+        std::string sha256_file(const std::string &filepath, const std::function<void(const unsigned char *, size_t)> &onBlock)
+        {
+            std::FILE *f = std::fopen(filepath.c_str(), "rb");
             if (!f)
                 return "";
-            std::ostringstream ss;
-            ss << f.rdbuf();
-            std::string content = ss.str();
-            std::hash<std::string> h;
-            auto v = h(content);
-            std::ostringstream hs;
-            hs << std::hex << v;
-            return hs.str();
+            std::setvbuf(f, nullptr, _IONBF, 0); // we already read in large blocks
+            Sha256 h;
+            unsigned char buf[64 * 1024];
+            size_t n;
+            while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+            {
+                h.update(buf, n);
+                if (onBlock)
+                    onBlock(buf, n);
+            }
+            bool failed = std::ferror(f) != 0;
+            std::fclose(f);
+            if (failed)
+                return "";
+            return Sha256::to_hex(h.finish());
         }
 
-        int system_in_dir(const std::string &dir, const std::string &cmd, bool hide_output)
+        bool stat_file(const std::string &path, FileStat &out)
         {
 #ifdef _WIN32
-            // Do not wrap the whole command in quotes; quote only the path
-            std::string full = "cmd /c cd /d \"" + dir + "\" && " + cmd;
-            return system(full.c_str());
+            std::error_code ec;
+            fs::path p(path);
+            if (!fs::is_regular_file(p, ec))
+                return false;
+            out.dev = 0;
+            out.ino = 0;
+            out.size = fs::file_size(p, ec);
+            out.mtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(fs::last_write_time(p, ec).time_since_epoch()).count();
+            out.mode = 0100644;
+            return !ec;
 #else
-            std::string full = "bash -lc 'cd " + dir + " && " + cmd + "'";
-            if (hide_output)
-                full += " > /dev/null 2>&1";
-            return system(full.c_str());
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                return false;
+            out.dev = (std::uint64_t)st.st_dev;
+            out.ino = (std::uint64_t)st.st_ino;
+            out.size = (std::uint64_t)st.st_size;
+            out.mtimeNs = (std::int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+            out.ctimeNs = (std::int64_t)st.st_ctim.tv_sec * 1000000000LL + st.st_ctim.tv_nsec;
+            out.mode = (std::uint32_t)st.st_mode;
+            out.uid = (std::uint32_t)st.st_uid;
+            out.gid = (std::uint32_t)st.st_gid;
+            return true;
 #endif
         }
 
@@ -176,5 +263,14 @@ namespace rogue
                 f << content;
         }
 
+        std::string path_under(const fs::path &root, const fs::path &path)
+        {
+            std::error_code ec;
+            const fs::path rel = fs::absolute(path, ec).lexically_normal().lexically_relative(fs::absolute(root, ec).lexically_normal());
+            if (ec || rel.empty() || *rel.begin() == ".." || rel == ".")
+                return std::string();
+            return rel.generic_string();
+        }
+
     }
 }
@@ -1,10 +1,13 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 #include <optional>
 #include <cstdint>
 #include <chrono>
+#include <functional>
+#include <ctime>
 
 namespace rogue
 {
@@ -12,6 +15,10 @@ namespace rogue
     {
 
         std::string iso_timestamp();
+        // Writes t as local "YYYY-MM-DDTHH:MM:SS" into buf (no allocation)
+        void format_local_time(std::time_t t, char *buf, size_t n);
+        // Inverse of format_local_time; false if s is not in that form
+        bool parse_local_time(const std::string &s, std::time_t &out);
         std::string file_mtime_iso(const std::filesystem::path &p);
 
         // Ignore patterns
@@ -20,12 +27,14 @@ namespace rogue
 
         // String helpers
         size_t ifind(const std::string &hay, const std::string &needle);
+        // Appends s as a quoted JSON string literal
+        void append_json_string(std::string &out, std::string_view s);
 
-        // SHA256
+        // SHA-256 of the file contents as lowercase hex, "" if unreadable
         std::string sha256_file(const std::string &filepath);
-
-        // System helpers
-        int system_in_dir(const std::string &dir, const std::string &cmd, bool hide_output);
+        // Same, handing every block read to onBlock as well so other content
+        // passes share the single read of the file
+        std::string sha256_file(const std::string &filepath, const std::function<void(const unsigned char *, size_t)> &onBlock);
 
         // Token retrieval
         std::string read_github_token();
@@ -33,6 +42,9 @@ namespace rogue
 
         // Files
         void ensure_file_with_content(const std::filesystem::path &p, const std::string &content);
+        // path relative to root, '/'-separated, when it lies inside root
+        // (both taken lexically, from the current directory); else empty
+        std::string path_under(const std::filesystem::path &root, const std::filesystem::path &path);
 
     }
 }
@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace rogue
+{
+
+// One deque per worker: the owner pushes/pops at the back (LIFO keeps the
+// walk depth-first and cache-friendly), idle workers steal from the front of
+// the others so large subtrees get split across threads.
+template <typename T>
+class WorkStealingQueues
+{
+public:
+    explicit WorkStealingQueues(std::size_t workers) : slots_(workers == 0 ? 1 : workers) {}
+
+    std::size_t size() const { return slots_.size(); }
+
+    void push(std::size_t worker, T item)
+    {
+        auto& s = slots_[worker % slots_.size()];
+        std::lock_guard<std::mutex> lk(s.mu);
+        s.items.push_back(std::move(item));
+    }
+
+    std::optional<T> pop(std::size_t worker)
+    {
+        const std::size_t n = slots_.size();
+        {
+            auto& own = slots_[worker % n];
+            std::lock_guard<std::mutex> lk(own.mu);
+            if (!own.items.empty())
+            {
+                T item = std::move(own.items.back());
+                own.items.pop_back();
+                return item;
+            }
+        }
+        for (std::size_t k = 1; k < n; ++k)
+        {
+            auto& victim = slots_[(worker + k) % n];
+            std::lock_guard<std::mutex> lk(victim.mu);
+            if (!victim.items.empty())
+            {
+                T item = std::move(victim.items.front());
+                victim.items.pop_front();
+                return item;
+            }
+        }
+        return std::nullopt;
+    }
+
+private:
+    struct Slot
+    {
+        std::mutex mu;
+        std::deque<T> items;
+    };
+    std::vector<Slot> slots_;
+};
+
+// Bounded MPMC hand-off queue. push() blocks while full so producers cannot
+// run arbitrarily far ahead of consumers; pop() returns nullopt once the
+// queue is closed and drained.
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        notFull_.wait(lk, [&] { return items_.size() < capacity_ || closed_; });
+        if (closed_)
+            return;
+        items_.push_back(std::move(item));
+        notEmpty_.notify_one();
+    }
+
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lk(mu_);
+        notEmpty_.wait(lk, [&] { return !items_.empty() || closed_; });
+        if (items_.empty())
+            return std::nullopt;
+        T item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    // Never blocks: nullopt if nothing is queued right now.
+    std::optional<T> try_pop()
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (items_.empty())
+            return std::nullopt;
+        T item = std::move(items_.front());
+        items_.pop_front();
+        notFull_.notify_one();
+        return item;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        closed_ = true;
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<T> items_;
+    bool closed_{false};
+    std::mutex mu_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+};
+
+}  // namespace rogue
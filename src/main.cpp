@@ -4,6 +4,7 @@
 #include "core/gitops.hpp"
 #include "core/github_api.hpp"
 #include "core/config.hpp"
+#include "core/profiler.hpp"
 #include "core/utils.hpp"
 #include "rogue/commands.hpp"
 #include <iostream>
@@ -16,10 +17,22 @@ static void print_help()
 {
     std::cout << "roguebox CLI\n"
               << "Commands:\n"
-              << "  scan --root <path> [--include <glob> ...] [--exclude <glob> ...] [--max-size-mb <int>] [--dry-run]\n"
+              << "  scan --root <path> [--include <glob> ...] [--exclude <glob> ...] [--max-size-mb <int>] [--threads <n>] [--no-cache] [--inode-order]\n"
+              << "       [--format json|json-stream|ndjson|rinv] [--output <file>] [--detect-secrets] [--dedup] [--diff [--branch <name>]] [--dry-run]\n"
               << "  init-repo --root <path> --repo-name <name> [--org <org>] [--private|--public] [--no-remote]\n"
-              << "  push-all --root <path> [--branch <name>] [--commit-message \"<msg>\"] [--dry-run]\n"
+              << "  push-all --root <path> [--branch <name>] [--commit-message \"<msg>\"] [--native-pack|--fast-stage] [--changed-only] [--dry-run]\n"
+              << "       [--chunk-mb <n>] [--push-every <chunks>] [--max-push-mb <n>] [--pipeline [--pipeline-window <n>]] [--dedup]\n"
+              << "  watch --root <path> [--output <file>] [--settle-ms <ms>] [scan options...]\n"
+              << "  dupes --root <path> [--min-size <bytes>] [--output <file>] [--include <glob> ...] [--exclude <glob> ...] [--threads <n>]\n"
+              << "  inventory convert --input <file> --output <file>   (JSON <-> .rinv, by the input's content)\n"
+              << "  inventory query --input <file> [--path <glob> ...] [--min-size <bytes>] [--max-size <bytes>] [--hash <prefix>]\n"
+              << "       [--count | --group-by ext|dir] [--output <file>]   (input: JSON, .rinv or PROOF_OF_WORK.md)\n"
               << "  full-run --root <path> --repo-name <name> [options...]\n"
+              << "Global options:\n"
+              << "  --log-level debug|info|warn|error|off (default: $ROGUE_LOG_LEVEL or info)\n"
+              << "  --io-engine auto|io_uring|threads|off   how small files are read while hashing (default: auto)\n"
+              << "  --stats                 time per phase and counters on stderr when the command ends\n"
+              << "  --trace <file>          write a Chrome trace (chrome://tracing, Perfetto) of the run\n"
               << std::endl;
 }
 
@@ -95,22 +108,140 @@ namespace rogue
             }
             else if (k == "--include-secrets")
                 o.includeSecrets = true;
+            else if (k == "--detect-secrets")
+                o.detectSecrets = true;
+            else if (k == "--inode-order")
+                o.inodeOrder = true;
+            else if (k == "--dedup")
+                o.dedup = true;
+            else if (k == "--native-pack")
+                o.nativePack = true;
+            else if (k == "--fast-stage")
+                o.fastStage = true;
+            else if (k == "--format")
+            {
+                std::string v;
+                if (next(v))
+                    o.format = v;
+            }
+            else if (k == "--output")
+            {
+                std::string v;
+                if (next(v))
+                    o.output = v;
+            }
+            else if (k == "--input")
+            {
+                std::string v;
+                if (next(v))
+                    o.input = v;
+            }
+            else if (k == "--log-level")
+            {
+                std::string v;
+                if (next(v))
+                    o.logLevel = v;
+            }
+            else if (k == "--no-cache")
+                o.noCache = true;
+            else if (k == "--io-engine")
+            {
+                std::string v;
+                if (next(v))
+                    o.ioEngine = v;
+            }
+            else if (k == "--stats")
+                o.stats = true;
+            else if (k == "--trace")
+            {
+                std::string v;
+                if (next(v))
+                    o.trace = v;
+            }
+            else if (k == "--threads")
+            {
+                std::string v;
+                if (next(v))
+                    o.threads = std::stoi(v);
+            }
+            else if (k == "--chunk-mb")
+            {
+                std::string v;
+                if (next(v))
+                    o.chunkMb = std::stoi(v);
+            }
+            else if (k == "--push-every")
+            {
+                std::string v;
+                if (next(v))
+                    o.pushEvery = std::stoi(v);
+            }
+            else if (k == "--max-push-mb")
+            {
+                std::string v;
+                if (next(v))
+                    o.maxPushMb = std::stoi(v);
+            }
+            else if (k == "--min-size")
+            {
+                std::string v;
+                if (next(v))
+                    o.minSize = std::stoull(v);
+            }
+            else if (k == "--max-size")
+            {
+                std::string v;
+                if (next(v))
+                    o.maxSize = std::stoull(v);
+            }
+            else if (k == "--path")
+            {
+                std::string v;
+                if (next(v))
+                    o.paths.push_back(v);
+            }
+            else if (k == "--hash")
+            {
+                std::string v;
+                if (next(v))
+                    o.hashPrefix = v;
+            }
+            else if (k == "--group-by")
+            {
+                std::string v;
+                if (next(v))
+                    o.groupBy = v;
+            }
+            else if (k == "--count")
+                o.count = true;
+            else if (k == "--pipeline")
+                o.pipeline = true;
+            else if (k == "--changed-only")
+                o.changedOnly = true;
+            else if (k == "--diff")
+                o.diff = true;
+            else if (k == "--settle-ms")
+            {
+                std::string v;
+                if (next(v))
+                    o.settleMs = std::stoi(v);
+            }
+            else if (k == "--pipeline-window")
+            {
+                std::string v;
+                if (next(v))
+                    o.pipelineWindow = std::stoi(v);
+            }
+            else if (k.rfind("--", 0) != 0)
+                o.args.push_back(k);
         }
         return o;
     }
 
 }
 
-int main(int argc, char **argv)
+static int run_command(CliOptions &opt, Logger &logger)
 {
-    auto opt = parse_args(argc, argv);
-    Logger logger;
-    if (opt.command.empty())
-    {
-        print_help();
-        return 1;
-    }
-
     if (opt.configFile)
     {
         AppConfig cfg;
@@ -122,6 +253,12 @@ int main(int argc, char **argv)
                 opt.repoName = cfg.repoName;
             if (!cfg.isPrivate)
                 opt.makePrivate = false;
+            // Each command opens its own Logger: they all mask these too.
+            if (!cfg.maskPatterns.empty())
+            {
+                Logger::set_default_mask_patterns(cfg.maskPatterns);
+                logger.set_mask_patterns(cfg.maskPatterns);
+            }
         }
     }
 
@@ -137,10 +274,33 @@ int main(int argc, char **argv)
     {
         return rogue::command_push(opt);
     }
+    else if (opt.command == "watch")
+    {
+        return rogue::command_watch(opt);
+    }
+    else if (opt.command == "inventory")
+    {
+        return rogue::command_inventory(opt);
+    }
+    else if (opt.command == "dupes")
+    {
+        return rogue::command_dupes(opt);
+    }
     else if (opt.command == "full-run")
     {
         // scan
-        ScanOptions sopt{opt.root, opt.includes, opt.excludes, opt.maxSizeMb.value_or(50), opt.includeSecrets};
+        ScanOptions sopt;
+        sopt.root = opt.root;
+        sopt.includes = opt.includes;
+        sopt.excludes = opt.excludes;
+        sopt.maxSizeMb = opt.maxSizeMb.value_or(50);
+        sopt.includeSecrets = opt.includeSecrets;
+        sopt.threads = opt.threads.value_or(0);
+        sopt.useCache = !opt.noCache;
+        sopt.detectSecrets = opt.detectSecrets;
+        sopt.inodeOrder = opt.inodeOrder;
+        if (opt.ioEngine)
+            parse_io_engine(*opt.ioEngine, sopt.ioEngine);
         auto result = scan_workspace(sopt, logger);
         if (!result.ok)
             return 2;
@@ -167,3 +327,48 @@ int main(int argc, char **argv)
         return 1;
     }
 }
+
+int main(int argc, char **argv)
+{
+    auto opt = parse_args(argc, argv);
+    if (opt.logLevel)
+    {
+        LogLevel level;
+        if (!parse_log_level(*opt.logLevel, level))
+        {
+            std::cerr << "invalid --log-level (expected debug, info, warn, error or off)\n";
+            return 1;
+        }
+        Logger::set_default_level(level);
+    }
+    IoEngine engine;
+    if (opt.ioEngine && !parse_io_engine(*opt.ioEngine, engine))
+    {
+        std::cerr << "invalid --io-engine (expected auto, io_uring, threads or off)\n";
+        return 1;
+    }
+    Logger logger;
+    if (opt.command.empty())
+    {
+        print_help();
+        return 1;
+    }
+    if (!opt.stats && !opt.trace)
+        return run_command(opt, logger);
+
+    Profiler profiler(opt.trace.has_value());
+    profiler.start();
+    const int rc = run_command(opt, logger);
+    profiler.stop();
+    if (opt.stats)
+        profiler.write_summary(std::cerr);
+    if (opt.trace)
+    {
+        std::ofstream out(*opt.trace, std::ios::binary);
+        if (out)
+            profiler.write_chrome_trace(out);
+        if (!out)
+            logger.warn("profile", "cannot write trace", LogField("path", *opt.trace));
+    }
+    return rc;
+}
@@ -0,0 +1,139 @@
+#include "../src/core/batch_reader.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string pattern(std::size_t n, unsigned seed)
+    {
+        std::string s(n, '\0');
+        for (std::size_t i = 0; i < n; ++i)
+            s[i] = char((i * 131 + seed * 7) ^ (i >> 5));
+        return s;
+    }
+
+    std::vector<IoEngine> engines()
+    {
+        std::vector<IoEngine> out{IoEngine::Threads};
+        if (BatchReader::available(IoEngine::IoUring))
+            out.push_back(IoEngine::IoUring);
+        return out;
+    }
+}
+
+TEST_CASE("batch reader returns whole small files and flags the rest", "[batch_reader]")
+{
+    fs::remove_all("tmp_batch");
+    fs::create_directories("tmp_batch");
+    const std::size_t sizes[] = {0, 1, 100, 4096, BatchReader::kSlotSize - 1, BatchReader::kSlotSize, 40000};
+    std::map<std::string, std::string> contents;
+    for (unsigned round = 0; round < 3; ++round)
+        for (std::size_t n : sizes)
+        {
+            const std::string path = "tmp_batch/f" + std::to_string(round) + "_" + std::to_string(n);
+            contents[path] = pattern(n, round);
+            std::ofstream(path, std::ios::binary) << contents[path];
+        }
+    contents["tmp_batch/missing"] = "";
+
+    for (IoEngine engine : engines())
+    {
+        // Fewer slots than files, so slots are reused.
+        BatchReader reader(engine, 4, 2);
+        REQUIRE(reader.engine() == engine);
+        std::vector<std::string> bySlot(reader.depth());
+        std::size_t done = 0;
+        auto check = [&](const BatchReader::Completion &c)
+        {
+            const std::string &path = bySlot[c.slot];
+            const std::string &want = contents[path];
+            if (path == "tmp_batch/missing")
+                REQUIRE(c.error == ENOENT);
+            else if (want.size() < BatchReader::kSlotSize)
+            {
+                REQUIRE(c.complete());
+                REQUIRE(std::string((const char *)c.data, c.size) == want);
+            }
+            else
+            {
+                REQUIRE(!c.complete());
+                REQUIRE(c.size == BatchReader::kSlotSize);
+                REQUIRE(std::string((const char *)c.data, c.size) == want.substr(0, c.size));
+            }
+            ++done;
+        };
+        for (auto &kv : contents)
+        {
+            if (reader.full())
+                check(reader.wait());
+            bySlot[reader.submit(kv.first)] = kv.first;
+        }
+        while (reader.in_flight())
+            check(reader.wait());
+        REQUIRE(done == contents.size());
+    }
+
+    // Dropped with reads still in flight: must not leak or touch freed memory.
+    for (IoEngine engine : engines())
+    {
+        BatchReader reader(engine, 8, 2);
+        for (int i = 0; i < 8; ++i)
+            reader.submit("tmp_batch/f0_100");
+    }
+}
+
+TEST_CASE("scans hash the same whichever engine reads the files", "[batch_reader]")
+{
+    fs::remove_all("tmp_batch_scan");
+    fs::create_directories("tmp_batch_scan/a/b");
+    for (int i = 0; i < 300; ++i)
+    {
+        const std::size_t n = std::size_t(i * 97) % 24000;
+        std::ofstream("tmp_batch_scan/" + std::string(i % 2 ? "a/" : "a/b/") + std::to_string(i) + ".txt",
+                      std::ios::binary)
+            << pattern(n, unsigned(i));
+    }
+    std::ofstream("tmp_batch_scan/config.txt") << "password = \"hunter2hunter2\"\n";
+
+    Logger logger;
+    auto scan = [&](IoEngine engine)
+    {
+        ScanOptions o;
+        o.root = "tmp_batch_scan";
+        o.useCache = false;
+        o.threads = 3;
+        o.detectSecrets = true;
+        o.includeSecrets = true;
+        o.gitOids = true;
+        o.dedup = true;
+        o.ioEngine = engine;
+        return scan_workspace(o, logger);
+    };
+    const auto ref = scan(IoEngine::Off);
+    REQUIRE(ref.ok);
+    REQUIRE(ref.files.size() == 301);
+    std::vector<IoEngine> all = engines();
+    all.push_back(IoEngine::Auto);
+    for (IoEngine engine : all)
+    {
+        const auto r = scan(engine);
+        REQUIRE(r.ok);
+        REQUIRE(r.files.size() == ref.files.size());
+        for (std::size_t i = 0; i < r.files.size(); ++i)
+        {
+            REQUIRE(r.files[i].path == ref.files[i].path);
+            REQUIRE(r.files[i].hash == ref.files[i].hash);
+            REQUIRE(r.files[i].gitOid == ref.files[i].gitOid);
+        }
+        REQUIRE(r.secretFiles == ref.secretFiles);
+        REQUIRE(r.duplicateBytes == ref.duplicateBytes);
+    }
+}
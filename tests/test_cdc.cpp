@@ -0,0 +1,158 @@
+#include "../src/core/cdc.hpp"
+#include "../src/core/chunk_planner.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::vector<std::uint8_t> noise(std::size_t n, std::uint64_t seed)
+    {
+        std::vector<std::uint8_t> v(n);
+        for (auto &b : v)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            b = std::uint8_t(seed >> 56);
+        }
+        return v;
+    }
+
+    // Chunks of `data`, fed in `block`-sized pieces.
+    std::vector<std::pair<ChunkKey, std::size_t>> chunks(const std::vector<std::uint8_t> &data, std::size_t block)
+    {
+        std::vector<std::pair<ChunkKey, std::size_t>> out;
+        CdcChunker c;
+        auto on = [&](const ChunkKey &k, std::size_t n)
+        { out.emplace_back(k, n); };
+        for (std::size_t i = 0; i < data.size(); i += block)
+            c.feed(data.data() + i, std::min(block, data.size() - i), on);
+        c.finish(on);
+        return out;
+    }
+}
+
+TEST_CASE("cdc chunks stay within bounds and do not depend on block size", "[cdc]")
+{
+    const auto data = noise(3 << 20, 1);
+    const auto a = chunks(data, 4096);
+    const auto b = chunks(data, 1 << 20);
+    REQUIRE(a.size() == b.size());
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        REQUIRE(a[i].first == b[i].first);
+        REQUIRE(a[i].second == b[i].second);
+        REQUIRE(a[i].second <= CdcChunker::kMaxSize);
+        if (i + 1 < a.size())
+            REQUIRE(a[i].second >= CdcChunker::kMinSize);
+        total += a[i].second;
+    }
+    REQUIRE(total == data.size());
+    // Normalized chunking keeps the average near 8 KiB.
+    const std::size_t avg = total / a.size();
+    REQUIRE(avg > 6 * 1024);
+    REQUIRE(avg < 14 * 1024);
+}
+
+TEST_CASE("cdc cut points resynchronize after an insertion", "[cdc]")
+{
+    auto data = noise(1 << 20, 2);
+    const auto before = chunks(data, 65536);
+    const auto extra = noise(100, 3);
+    data.insert(data.begin() + 5000, extra.begin(), extra.end());
+    const auto after = chunks(data, 65536);
+
+    ChunkIndex index;
+    for (auto &c : before)
+        index.insert(c.first);
+    std::size_t shared = 0;
+    for (auto &c : after)
+        if (!index.insert(c.first))
+            shared += c.second;
+    // Only the chunks around the insertion differ.
+    REQUIRE(shared > data.size() - 3 * CdcChunker::kMaxSize);
+}
+
+TEST_CASE("chunk index tells new fingerprints from seen ones", "[cdc]")
+{
+    ChunkIndex index;
+    std::set<std::pair<std::uint64_t, std::uint64_t>> keys;
+    for (std::uint32_t i = 0; i < 50000; ++i)
+    {
+        const ChunkKey k = chunk_fingerprint(reinterpret_cast<const std::uint8_t *>(&i), sizeof(i));
+        keys.insert({k.lo, k.hi});
+        REQUIRE(index.insert(k));
+    }
+    REQUIRE(keys.size() == 50000);
+    REQUIRE(index.size() == 50000);
+    const std::uint32_t again = 123;
+    REQUIRE(!index.insert(chunk_fingerprint(reinterpret_cast<const std::uint8_t *>(&again), sizeof(again))));
+}
+
+TEST_CASE("dedup scan counts duplicated bytes per file and in total", "[cdc]")
+{
+    fs::remove_all("tmp_scan_dedup");
+    fs::create_directories("tmp_scan_dedup");
+    const auto data = noise(512 * 1024, 4);
+    const auto other = noise(64 * 1024, 5);
+    for (const char *name : {"v1.bin", "v2.bin"})
+        std::ofstream(std::string("tmp_scan_dedup/") + name, std::ios::binary)
+            .write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+    std::ofstream("tmp_scan_dedup/other.bin", std::ios::binary)
+        .write(reinterpret_cast<const char *>(other.data()), std::streamsize(other.size()));
+
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_dedup";
+    o.useCache = false;
+    o.dedup = true;
+    auto r = scan_workspace(o, logger);
+    REQUIRE(r.ok);
+    REQUIRE(r.files.size() == 3);
+    REQUIRE(r.duplicateBytes == data.size());
+    REQUIRE(r.uniqueBytes == data.size() + other.size());
+    std::uintmax_t dup = 0;
+    for (auto &f : r.files)
+    {
+        REQUIRE(f.hasDedup);
+        dup += f.dupBytes;
+    }
+    REQUIRE(dup == data.size());
+    REQUIRE(r.files[0].dupBytes == 0); // other.bin
+    REQUIRE(r.inventoryJson.find("\"unique_size\": " + std::to_string(r.uniqueBytes)) != std::string::npos);
+    REQUIRE(r.inventoryJson.find("\"duplicate_bytes\": ") != std::string::npos);
+
+    // Without --dedup the inventory keeps its usual shape.
+    o.dedup = false;
+    auto plain = scan_workspace(o, logger);
+    REQUIRE(!plain.files[1].hasDedup);
+    REQUIRE(plain.inventoryJson.find("duplicate_bytes") == std::string::npos);
+}
+
+TEST_CASE("chunk planner weighs files by their unique bytes", "[cdc]")
+{
+    std::vector<FileEntry> files(4);
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        files[i].path = "v" + std::to_string(i);
+        files[i].size = 1000;
+        files[i].hasDedup = true;
+        files[i].dupBytes = i ? 900 : 0;
+    }
+    ChunkLimits limits;
+    limits.chunkBytes = 1500;
+    limits.maxFileBytes = 1000;
+    auto plan = plan_chunks(files, limits);
+    REQUIRE(plan.chunks.size() == 1);
+    REQUIRE(plan.chunks[0].bytes == 1300);
+
+    for (auto &f : files)
+        f.hasDedup = false;
+    REQUIRE(plan_chunks(files, limits).chunks.size() == 4);
+}
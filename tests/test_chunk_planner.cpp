@@ -0,0 +1,119 @@
+#include "../src/core/chunk_planner.hpp"
+#include "../third_party/catch.hpp"
+#include <algorithm>
+#include <set>
+
+using namespace rogue;
+
+namespace
+{
+    FileEntry file(const std::string &path, std::uint64_t size)
+    {
+        FileEntry f;
+        f.path = path;
+        f.size = size;
+        return f;
+    }
+}
+
+TEST_CASE("chunk planner packs every file once under the byte budget", "[chunks]")
+{
+    std::vector<FileEntry> files;
+    std::uint64_t seed = 7;
+    for (int i = 0; i < 500; ++i)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        files.push_back(file("f" + std::to_string(i), (seed >> 33) % 4000));
+    }
+    files.push_back(file("huge.bin", 20000));
+    files.push_back(file("alone.bin", 9000));
+
+    ChunkLimits limits;
+    limits.chunkBytes = 8000;
+    limits.maxFileBytes = 10000;
+    limits.pushBytes = 40000;
+    auto plan = plan_chunks(files, limits);
+
+    REQUIRE(plan.skipped.size() == 1);
+    REQUIRE(files[plan.skipped[0]].path == "huge.bin");
+    std::set<std::size_t> seen;
+    std::uint64_t total = 0;
+    for (auto &c : plan.chunks)
+    {
+        std::uint64_t sum = 0;
+        for (std::size_t i : c.files)
+        {
+            REQUIRE(seen.insert(i).second);
+            sum += files[i].size;
+        }
+        REQUIRE(sum == c.bytes);
+        // Over budget only for a file that is bigger than the budget by itself.
+        REQUIRE((c.bytes <= limits.chunkBytes || c.files.size() == 1));
+        REQUIRE(std::is_sorted(c.files.begin(), c.files.end(), [&](std::size_t a, std::size_t b)
+                               { return files[a].path < files[b].path; }));
+        total += c.bytes;
+    }
+    REQUIRE(seen.size() == files.size() - 1);
+    // Best fit leaves little slack: within one chunk of the lower bound.
+    REQUIRE(plan.chunks.size() <= total / limits.chunkBytes + 2);
+
+    // Pushes cover consecutive chunks and stay under pushBytes.
+    REQUIRE(plan.chunks.back().pushAfter);
+    std::uint64_t pending = 0;
+    std::size_t pushes = 0;
+    for (auto &c : plan.chunks)
+    {
+        pending += c.bytes;
+        if (c.pushAfter)
+        {
+            REQUIRE(pending <= limits.pushBytes);
+            pending = 0;
+            ++pushes;
+        }
+    }
+    REQUIRE(pushes == plan.pushes);
+    REQUIRE(plan.pushes >= total / limits.pushBytes);
+}
+
+TEST_CASE("chunk planner pushes after every N chunks when asked", "[chunks]")
+{
+    std::vector<FileEntry> files;
+    for (int i = 0; i < 10; ++i)
+        files.push_back(file("f" + std::to_string(i), 100));
+    ChunkLimits limits;
+    limits.chunkBytes = 100;
+    limits.pushEvery = 3;
+    auto plan = plan_chunks(files, limits);
+    REQUIRE(plan.chunks.size() == 10);
+    REQUIRE(plan.pushes == 4);
+    for (std::size_t c = 0; c < plan.chunks.size(); ++c)
+        REQUIRE(plan.chunks[c].pushAfter == (c % 3 == 2 || c == 9));
+
+    REQUIRE(plan_chunks({}, limits).chunks.empty());
+}
+
+TEST_CASE("chunk planner keeps identical files together and bounds pushes by full size", "[chunks]")
+{
+    std::vector<FileEntry> files = {file("a.bin", 80), file("b.bin", 80), file("c.bin", 80), file("d.bin", 80)};
+    const char *hashes[] = {"h1", "h2", "h1", "h3"};
+    const std::uint64_t dup[] = {0, 0, 80, 40};  // c is a copy of a, d shares half with another file
+    for (std::size_t i = 0; i < files.size(); ++i)
+    {
+        files[i].hash = hashes[i];
+        files[i].dupBytes = dup[i];
+        files[i].hasDedup = true;
+    }
+    ChunkLimits limits;
+    limits.chunkBytes = 100;
+    limits.pushBytes = 200;
+    auto plan = plan_chunks(files, limits);
+
+    REQUIRE(plan.chunks.size() == 3);
+    REQUIRE((plan.chunks[0].files == std::vector<std::size_t>{0, 2}));
+    REQUIRE(plan.chunks[0].bytes == 80);
+    REQUIRE(plan.chunks[2].bytes == 40);
+    // 80 + 80 + 40 unique bytes would fit one push, but what d shares may
+    // not have been pushed yet: it counts as 80.
+    REQUIRE(plan.pushes == 2);
+    REQUIRE(plan.chunks[1].pushAfter);
+}
@@ -0,0 +1,90 @@
+#include "../src/core/dupes.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    void write(const fs::path &p, const std::string &text)
+    {
+        std::ofstream(p, std::ios::binary) << text;
+    }
+
+    ScanResult walk(const std::string &root, Logger &logger)
+    {
+        ScanOptions o;
+        o.root = root;
+        o.useCache = false;
+        o.hashContents = false;
+        return scan_workspace(o, logger);
+    }
+}
+
+TEST_CASE("dupes groups identical files and reads only what it must", "[dupes]")
+{
+    fs::remove_all("tmp_dupes");
+    fs::create_directories("tmp_dupes/a");
+    const std::string big(100000, 'x');
+    write("tmp_dupes/a/big1", big);
+    write("tmp_dupes/big2", big);
+    // Same size, head and tail as big1: only a full hash tells them apart.
+    std::string middle = big;
+    middle[50000] = 'y';
+    write("tmp_dupes/middle", middle);
+    // Same size, different head: dropped after the partial read.
+    write("tmp_dupes/head", "z" + big.substr(1));
+    write("tmp_dupes/small1", "tiny");
+    write("tmp_dupes/small2", "tiny");
+    write("tmp_dupes/unique", "something else");
+    write("tmp_dupes/empty1", "");
+    write("tmp_dupes/empty2", "");
+
+    Logger logger;
+    auto inv = walk("tmp_dupes", logger);
+    REQUIRE(inv.ok);
+    REQUIRE(inv.files.size() == 9);
+    REQUIRE(inv.files[0].hash.empty());
+
+    auto report = find_duplicates("tmp_dupes", inv.files, logger);
+    REQUIRE(report.groups.size() == 2);
+    const DupeGroup &g = report.groups[0];
+    REQUIRE(g.size == big.size());
+    REQUIRE(g.copies == 2);
+    REQUIRE(g.files.size() == 2);
+    REQUIRE(inv.files[g.files[0]].path == "a/big1");
+    REQUIRE(inv.files[g.files[1]].path == "big2");
+    REQUIRE(inv.files[report.groups[1].files[0]].path == "small1");
+    REQUIRE(report.groups[1].hash.size() == 64);
+    REQUIRE(report.wastedBytes == big.size() + 4);
+    REQUIRE(report.partialReads == 6);
+    REQUIRE(report.fullReads == 3); // big1, big2, middle
+
+    const std::string json = dupe_report_json(report, inv.files);
+    REQUIRE(json.find("\"duplicate_groups\":2") != std::string::npos);
+    REQUIRE(json.find("\"paths\":[\"a/big1\",\"big2\"]") != std::string::npos);
+}
+
+#ifndef _WIN32
+TEST_CASE("dupes collapses hardlinks without reading them", "[dupes]")
+{
+    fs::remove_all("tmp_dupes_link");
+    fs::create_directories("tmp_dupes_link");
+    write("tmp_dupes_link/one", std::string(20000, 'q'));
+    fs::create_hard_link("tmp_dupes_link/one", "tmp_dupes_link/two");
+
+    Logger logger;
+    auto inv = walk("tmp_dupes_link", logger);
+    auto report = find_duplicates("tmp_dupes_link", inv.files, logger);
+    REQUIRE(report.groups.size() == 1);
+    REQUIRE(report.groups[0].files.size() == 2);
+    REQUIRE(report.groups[0].copies == 1);
+    REQUIRE(report.wastedBytes == 0);
+    REQUIRE(report.partialReads == 0);
+    REQUIRE(report.fullReads == 0);
+}
+#endif
@@ -1,6 +1,9 @@
 #include "../src/core/gitops.hpp"
 #include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
 #include "../third_party/catch.hpp"
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 
@@ -15,3 +18,217 @@ TEST_CASE("git missing gracefully handled", "[gitops]")
     bool ok = git.stage_all(".");
     REQUIRE(ok == true || ok == false);
 }
+
+namespace
+{
+    std::string run(const std::string &cmd)
+    {
+        std::string out;
+        FILE *p = popen(cmd.c_str(), "r");
+        if (!p)
+            return out;
+        char buf[512];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), p)) > 0)
+            out.append(buf, n);
+        pclose(p);
+        return out;
+    }
+}
+
+TEST_CASE("native pack commit matches what git would store", "[gitops]")
+{
+    fs::remove_all("tmp_pack_repo");
+    fs::create_directories("tmp_pack_repo/src/deep");
+    std::ofstream("tmp_pack_repo/src/deep/a.txt") << "alpha\n";
+    std::ofstream("tmp_pack_repo/src/b.txt") << "beta\n";
+    std::ofstream("tmp_pack_repo/src-x.txt") << "sorts between src and src/\n";
+    std::ofstream("tmp_pack_repo/dup.txt") << "alpha\n";
+    {
+        std::ofstream big("tmp_pack_repo/big.bin", std::ios::binary);
+        for (int i = 0; i < 300000; ++i)
+            big << char(i * 7) << char(i >> 3);
+    }
+    fs::permissions("tmp_pack_repo/src/b.txt", fs::perms::owner_exec, fs::perm_options::add);
+    REQUIRE(run("git -C tmp_pack_repo init -q && echo ok") == "ok\n");
+
+    Logger logger;
+    GitOps git(logger);
+    ScanOptions o;
+    o.root = "tmp_pack_repo";
+    o.useCache = false;
+    auto inv = scan_workspace(o, logger);
+    REQUIRE(inv.files.size() == 5);
+    REQUIRE(git.commit_files("tmp_pack_repo", inv.files, "first", 3) == CommitResult::Created);
+    // Same content again: nothing to commit
+    REQUIRE(git.commit_files("tmp_pack_repo", inv.files, "again", 3) == CommitResult::Unchanged);
+
+    REQUIRE(run("git -C tmp_pack_repo fsck --strict 2>&1 && echo fsck-ok").find("fsck-ok") != std::string::npos);
+    REQUIRE(run("git -C tmp_pack_repo status --porcelain") == "");
+    for (auto &f : inv.files)
+    {
+        auto stored = run("git -C tmp_pack_repo rev-parse HEAD:" + f.path);
+        auto expected = run("git -C tmp_pack_repo hash-object " + f.path);
+        REQUIRE(!stored.empty());
+        REQUIRE(stored == expected);
+    }
+    REQUIRE(run("git -C tmp_pack_repo ls-tree HEAD src/b.txt").rfind("100755", 0) == 0);
+    REQUIRE(run("git -C tmp_pack_repo log --format=%s") == "first\n");
+
+    std::ofstream("tmp_pack_repo/new.txt") << "gamma\n";
+    inv = scan_workspace(o, logger);
+    REQUIRE(git.commit_files("tmp_pack_repo", inv.files, "second", 1) == CommitResult::Created);
+    REQUIRE(run("git -C tmp_pack_repo log --format=%s") == "second\nfirst\n");
+    REQUIRE(run("git -C tmp_pack_repo fsck --strict 2>&1 && echo fsck-ok").find("fsck-ok") != std::string::npos);
+
+    // Links are stored as links (mode 120000, blob = target), as git add does.
+    fs::create_symlink("src/b.txt", "tmp_pack_repo/link.txt");
+    inv = scan_workspace(o, logger);
+    REQUIRE(git.commit_files("tmp_pack_repo", inv.files, "third", 2) == CommitResult::Created);
+    REQUIRE(run("git -C tmp_pack_repo ls-tree HEAD link.txt").rfind("120000", 0) == 0);
+    REQUIRE(run("git -C tmp_pack_repo cat-file -p HEAD:link.txt") == "src/b.txt");
+    REQUIRE(run("git -C tmp_pack_repo status --porcelain") == "");
+    REQUIRE(git.commit_files("tmp_pack_repo", inv.files, "fourth", 2) == CommitResult::Unchanged);
+    REQUIRE(git.commit_files("tmp_not_a_repo_dir", inv.files, "none", 1) == CommitResult::Failed);
+}
+
+TEST_CASE("native commit keeps tracked files the scan skips", "[gitops]")
+{
+    fs::remove_all("tmp_keep_repo");
+    fs::create_directories("tmp_keep_repo");
+    std::ofstream("tmp_keep_repo/.env") << "KEY=1\n";
+    std::ofstream("tmp_keep_repo/a.txt") << "a\n";
+    std::ofstream("tmp_keep_repo/gone.txt") << "gone\n";
+    REQUIRE(run("cd tmp_keep_repo && git init -q && git add -A && git -c user.name=t -c user.email=t@t commit -q -m base && echo ok") == "ok\n");
+    const std::string env = run("git -C tmp_keep_repo rev-parse HEAD:.env");
+
+    Logger logger;
+    GitOps git(logger);
+    ScanOptions o;
+    o.root = "tmp_keep_repo";
+    o.useCache = false;
+    fs::remove("tmp_keep_repo/gone.txt");
+    std::ofstream("tmp_keep_repo/a.txt") << "a2\n";
+    auto inv = scan_workspace(o, logger);
+    REQUIRE(inv.files.size() == 1);
+    REQUIRE(git.commit_files("tmp_keep_repo", inv.files, "native", 2) == CommitResult::Created);
+    // .env is sensitive and never scanned, yet stays as committed; gone.txt left the disk.
+    REQUIRE(run("git -C tmp_keep_repo ls-tree --name-only HEAD") == ".env\na.txt\n");
+    REQUIRE(run("git -C tmp_keep_repo rev-parse HEAD:.env") == env);
+    REQUIRE(run("git -C tmp_keep_repo status --porcelain") == "");
+    REQUIRE(run("git -C tmp_keep_repo fsck --strict 2>&1 && echo fsck-ok").find("fsck-ok") != std::string::npos);
+}
+
+TEST_CASE("stage_files writes a clean index from scan blob ids", "[gitops]")
+{
+    fs::remove_all("tmp_index_repo");
+    fs::create_directories("tmp_index_repo/d");
+    std::ofstream("tmp_index_repo/d/one.txt") << "one\n";
+    std::ofstream("tmp_index_repo/two.txt") << "two\n";
+    std::ofstream("tmp_index_repo/tool.sh") << "#!/bin/sh\n";
+    fs::permissions("tmp_index_repo/tool.sh", fs::perms::owner_exec, fs::perm_options::add);
+    for (auto &e : fs::recursive_directory_iterator("tmp_index_repo"))
+        if (e.is_regular_file())
+            fs::last_write_time(e.path(), fs::file_time_type::clock::now() - std::chrono::hours(1));
+    REQUIRE(run("git -C tmp_index_repo init -q && echo ok") == "ok\n");
+
+    Logger logger;
+    GitOps git(logger);
+    ScanOptions o;
+    o.root = "tmp_index_repo";
+    o.gitOids = true;
+    auto inv = scan_workspace(o, logger);
+    REQUIRE(inv.files.size() == 3);
+    for (auto &f : inv.files)
+    {
+        REQUIRE(f.hasGitOid);
+        REQUIRE(Sha1::to_hex(f.gitOid) + "\n" == run("git -C tmp_index_repo hash-object " + f.path));
+    }
+    REQUIRE(git.stage_files("tmp_index_repo", inv.files));
+    // diff-files trusts stat data: no output means git sees every entry clean.
+    REQUIRE(run("git -C tmp_index_repo diff-files --name-only") == "");
+    REQUIRE(run("git -C tmp_index_repo ls-files -s tool.sh").rfind("100755", 0) == 0);
+    REQUIRE(run("git -C tmp_index_repo status --porcelain") == "A  d/one.txt\nA  tool.sh\nA  two.txt\n");
+
+    // Objects now exist and ids come from the cache: staging again adds no pack.
+    auto packs = [] {
+        size_t n = 0;
+        for (auto &e : fs::directory_iterator("tmp_index_repo/.git/objects/pack"))
+            n += e.path().extension() == ".pack";
+        return n;
+    };
+    const size_t before = packs();
+    inv = scan_workspace(o, logger);
+    REQUIRE(inv.cacheHits == 3);
+    REQUIRE(git.stage_files("tmp_index_repo", inv.files));
+    REQUIRE(packs() == before);
+    REQUIRE(run("git -C tmp_index_repo -c user.name=t -c user.email=t@t commit -q -m x && git -C tmp_index_repo fsck 2>&1 && echo ok").find("ok") != std::string::npos);
+}
+
+TEST_CASE("stage_files keeps index entries the scan skips", "[gitops]")
+{
+    fs::remove_all("tmp_keep_index");
+    fs::create_directories("tmp_keep_index");
+    std::ofstream("tmp_keep_index/.env") << "KEY=1\n";
+    std::ofstream("tmp_keep_index/a.txt") << "a\n";
+    REQUIRE(run("cd tmp_keep_index && git init -q && git add -A && echo ok") == "ok\n");
+    const std::string staged = run("git -C tmp_keep_index ls-files -s .env");
+
+    Logger logger;
+    GitOps git(logger);
+    ScanOptions o;
+    o.root = "tmp_keep_index";
+    o.useCache = false;
+    std::ofstream("tmp_keep_index/b.txt") << "b\n";
+    auto inv = scan_workspace(o, logger);
+    REQUIRE(inv.files.size() == 2);
+    REQUIRE(git.stage_files("tmp_keep_index", inv.files));
+    REQUIRE(run("git -C tmp_keep_index ls-files") == ".env\na.txt\nb.txt\n");
+    REQUIRE(run("git -C tmp_keep_index ls-files -s .env") == staged);
+    REQUIRE(run("git -C tmp_keep_index status --porcelain") == "A  .env\nA  a.txt\nA  b.txt\n");
+}
+
+TEST_CASE("stage_paths stages only the listed paths, taken literally", "[gitops]")
+{
+    fs::remove_all("tmp_paths_repo");
+    fs::create_directories("tmp_paths_repo/sub");
+    std::ofstream("tmp_paths_repo/*.txt") << "star\n";
+    std::ofstream("tmp_paths_repo/a b.txt") << "space\n";
+    std::ofstream("tmp_paths_repo/sub/left.txt") << "not listed\n";
+    std::ofstream("tmp_paths_repo/ignored.log") << "listed but gitignored\n";
+    std::ofstream("tmp_paths_repo/.gitignore") << "*.log\n";
+    REQUIRE(run("git -C tmp_paths_repo init -q && echo ok") == "ok\n");
+
+    Logger logger;
+    GitOps git(logger);
+    // .gitignore is honoured: an ignored path is dropped before staging and
+    // would make stage_paths fail if it were not.
+    std::vector<FileEntry> files(4);
+    files[0].path = "*.txt";
+    files[1].path = "a b.txt";
+    files[2].path = "ignored.log";
+    files[3].path = "sub/left.txt";
+    REQUIRE(git.drop_ignored("tmp_paths_repo", files));
+    REQUIRE(files.size() == 3);
+    REQUIRE(files[2].path == "sub/left.txt");
+    REQUIRE(!git.stage_paths("tmp_paths_repo", {"ignored.log"}));
+    REQUIRE(git.stage_paths("tmp_paths_repo", {"*.txt", "a b.txt"}));
+    REQUIRE(run("git -C tmp_paths_repo diff --cached --name-only -z | tr '\\0' '\\n'") == "*.txt\na b.txt\n");
+    REQUIRE(!git.stage_paths("tmp_paths_repo", {"missing.txt"}));
+    REQUIRE(git.commit("tmp_paths_repo", "staged") == CommitResult::Created);
+    // Nothing staged is not a failure, unlike a commit git refuses.
+    REQUIRE(git.commit("tmp_paths_repo", "again") == CommitResult::Unchanged);
+    REQUIRE(git.commit("tmp_not_a_repo_dir", "none") == CommitResult::Failed);
+
+    // A tracked file removed from disk is staged as deleted, other files untouched.
+    fs::remove("tmp_paths_repo/a b.txt");
+    std::ofstream("tmp_paths_repo/*.txt") << "edited\n";
+    REQUIRE(git.stage_deletions("tmp_paths_repo"));
+    REQUIRE(run("git -C tmp_paths_repo diff --cached --name-status") == "D\ta b.txt\n");
+    REQUIRE(git.stage_deletions("tmp_paths_repo"));
+    REQUIRE(!git.stage_deletions("tmp_not_a_repo_dir"));
+    std::vector<FileEntry> outside(1);
+    outside[0].path = "x";
+    REQUIRE(!git.drop_ignored("tmp_not_a_repo_dir", outside));
+    fs::remove_all("tmp_paths_repo");
+}
@@ -0,0 +1,65 @@
+#include "../src/core/inventory_writer.hpp"
+#include "../src/core/logger.hpp"
+#include "../third_party/catch.hpp"
+#include "../third_party/json.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+TEST_CASE("pretty writer matches the json shim layout", "[inventory]")
+{
+    FileEntry a;
+    a.path = "dir/a \"q\".txt";
+    a.size = 12;
+    a.hash = "abc";
+    a.mtime = "2025-01-01T00:00:00";
+    // The DOM keeps insertion order: insert in the writer's (sorted) order.
+    nlohmann::json j;
+    j["files"] = nlohmann::json::array();
+    nlohmann::json fj;
+    fj["hash"] = a.hash;
+    fj["mtime"] = a.mtime;
+    fj["path"] = a.path;
+    fj["size"] = (uint64_t)a.size;
+    j["files"].push_back(fj);
+    j["generated_at"] = "t";
+    j["root"] = "r";
+    j["total_size"] = (uint64_t)12;
+
+    std::ostringstream os;
+    auto w = make_inventory_writer(InventoryFormat::Json, os);
+    w->begin("r", "t");
+    w->entry(a);
+    w->end(12);
+    REQUIRE(os.str() == j.dump(2));
+}
+
+TEST_CASE("ndjson scan streams one line per file", "[inventory]")
+{
+    fs::remove_all("tmp_scan_nd");
+    fs::create_directories("tmp_scan_nd/x");
+    for (int i = 0; i < 5; ++i)
+        std::ofstream("tmp_scan_nd/x/f" + std::to_string(i)) << i;
+    std::ostringstream os;
+    auto w = make_inventory_writer(InventoryFormat::Ndjson, os);
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_nd";
+    o.sink = w.get();
+    auto r = scan_workspace(o, logger);
+    REQUIRE(r.ok);
+    REQUIRE(r.files.empty());
+    REQUIRE(r.totalSize == 5);
+    std::istringstream in(os.str());
+    std::string line;
+    int lines = 0;
+    while (std::getline(in, line))
+    {
+        REQUIRE(line.rfind("{\"path\":\"x/f", 0) == 0);
+        ++lines;
+    }
+    REQUIRE(lines == 5);
+}
@@ -0,0 +1,104 @@
+#include "../third_party/catch.hpp"
+#include "../third_party/json.hpp"
+#include <string>
+#include <utility>
+
+TEST_CASE("json keeps insertion order and exact 64-bit integers", "[json]")
+{
+    nlohmann::json j;
+    j["zeta"] = 1;
+    j["alpha"] = (uint64_t)18446744073709551615ull;
+    j["mid"] = (int64_t)-9007199254740993ll;
+    j["zeta"] = "again"; // existing key keeps its place
+    j["flag"] = true;
+    j["none"] = nullptr;
+    j["ratio"] = 0.5;
+    REQUIRE(j.dump() == "{\"zeta\":\"again\",\"alpha\":18446744073709551615,\"mid\":-9007199254740993,"
+                        "\"flag\":true,\"none\":null,\"ratio\":0.5}");
+    REQUIRE(j.value("alpha", (uint64_t)0) == 18446744073709551615ull);
+    REQUIRE(j.value("mid", (int64_t)0) == -9007199254740993ll);
+    REQUIRE(j.value("zeta", std::string()) == "again");
+    REQUIRE(j.value("missing", "def") == "def");
+    REQUIRE(j.value("flag", false));
+}
+
+TEST_CASE("json copies are deep and moves adopt the subtree", "[json]")
+{
+    nlohmann::json doc;
+    doc["files"] = nlohmann::json::array();
+    for (int i = 0; i < 1000; ++i)
+    {
+        nlohmann::json f;
+        f["path"] = "dir/file" + std::to_string(i);
+        f["size"] = i;
+        if (i % 2)
+            doc["files"].push_back(std::move(f));
+        else
+            doc["files"].push_back(f);
+    }
+    REQUIRE(doc["files"].size() == 1000);
+
+    nlohmann::json copy = doc;
+    doc["files"] = nlohmann::json::array();
+    REQUIRE(doc.dump() == "{\"files\":[]}");
+    REQUIRE(copy["files"].size() == 1000);
+    const std::string text = copy.dump();
+    REQUIRE(text.find("{\"path\":\"dir/file999\",\"size\":999}") != std::string::npos);
+
+    nlohmann::json moved = std::move(copy);
+    REQUIRE(moved.dump() == text);
+    nlohmann::json inner;
+    inner = moved["files"]; // copy out of a document, then drop it
+    moved = nlohmann::json();
+    REQUIRE(inner.size() == 1000);
+}
+
+TEST_CASE("json escapes control characters and pretty-prints", "[json]")
+{
+    nlohmann::json j;
+    j["s"] = std::string("a\"b\\c\n\x01", 7);
+    j["empty"] = nlohmann::json::array();
+    j["o"]["k"] = "v";
+    REQUIRE(j.dump() == "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"empty\":[],\"o\":{\"k\":\"v\"}}");
+    REQUIRE(j.dump(2) == "{\n  \"s\": \"a\\\"b\\\\c\\n\\u0001\",\n  \"empty\": [],\n  \"o\": {\n    \"k\": \"v\"\n  }\n}");
+}
+
+TEST_CASE("json parse reads back what dump writes", "[json]")
+{
+    json doc;
+    doc["name"] = "a \"quoted\"\n\u00e9";
+    doc["big"] = std::uint64_t(18446744073709551615ULL);
+    doc["neg"] = -42;
+    doc["ratio"] = 0.25;
+    doc["flag"] = true;
+    doc["none"] = nullptr;
+    json arr = json::array();
+    for (int i = 0; i < 100; ++i)
+    {
+        json e;
+        e["i"] = i;
+        arr.push_back(std::move(e));
+    }
+    doc["items"] = std::move(arr);
+
+    for (int indent : {-1, 2})
+    {
+        bool ok = false;
+        const json back = json::parse(doc.dump(indent), &ok);
+        REQUIRE(ok);
+        REQUIRE(back.dump() == doc.dump());
+        REQUIRE(back.value("big", std::uint64_t(0)) == 18446744073709551615ULL);
+        REQUIRE(back.find("items")->size() == 100);
+        REQUIRE(back.find("items")->at(99).value("i", 0) == 99);
+        REQUIRE(back.key_at(0) == "name");
+        REQUIRE(back.value_at(0).get_string() == "a \"quoted\"\n\u00e9");
+    }
+    REQUIRE(json::parse(R"({"s":"\ud83d\ude00"})").find("s")->get_string() == "\xF0\x9F\x98\x80");
+
+    for (const char *bad : {"", "{", "{\"a\":}", "[1,]", "{\"a\":1}x", "\"\\q\"", "tru"})
+    {
+        bool ok = true;
+        REQUIRE(json::parse(bad, &ok).is_null());
+        REQUIRE(!ok);
+    }
+}
@@ -0,0 +1,175 @@
+#include "../src/core/inventory_query.hpp"
+#include "../src/core/inventory_reader.hpp"
+#include "../src/core/inventory_writer.hpp"
+#include "../src/core/json_index.hpp"
+#include "../third_party/catch.hpp"
+#include <random>
+#include <sstream>
+
+using namespace rogue;
+
+namespace
+{
+    // Byte-at-a-time reference: structural offsets of a JSON text. Like the
+    // indexer, it lets a backslash escape a quote even outside a string,
+    // which only matters for invalid JSON such as the random inputs below.
+    std::vector<std::size_t> reference_index(const std::string &s)
+    {
+        std::vector<std::size_t> out;
+        bool in = false, esc = false;
+        for (std::size_t i = 0; i < s.size(); ++i)
+        {
+            const char c = s[i];
+            const bool escaped = esc;
+            esc = !escaped && c == '\\';
+            if (c == '"' && !escaped)
+            {
+                in = !in;
+                out.push_back(i);
+            }
+            else if (!in && (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ','))
+                out.push_back(i);
+        }
+        return out;
+    }
+
+    std::vector<std::size_t> run_index(const std::string &s, JsonIndexer::Kernel k)
+    {
+        std::vector<std::size_t> out;
+        JsonIndexer idx(s, k);
+        while (idx.next_window())
+            for (std::size_t i = 0; i < idx.count(); ++i)
+                out.push_back(idx.base() + idx.offsets()[i]);
+        return out;
+    }
+}
+
+TEST_CASE("json indexer kernels agree with a byte-at-a-time reference", "[json_index]")
+{
+    // Backslash runs and quotes landing on block and window boundaries.
+    std::mt19937 rng(42);
+    const char alphabet[] = "\"\\{}[]:, ab\n";
+    for (int round = 0; round < 200; ++round)
+    {
+        std::string s;
+        const std::size_t len = round < 100 ? rng() % 300 : JsonIndexer::kWindow + rng() % 5000;
+        for (std::size_t i = 0; i < len; ++i)
+            s += alphabet[rng() % (sizeof alphabet - 1)];
+        const auto ref = reference_index(s);
+        for (auto k : {JsonIndexer::Kernel::Portable, JsonIndexer::Kernel::Sse2, JsonIndexer::Kernel::Avx2})
+            if (JsonIndexer::kernel_available(k))
+                REQUIRE(run_index(s, k) == ref);
+    }
+    const std::string tricky = R"({"a\\":"b\"}","c\\\"":[1,{"d":"]"}]})";
+    REQUIRE(run_index(tricky, JsonIndexer::Kernel::Auto) == reference_index(tricky));
+}
+
+TEST_CASE("inventory cursor reads what the writers produce", "[json_index]")
+{
+    for (auto format : {InventoryFormat::Json, InventoryFormat::JsonStream, InventoryFormat::Ndjson})
+    {
+        std::ostringstream text;
+        auto w = make_inventory_writer(format, text);
+        w->begin("root \"x\"", "2025-01-01T00:00:00");
+        for (int i = 0; i < 3000; ++i)
+        {
+            FileEntry fe;
+            fe.path = "dir" + std::to_string(i % 7) + "/f\\" + std::to_string(i) + ".txt";
+            fe.size = std::uintmax_t(i);
+            fe.hash = std::string(64, "0123456789abcdef"[i % 16]);
+            fe.mtime = "2025-01-01T00:00:00";
+            w->entry(fe);
+        }
+        w->end(4498500);
+
+        const std::string json = text.str();
+        InventoryJsonCursor c(json);
+        REQUIRE(c.start());
+        InventoryEntryView e;
+        std::size_t n = 0;
+        std::uintmax_t total = 0;
+        while (c.next(e))
+        {
+            REQUIRE(e.path.find("/f\\") != std::string_view::npos);
+            REQUIRE(e.hash.size() == 64);
+            total += e.size;
+            ++n;
+        }
+        REQUIRE(c.finish());
+        REQUIRE(n == 3000);
+        REQUIRE(total == 4498500);
+        if (format == InventoryFormat::Ndjson)
+            continue;  // entries only
+        REQUIRE(c.root() == "root \"x\"");
+        REQUIRE(c.total_size() == 4498500);
+    }
+}
+
+TEST_CASE("inventory cursor reports malformed input with an offset", "[json_index]")
+{
+    const char *bad[] = {
+        R"({"files":[{"path":"a","size":1}]}x)",
+        R"({"files":[{"path":"a","size":-1}]})",
+        R"({"files":[{"path":"a" "size":1}]})",
+        R"({"files":[{"path":"a,"size":1}]})",
+        R"({"files":[{"path":"a","size":1},]})",
+        R"({"files":[{"path":"a","x":[1,}]})",
+        R"({"files":[)",
+        "",
+        "{\"path\":\"a\",\"size\":1}\n{\"path\":\"b\",\"size\":2}\nx\n",
+        "{\"path\":\"a\",\"size\":1}\n{\"path\":\"b\"",
+    };
+    for (const char *text : bad)
+    {
+        InventoryDoc doc;
+        std::string error;
+        REQUIRE(!parse_inventory_json(text, doc, &error));
+        REQUIRE(error.find(" at offset ") != std::string::npos);
+    }
+    InventoryDoc doc;
+    REQUIRE(parse_inventory_json(R"( {"root":"r","files":[]} )", doc));
+    REQUIRE(doc.root == "r");
+    REQUIRE(doc.files.empty());
+}
+
+TEST_CASE("inventory query filters and groups", "[json_index]")
+{
+    const std::string md = "# PROOF OF WORK\n\n````json\n{\"files\":[]}\n````\n## Inventory\n\n````json\n"
+                           R"({"files":[
+        {"hash":"ab12","mtime":"m","path":"src/a.cpp","size":10},
+        {"hash":"cd34","mtime":"m","path":"src/b.hpp","size":200},
+        {"hash":"ab99","mtime":"m","path":"docs/c.cpp","size":3000},
+        {"hash":"","mtime":"m","path":".gitignore","size":5}],"root":"r","total_size":3215})"
+                           "\n````\n";
+    const std::string_view json = find_inventory_json(md);
+    REQUIRE(json.substr(0, 10) == "{\"files\":[");
+
+    InventoryQueryOptions o;
+    o.paths = {"*.cpp"};
+    o.hashPrefix = "AB";
+    o.maxSize = 100;
+    std::ostringstream lines;
+    InventoryQuery q(o, lines);
+    REQUIRE(run_inventory_query(json, q));
+    q.finish();
+    REQUIRE(lines.str() == "{\"path\":\"src/a.cpp\",\"size\":10,\"hash\":\"ab12\",\"mtime\":\"m\"}\n");
+
+    InventoryQueryOptions g;
+    g.group = QueryGroup::Ext;
+    std::ostringstream groups;
+    InventoryQuery qg(g, groups);
+    REQUIRE(run_inventory_query(json, qg));
+    qg.finish();
+    REQUIRE(groups.str() == "{\"bytes\":3215,\"files\":4,\"groups\":[{\"bytes\":3010,\"files\":2,\"key\":\"cpp\"},"
+                            "{\"bytes\":200,\"files\":1,\"key\":\"hpp\"},{\"bytes\":5,\"files\":1,\"key\":\"\"}]}\n");
+
+    InventoryQueryOptions d;
+    d.group = QueryGroup::Dir;
+    d.minSize = 6;
+    std::ostringstream dirs;
+    InventoryQuery qd(d, dirs);
+    REQUIRE(run_inventory_query(json, qd));
+    qd.finish();
+    REQUIRE(dirs.str() == "{\"bytes\":3210,\"files\":3,\"groups\":[{\"bytes\":3000,\"files\":1,\"key\":\"docs\"},"
+                          "{\"bytes\":210,\"files\":2,\"key\":\"src\"}]}\n");
+}
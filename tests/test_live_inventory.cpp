@@ -0,0 +1,105 @@
+#include "../src/core/live_inventory.hpp"
+#include "../src/core/logger.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+namespace
+{
+    std::vector<std::string> paths(const LiveInventory &live)
+    {
+        std::vector<std::string> out;
+        for (auto &f : live.snapshot().files)
+            out.push_back(f.path);
+        return out;
+    }
+
+    // Applies whatever the last operations produced (they are all done by now).
+    std::size_t settle(LiveInventory &live)
+    {
+        return live.wait_and_apply(2000);
+    }
+}
+
+TEST_CASE("live inventory follows creates, edits, renames and deletes", "[watch]")
+{
+    fs::remove_all("tmp_watch");
+    fs::create_directories("tmp_watch/src");
+    std::ofstream("tmp_watch/src/a.txt") << "a\n";
+    std::ofstream("tmp_watch/.rogueignore") << "build/\n";
+
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_watch";
+    o.useCache = false;
+    LiveInventory live(o, logger, 50);
+    REQUIRE(live.start());
+    REQUIRE((paths(live) == std::vector<std::string>{".rogueignore", "src/a.txt"}));
+
+    // A burst of writes to the same file is one update.
+    for (int i = 0; i < 20; ++i)
+        std::ofstream("tmp_watch/src/a.txt", std::ios::app) << i;
+    std::ofstream("tmp_watch/b.txt") << "b\n";
+    REQUIRE(settle(live) == 2);
+    auto snap = live.snapshot();
+    REQUIRE(snap.files.size() == 3);
+    REQUIRE(snap.files[2].path == "src/a.txt");
+    REQUIRE(snap.files[2].size == 2 + 30);
+    REQUIRE(snap.totalSize == snap.files[0].size + snap.files[1].size + snap.files[2].size);
+
+    // New directory trees, including files written before the watch existed.
+    fs::create_directories("tmp_watch/src/deep/er");
+    std::ofstream("tmp_watch/src/deep/er/c.txt") << "c\n";
+    fs::create_directories("tmp_watch/build");
+    std::ofstream("tmp_watch/build/out.o") << "ignored\n";
+    settle(live);
+    REQUIRE((paths(live) == std::vector<std::string>{".rogueignore", "b.txt", "src/a.txt", "src/deep/er/c.txt"}));
+
+    fs::rename("tmp_watch/src/deep", "tmp_watch/moved");
+    fs::rename("tmp_watch/b.txt", "tmp_watch/b2.txt");
+    settle(live);
+    REQUIRE((paths(live) == std::vector<std::string>{".rogueignore", "b2.txt", "moved/er/c.txt", "src/a.txt"}));
+
+    // Events under the moved tree report its new name.
+    std::ofstream("tmp_watch/moved/er/d.txt") << "d\n";
+    fs::remove_all("tmp_watch/src");
+    settle(live);
+    REQUIRE((paths(live) == std::vector<std::string>{".rogueignore", "b2.txt", "moved/er/c.txt", "moved/er/d.txt"}));
+
+    // Changing the ignore rules triggers a full pass with the new rules.
+    std::ofstream("tmp_watch/.rogueignore") << "build/\nmoved/\n";
+    settle(live);
+    REQUIRE((paths(live) == std::vector<std::string>{".rogueignore", "b2.txt"}));
+
+    REQUIRE(live.wait_and_apply(50) == 0);
+    fs::remove_all("tmp_watch");
+}
+
+TEST_CASE("writes to excluded files are not reported as updates", "[watch]")
+{
+    fs::remove_all("tmp_watch_out");
+    fs::create_directories("tmp_watch_out/out");
+    std::ofstream("tmp_watch_out/a.txt") << "a\n";
+
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_watch_out";
+    o.useCache = false;
+    o.excludes = {"out/inv.json", "out/inv.json.tmp"};
+    LiveInventory live(o, logger, 50);
+    REQUIRE(live.start());
+    // What watch does after each update: write a temporary, rename it over.
+    for (int i = 0; i < 3; ++i)
+    {
+        std::ofstream("tmp_watch_out/out/inv.json.tmp") << i;
+        fs::rename("tmp_watch_out/out/inv.json.tmp", "tmp_watch_out/out/inv.json");
+        REQUIRE(live.wait_and_apply(200) == 0);
+    }
+    REQUIRE(live.file_count() == 1);
+    fs::remove_all("tmp_watch_out");
+}
+#endif
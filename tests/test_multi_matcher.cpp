@@ -0,0 +1,56 @@
+#include "../src/core/multi_matcher.hpp"
+#include "../src/core/utils.hpp"
+#include "../third_party/catch.hpp"
+#include <algorithm>
+#include <set>
+#include <utility>
+
+using namespace rogue;
+
+namespace
+{
+    std::set<std::pair<uint32_t, size_t>> naive(const std::vector<std::string> &pats, const std::string &text)
+    {
+        std::set<std::pair<uint32_t, size_t>> hits;
+        for (uint32_t id = 0; id < pats.size(); ++id)
+        {
+            for (size_t pos = 0; pos + pats[id].size() <= text.size(); ++pos)
+            {
+                bool eq = std::equal(pats[id].begin(), pats[id].end(), text.begin() + pos, [](char a, char b)
+                                     { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); });
+                if (eq)
+                    hits.insert({id, pos + pats[id].size()});
+            }
+        }
+        return hits;
+    }
+}
+
+TEST_CASE("multi-pattern matcher reports every overlapping occurrence", "[matcher]")
+{
+    std::vector<std::string> pats = {"he", "she", "his", "hers", "ToKen", "token_x", "s"};
+    std::vector<std::string> texts = {"ushers", "", "hishe rs TOKEN token_X tok", "sssss", "hehehe", "shetokentoken_xhers"};
+    MultiPatternMatcher m(pats);
+    for (auto &t : texts)
+    {
+        std::set<std::pair<uint32_t, size_t>> got;
+        m.scan(t.data(), t.size(), [&](uint32_t id, size_t end)
+               { got.insert({id, end}); });
+        REQUIRE(got == naive(pats, t));
+    }
+}
+
+TEST_CASE("multi-pattern matcher carries state across chunks", "[matcher]")
+{
+    MultiPatternMatcher m({"github_pat_"});
+    std::string text = "x github_pat_1 and GITHUB_PAT_2";
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        size_t count = 0;
+        auto st = m.scan(text.data(), split, [&](uint32_t, size_t)
+                         { ++count; });
+        m.scan(text.data() + split, text.size() - split, [&](uint32_t, size_t)
+               { ++count; }, st);
+        REQUIRE(count == 2);
+    }
+}
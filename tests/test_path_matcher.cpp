@@ -0,0 +1,76 @@
+#include "../src/core/path_matcher.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
+#include "../src/core/utils.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+TEST_CASE("compiled matcher agrees with is_ignored", "[matcher]")
+{
+    std::vector<std::string> pats = {"*.pem", "*.tar.gz", ".env", "id_*", "*token*", "docs/*.md", "a?c", "*"};
+    std::vector<std::string> paths = {"x/key.pem", "a.tar.gz", "sub/.env", "keys/id_rsa", "my_tokens.txt",
+                                      "docs/readme.md", "src/docs/x.md", "abc", "x/abd", "plain.txt", "tokenizer/a.py"};
+    for (size_t n = 1; n <= pats.size(); ++n)
+    {
+        std::vector<std::string> subset(pats.begin(), pats.begin() + n);
+        PathMatcher m(subset);
+        for (auto &p : paths)
+            REQUIRE(m.matches(p) == utils::is_ignored(p, subset));
+    }
+}
+
+TEST_CASE("directory patterns prune whole subtrees", "[matcher]")
+{
+    PathMatcher m({"build/", "node_modules", "out/*"});
+    REQUIRE(m.matches_dir("build"));
+    REQUIRE(m.matches_dir("pkg/node_modules"));
+    REQUIRE(m.matches_dir("out"));
+    REQUIRE(!m.matches("build")); // dir-only pattern does not hit a file named build
+    REQUIRE(!m.matches_dir("src"));
+
+    fs::remove_all("tmp_scan_prune");
+    fs::create_directories("tmp_scan_prune/build/deep");
+    fs::create_directories("tmp_scan_prune/src");
+    std::ofstream("tmp_scan_prune/build/deep/a.o") << "o";
+    std::ofstream("tmp_scan_prune/src/main.cpp") << "int main(){}";
+    std::ofstream("tmp_scan_prune/src/notes.txt") << "n";
+    std::ofstream("tmp_scan_prune/.rogueignore") << "build/\n";
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_prune";
+    o.excludes = {"*.txt"};
+    auto r = scan_workspace(o, logger);
+    REQUIRE(r.files.size() == 2); // .rogueignore + src/main.cpp
+    o.includes = {"*.cpp"};
+    r = scan_workspace(o, logger);
+    REQUIRE(r.files.size() == 1);
+    REQUIRE(r.files[0].path == "src/main.cpp");
+}
+
+TEST_CASE("directory patterns select the files beneath them", "[matcher]")
+{
+    PathMatcher m({"src/", "lib"});
+    REQUIRE(!m.matches("src/a.cpp"));
+    REQUIRE(m.matches_under("src/a.cpp"));
+    REQUIRE(m.matches_under("src/deep/b.hpp"));
+    REQUIRE(m.matches_under("pkg/lib/c.c"));
+    REQUIRE(!m.matches_under("src"));
+    REQUIRE(!m.matches_under("srcx/a.cpp"));
+    REQUIRE(!m.matches_under("docs/src.txt"));
+
+    fs::remove_all("tmp_scan_include");
+    fs::create_directories("tmp_scan_include/src/deep");
+    std::ofstream("tmp_scan_include/src/deep/a.cpp") << "a";
+    std::ofstream("tmp_scan_include/top.cpp") << "t";
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_include";
+    o.includes = {"src/"};
+    auto r = scan_workspace(o, logger);
+    REQUIRE(r.files.size() == 1);
+    REQUIRE(r.files[0].path == "src/deep/a.cpp");
+}
@@ -0,0 +1,58 @@
+#include "../src/core/process.hpp"
+#include "../third_party/catch.hpp"
+#include <chrono>
+#include <filesystem>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+TEST_CASE("run_process passes argv verbatim and captures both streams", "[process]")
+{
+    fs::path tmp = fs::temp_directory_path() / "rogue_process_test";
+    fs::remove_all(tmp);
+    fs::create_directories(tmp);
+
+    // Arguments with spaces and quotes reach the child untouched.
+    auto r = run_process({"sh", "-c", "printf '%s|' \"$@\"; echo oops >&2; exit 3", "sh", "a b", "it's", "\"q\""});
+    REQUIRE(r.started);
+    REQUIRE(r.exitCode == 3);
+    REQUIRE(!r.ok());
+    REQUIRE(r.out == "a b|it's|\"q\"|");
+    REQUIRE(r.err == "oops\n");
+
+    ProcessOptions inDir;
+    inDir.cwd = tmp.string();
+    auto pwd = run_process({"pwd"}, inDir);
+    REQUIRE(pwd.ok());
+    REQUIRE(fs::equivalent(fs::path(pwd.out.substr(0, pwd.out.size() - 1)), tmp));
+
+    // Larger than a pipe buffer on both streams at once.
+    auto big = run_process({"sh", "-c", "head -c 300000 /dev/zero; head -c 200000 /dev/zero >&2"});
+    REQUIRE(big.ok());
+    REQUIRE(big.out.size() == 300000);
+    REQUIRE(big.err.size() == 200000);
+
+    auto missing = run_process({"rogue-no-such-program-xyz"});
+    REQUIRE(!missing.ok());
+
+    fs::remove_all(tmp);
+}
+
+TEST_CASE("run_process kills the child when the timeout expires", "[process]")
+{
+    ProcessOptions opts;
+    opts.timeoutMs = 200;
+    const auto t0 = std::chrono::steady_clock::now();
+    auto r = run_process({"sleep", "5"}, opts);
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    REQUIRE(r.started);
+    REQUIRE(r.timedOut);
+    REQUIRE(!r.ok());
+    REQUIRE(ms < 3000);
+
+    auto quick = run_process({"true"}, opts);
+    REQUIRE(quick.ok());
+    REQUIRE(!quick.timedOut);
+}
+#endif
@@ -0,0 +1,104 @@
+#include "../src/core/logger.hpp"
+#include "../src/core/profiler.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include "../third_party/json.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+TEST_CASE("profiler counts scan phases and writes a loadable trace", "[profiler]")
+{
+    fs::remove_all("tmp_profile");
+    fs::create_directories("tmp_profile/src");
+    fs::create_directories("tmp_profile/build");
+    std::ofstream("tmp_profile/src/a.cpp") << "int a;";
+    std::ofstream("tmp_profile/src/b.cpp") << "int b;";
+    std::ofstream("tmp_profile/build/out.o") << "obj";
+    std::ofstream("tmp_profile/notes.log") << "log";
+    std::ofstream("tmp_profile/.env") << "SECRET=1";
+    std::ofstream("tmp_profile/.rogueignore") << "build/\n*.log\n";
+
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_profile";
+    o.useCache = false;
+
+    Profiler profiler(true);
+    profiler.start();
+    auto r = scan_workspace(o, logger);
+    profiler.stop();
+    REQUIRE(r.ok);
+    REQUIRE(r.files.size() == 3); // a.cpp, b.cpp, .rogueignore
+
+    REQUIRE(profiler.phase_calls(Phase::Scan) == 1);
+    REQUIRE(profiler.phase_calls(Phase::InventoryJson) == 1);
+    REQUIRE(profiler.phase_calls(Phase::ListDir) == profiler.counter(Counter::DirsVisited));
+    REQUIRE(profiler.counter(Counter::DirsVisited) == 2); // root and src
+    REQUIRE(profiler.counter(Counter::DirsPruned) == 1);
+    REQUIRE(profiler.counter(Counter::FilesVisited) == 5); // build/out.o is never listed
+    REQUIRE(profiler.counter(Counter::FilesIgnored) == 1);
+    REQUIRE(profiler.counter(Counter::FilesSkipped) == 1);
+    REQUIRE(profiler.counter(Counter::FilesHashed) == 3);
+    REQUIRE(profiler.counter(Counter::BytesRead) == r.totalSize);
+    REQUIRE(profiler.phase_ns(Phase::Scan) >= profiler.phase_ns(Phase::InventoryJson));
+
+    std::ostringstream summary;
+    profiler.write_summary(summary);
+    REQUIRE(summary.str().find("list_dir") != std::string::npos);
+    REQUIRE(summary.str().find("files_hashed=3") != std::string::npos);
+
+    std::ostringstream trace;
+    profiler.write_chrome_trace(trace);
+    bool ok = false;
+    auto doc = json::parse(trace.str(), &ok);
+    REQUIRE(ok);
+    const json *events = doc.find("traceEvents");
+    REQUIRE(events && events->size() > 5);
+    bool sawScan = false;
+    for (std::size_t i = 0; i < events->size(); ++i)
+    {
+        const json *name = events->at(i).find("name");
+        const json *args = events->at(i).find("args");
+        if (name && name->get_string() == "scan" && args)
+            sawScan = args->find("detail")->get_string() == "tmp_profile";
+    }
+    REQUIRE(sawScan);
+}
+
+TEST_CASE("probes record nothing without an active profiler", "[profiler]")
+{
+    Profiler profiler(true);
+    {
+        ProfileScope scope(Phase::Hash, "x");
+        REQUIRE(!scope.active());
+        profile_count(Counter::FilesHashed, 5);
+    }
+    REQUIRE(profiler.phase_calls(Phase::Hash) == 0);
+    REQUIRE(profiler.counter(Counter::FilesHashed) == 0);
+
+    profiler.start();
+    {
+        ProfileScope scope(Phase::Subprocess);
+        REQUIRE(scope.active());
+        scope.set_detail("git status");
+        profile_count(Counter::FilesHashed, 5);
+    }
+    profiler.stop();
+    profile_count(Counter::FilesHashed, 5);
+    REQUIRE(profiler.phase_calls(Phase::Subprocess) == 1);
+    REQUIRE(profiler.counter(Counter::FilesHashed) == 5);
+    REQUIRE(Profiler::active() == nullptr);
+
+    // A later profiler on the same thread starts from zero.
+    Profiler second(false);
+    second.start();
+    profile_count(Counter::CacheHits);
+    second.stop();
+    REQUIRE(second.counter(Counter::CacheHits) == 1);
+    REQUIRE(second.counter(Counter::FilesHashed) == 0);
+    REQUIRE(profiler.counter(Counter::CacheHits) == 0);
+}
@@ -0,0 +1,78 @@
+#include "../src/core/gitops.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/push_pipeline.hpp"
+#include "../third_party/catch.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::string run(const std::string &cmd)
+    {
+        std::string out;
+        FILE *p = popen(cmd.c_str(), "r");
+        if (!p)
+            return out;
+        char buf[512];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), p)) > 0)
+            out.append(buf, n);
+        pclose(p);
+        return out;
+    }
+
+    // Work tree in `dir` whose origin is a bare repository reached over file://.
+    void make_repos(const std::string &dir, const std::string &remoteUrl)
+    {
+        fs::remove_all(dir);
+        fs::remove_all(dir + ".git");
+        REQUIRE(run("git init -q --bare " + dir + ".git && git init -q " + dir + " && git -C " + dir + " remote add origin " + remoteUrl + " && echo ok") == "ok\n");
+    }
+}
+
+TEST_CASE("push pipeline pushes commits in order while new ones are made", "[pipeline]")
+{
+    make_repos("tmp_pipe", "file://" + fs::absolute("tmp_pipe.git").string());
+    Logger logger;
+    GitOps git(logger);
+    std::string last;
+    {
+        PushPipeline pipeline(git, "tmp_pipe", "main", 1);
+        for (int i = 0; i < 5; ++i)
+        {
+            std::ofstream("tmp_pipe/f" + std::to_string(i) + ".txt") << "chunk " << i << "\n";
+            REQUIRE(run("git -C tmp_pipe add -A && git -C tmp_pipe -c user.name=t -c user.email=t@t commit -q -m c" + std::to_string(i) + " && echo ok") == "ok\n");
+            last = git.head_commit("tmp_pipe");
+            REQUIRE(last.size() == 40);
+            REQUIRE(pipeline.submit(last));
+        }
+        REQUIRE(pipeline.finish());
+        REQUIRE(pipeline.pushed() == 5);
+    }
+    REQUIRE(run("git -C tmp_pipe.git rev-parse main") == last + "\n");
+    REQUIRE(run("git -C tmp_pipe.git rev-list --count main") == "5\n");
+    fs::remove_all("tmp_pipe");
+    fs::remove_all("tmp_pipe.git");
+}
+
+TEST_CASE("push pipeline stops at the first failed push", "[pipeline]")
+{
+    make_repos("tmp_pipe_fail", "file://" + fs::absolute("tmp_pipe_missing.git").string());
+    std::ofstream("tmp_pipe_fail/a.txt") << "a\n";
+    REQUIRE(run("git -C tmp_pipe_fail add -A && git -C tmp_pipe_fail -c user.name=t -c user.email=t@t commit -q -m a && echo ok") == "ok\n");
+    Logger logger;
+    GitOps git(logger);
+    PushPipeline pipeline(git, "tmp_pipe_fail", "main", 2);
+    const std::string head = git.head_commit("tmp_pipe_fail");
+    pipeline.submit(head);
+    REQUIRE(!pipeline.finish());
+    REQUIRE(pipeline.failed());
+    REQUIRE(pipeline.pushed() == 0);
+    REQUIRE(!pipeline.submit(head));
+    fs::remove_all("tmp_pipe_fail");
+    fs::remove_all("tmp_pipe_fail.git");
+}
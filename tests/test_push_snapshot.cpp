@@ -0,0 +1,87 @@
+#include "../src/core/push_snapshot.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    FileEntry file(const std::string &path, std::uint64_t size, char digit)
+    {
+        FileEntry f;
+        f.path = path;
+        f.size = size;
+        f.hash = std::string(64, digit);
+        return f;
+    }
+}
+
+TEST_CASE("push snapshot round-trips and is kept per branch", "[snapshot]")
+{
+    fs::remove_all("tmp_snapshot");
+    const std::string path = PushSnapshot::default_path("tmp_snapshot");
+    std::vector<FileEntry> files{file("a.txt", 3, 'a'), file("dir/b b.txt", 5, 'b'), file("z", 0, 'c')};
+    REQUIRE(PushSnapshot::save(path, "main", files));
+    REQUIRE(fs::exists("tmp_snapshot/.rogue/.gitignore"));
+
+    PushSnapshot snap;
+    REQUIRE(snap.load(path, "main"));
+    REQUIRE(snap.entries().size() == 3);
+    REQUIRE(snap.entries()[1].path == "dir/b b.txt");
+    REQUIRE(snap.entries()[1].size == 5);
+    REQUIRE(Sha256::to_hex(snap.entries()[1].sha256) == std::string(64, 'b'));
+    REQUIRE(diff_inventory(snap.entries(), files).empty());
+
+    REQUIRE(!snap.load(path, "release"));
+    REQUIRE(snap.entries().empty());
+    REQUIRE(!snap.load("tmp_snapshot/missing", "main"));
+    fs::remove_all("tmp_snapshot");
+}
+
+TEST_CASE("a corrupt push snapshot is rejected, not loaded", "[snapshot]")
+{
+    fs::create_directories("tmp_snapshot_bad");
+    const std::string path = "tmp_snapshot_bad/pushed";
+    const std::uint32_t version = 1;
+    const std::uint16_t branchLen = 4;
+    for (std::uint64_t count : {std::uint64_t(1) << 62, std::uint64_t(3)})
+    {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write("RPS1", 4);
+            out.write(reinterpret_cast<const char *>(&version), sizeof version);
+            out.write(reinterpret_cast<const char *>(&branchLen), sizeof branchLen);
+            out << "main";
+            out.write(reinterpret_cast<const char *>(&count), sizeof count);
+            out << std::string(50, 'x');  // not even two entries
+        }
+        PushSnapshot snap;
+        REQUIRE(!snap.load(path, "main"));
+        REQUIRE(snap.entries().empty());
+    }
+    fs::remove_all("tmp_snapshot_bad");
+}
+
+TEST_CASE("inventory diff reports added, modified and deleted paths", "[snapshot]")
+{
+    fs::remove_all("tmp_snapshot_diff");
+    const std::string path = PushSnapshot::default_path("tmp_snapshot_diff");
+    REQUIRE(PushSnapshot::save(path, "main", {file("gone", 1, '1'), file("keep", 2, '2'), file("size", 3, '3'), file("text", 4, '4')}));
+    PushSnapshot snap;
+    REQUIRE(snap.load(path, "main"));
+
+    std::vector<FileEntry> now{file("keep", 2, '2'), file("new\"q", 9, '9'), file("size", 30, '3'), file("text", 4, 'f')};
+    auto d = diff_inventory(snap.entries(), now);
+    REQUIRE(d.added == std::vector<std::size_t>{1});
+    REQUIRE((d.modified == std::vector<std::size_t>{2, 3}));
+    REQUIRE(d.deleted == std::vector<std::string>{"gone"});
+    REQUIRE(inventory_diff_json(d, now) == "{\"added\":[\"new\\\"q\"],\"modified\":[\"size\",\"text\"],\"deleted\":[\"gone\"]}");
+
+    // No snapshot: everything is new.
+    auto all = diff_inventory({}, now);
+    REQUIRE(all.added.size() == 4);
+    REQUIRE(all.modified.empty());
+    fs::remove_all("tmp_snapshot_diff");
+}
@@ -0,0 +1,98 @@
+#include "../src/core/inventory_reader.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/rinv.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+TEST_CASE("rinv written from a scan reads back in place and converts to the same json", "[rinv]")
+{
+    fs::remove_all("tmp_rinv");
+    fs::create_directories("tmp_rinv/src/deep/er");
+    fs::create_directories("tmp_rinv/docs");
+    std::ofstream("tmp_rinv/src/main.cpp") << "int main() {}";
+    std::ofstream("tmp_rinv/src/deep/er/main.cpp") << "x";
+    std::ofstream("tmp_rinv/docs/README") << "readme";
+    std::ofstream("tmp_rinv/top.txt") << "top";
+
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_rinv";
+    o.useCache = false;
+    auto r = scan_workspace(o, logger);
+    REQUIRE(r.ok);
+    REQUIRE(write_rinv("tmp_rinv.rinv", o.root, r.generatedAt, r.files, r.totalSize));
+    REQUIRE(is_rinv_file("tmp_rinv.rinv"));
+
+    RinvView view;
+    REQUIRE(view.open("tmp_rinv.rinv"));
+    REQUIRE(view.size() == 4);
+    REQUIRE(view.root() == "tmp_rinv");
+    REQUIRE(view.total_size() == r.totalSize);
+    for (std::size_t i = 0; i < view.size(); ++i)
+    {
+        REQUIRE(view.path(i) == r.files[i].path);
+        REQUIRE(view.hash_hex(i) == r.files[i].hash);
+        REQUIRE(view.record(i).size == r.files[i].size);
+    }
+    REQUIRE(view.find("src/deep/er/main.cpp").value() == 1);
+    REQUIRE(view.name(1) == "main.cpp");
+    REQUIRE(view.record(1).nameOff == view.record(2).nameOff); // interned basename
+    REQUIRE(!view.find("src/missing"));
+
+    std::ostringstream json;
+    write_rinv_as_json(view, json);
+    REQUIRE(json.str() == r.inventoryJson);
+}
+
+TEST_CASE("inventory json reader handles escapes and unknown keys", "[rinv]")
+{
+    const std::string text = R"({"extra":{"a":[1,2.5e3,true,null]},"files":[
+        {"hash":"","mtime":"2025-01-02T03:04:05","path":"a \"q\"\\b\u00e9\ud83d\ude00","size":12,"future":"x"},
+        {"path":"b","size":18446744073709551615,"duplicate_bytes":3}],
+        "generated_at":"t","root":"r","total_size":30})";
+    InventoryDoc doc;
+    std::string error;
+    REQUIRE(parse_inventory_json(text, doc, &error));
+    REQUIRE(doc.root == "r");
+    REQUIRE(doc.generatedAt == "t");
+    REQUIRE(doc.totalSize == 30);
+    REQUIRE(doc.files.size() == 2);
+    REQUIRE(doc.files[0].path == "a \"q\"\\b\xC3\xA9\xF0\x9F\x98\x80");
+    REQUIRE(doc.files[0].mtime == "2025-01-02T03:04:05");
+    REQUIRE(doc.files[1].size == 18446744073709551615ull);
+    REQUIRE(doc.files[1].hasDedup);
+
+    REQUIRE(!parse_inventory_json(R"({"files":[{"path":"a",}]})", doc, &error));
+    REQUIRE(error.find("offset") != std::string::npos);
+    REQUIRE(!parse_inventory_json(R"({"total_size":-1})", doc));
+}
+
+TEST_CASE("rinv keeps mtimes from json and rejects corrupt files", "[rinv]")
+{
+    InventoryDoc doc;
+    REQUIRE(parse_inventory_json(R"({"files":[{"hash":"","mtime":"2024-06-30T12:00:00","path":"z/y","size":1}],
+        "generated_at":"g","root":"/r","total_size":1})", doc));
+    REQUIRE(write_rinv("tmp_rinv_json.rinv", doc.root, doc.generatedAt, doc.files, doc.totalSize));
+    RinvView view;
+    REQUIRE(view.open("tmp_rinv_json.rinv"));
+    REQUIRE(view.mtime_iso(0) == "2024-06-30T12:00:00");
+    REQUIRE(view.hash_hex(0).empty());
+    REQUIRE(view.path(0) == "z/y");
+
+    // Cut inside the record array.
+    {
+        std::ifstream in("tmp_rinv_json.rinv", std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream("tmp_rinv_cut.rinv", std::ios::binary) << bytes.substr(0, 100);
+    }
+    std::string error;
+    REQUIRE(!view.open("tmp_rinv_cut.rinv", &error));
+    REQUIRE(error.find("corrupt") != std::string::npos);
+    REQUIRE(!view.open("tmp_rinv_missing.rinv"));
+}
@@ -1,8 +1,10 @@
 #include "../src/core/scanner.hpp"
 #include "../src/core/logger.hpp"
+#include "../src/core/scan_cache.hpp"
 #include "../src/core/utils.hpp"
 #include "../third_party/catch.hpp"
 #include <filesystem>
+#include <chrono>
 #include <fstream>
 
 using namespace rogue;
@@ -22,3 +24,123 @@ TEST_CASE("scanner respects ignore and size", "[scan]")
     REQUIRE(r.ok);
     REQUIRE(r.inventoryJson.find("file.txt") != std::string::npos);
 }
+
+TEST_CASE("scanner output order is deterministic across thread counts", "[scan]")
+{
+    fs::create_directories("tmp_scan_mt/b/c");
+    fs::create_directories("tmp_scan_mt/a");
+    for (int i = 0; i < 20; ++i)
+    {
+        std::ofstream("tmp_scan_mt/b/c/f" + std::to_string(i) + ".txt") << i;
+        std::ofstream("tmp_scan_mt/a/g" + std::to_string(i) + ".txt") << i;
+    }
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_mt";
+    o.threads = 1;
+    auto one = scan_workspace(o, logger);
+    o.threads = 8;
+    auto many = scan_workspace(o, logger);
+    REQUIRE(one.ok && many.ok);
+    REQUIRE(one.files.size() == 40);
+    REQUIRE(many.files.size() == one.files.size());
+    for (size_t i = 0; i < one.files.size(); ++i)
+    {
+        REQUIRE(one.files[i].path == many.files[i].path);
+        REQUIRE(one.files[i].hash == many.files[i].hash);
+    }
+    REQUIRE(one.files.front().path == "a/g0.txt");
+    REQUIRE(one.totalSize == many.totalSize);
+}
+
+TEST_CASE("scan cache reuses hashes of unchanged files", "[scan]")
+{
+    fs::remove_all("tmp_scan_cache");
+    fs::create_directories("tmp_scan_cache/d");
+    std::ofstream("tmp_scan_cache/d/one.txt") << "one";
+    std::ofstream("tmp_scan_cache/two.txt") << "two";
+    auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    fs::last_write_time("tmp_scan_cache/d/one.txt", old);
+    fs::last_write_time("tmp_scan_cache/two.txt", old);
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_cache";
+    auto first = scan_workspace(o, logger);
+    REQUIRE(first.cacheMisses == 2);
+    REQUIRE(fs::exists("tmp_scan_cache/.rogue/scancache"));
+    auto second = scan_workspace(o, logger);
+    REQUIRE(second.cacheHits == 2);
+    REQUIRE(second.cacheMisses == 0);
+    REQUIRE(second.files.size() == 2); // .rogue/ itself is never inventoried
+    REQUIRE(second.files[0].hash == first.files[0].hash);
+
+    std::ofstream("tmp_scan_cache/two.txt") << "changed";
+    auto third = scan_workspace(o, logger);
+    REQUIRE(third.cacheHits == 1);
+    REQUIRE(third.cacheMisses == 1);
+    REQUIRE(third.files[1].hash != first.files[1].hash);
+}
+
+TEST_CASE("walker follows file symlinks only and inode order keeps the result", "[scan]")
+{
+    fs::remove_all("tmp_scan_walk");
+    fs::create_directories("tmp_scan_walk/real/deep");
+    std::ofstream("tmp_scan_walk/real/deep/a.txt") << "a";
+    std::ofstream("tmp_scan_walk/real/b.txt") << "bb";
+    std::error_code ec;
+    fs::create_symlink("real/b.txt", "tmp_scan_walk/link.txt", ec);
+    const bool haveLinks = !ec;
+    fs::create_directory_symlink("real", "tmp_scan_walk/dirlink", ec);
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_walk";
+    o.useCache = false;
+    auto r = scan_workspace(o, logger);
+    o.inodeOrder = true;
+    auto byInode = scan_workspace(o, logger);
+    REQUIRE(r.ok && byInode.ok);
+    REQUIRE(r.files.size() == (haveLinks ? 3u : 2u));
+    REQUIRE(byInode.files.size() == r.files.size());
+    for (size_t i = 0; i < r.files.size(); ++i)
+    {
+        REQUIRE(r.files[i].path == byInode.files[i].path);
+        REQUIRE(r.files[i].mtime == utils::file_mtime_iso("tmp_scan_walk/" + r.files[i].path));
+    }
+    REQUIRE(r.files.back().path == "real/deep/a.txt");
+}
+
+TEST_CASE("the log file is left out when it is inside the scanned tree", "[scan]")
+{
+    ScanOptions o;
+    o.root = ".";
+    o.excludes = {"*.tmp"};
+    auto patterns = ignore_patterns(o);
+    REQUIRE(patterns.size() >= 2);
+    REQUIRE(patterns[patterns.size() - 2] == "*.tmp");
+    REQUIRE(patterns.back() == "logs/rogue.log");
+    o.root = "tmp_scan";
+    REQUIRE(ignore_patterns(o).back() == "*.tmp");
+    REQUIRE(utils::path_under("tmp_scan", "tmp_scan/./x/../y.json") == "y.json");
+    REQUIRE(utils::path_under("tmp_scan", "tmp_scan") == "");
+    REQUIRE(utils::path_under("tmp_scan", "other/y.json") == "");
+}
+
+TEST_CASE("scan cache with a count its file cannot hold loads as empty", "[scan]")
+{
+    fs::create_directories("tmp_scan_cache_bad");
+    const std::uint32_t version = 3;
+    for (std::uint64_t count : {std::uint64_t(1) << 62, std::uint64_t(2)})
+    {
+        {
+            std::ofstream out("tmp_scan_cache_bad/scancache", std::ios::binary | std::ios::trunc);
+            out.write("RSC1", 4);
+            out.write(reinterpret_cast<const char *>(&version), sizeof version);
+            out.write(reinterpret_cast<const char *>(&count), sizeof count);
+            out << std::string(100, 'x');  // one record at most, and truncated
+        }
+        ScanCache cache;
+        REQUIRE(!cache.load("tmp_scan_cache_bad/scancache"));
+        REQUIRE(cache.size() == 0);
+    }
+    fs::remove_all("tmp_scan_cache_bad");
+}
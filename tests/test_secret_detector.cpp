@@ -0,0 +1,87 @@
+#include "../src/core/secret_detector.hpp"
+#include "../src/core/logger.hpp"
+#include "../src/core/scanner.hpp"
+#include "../third_party/catch.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace rogue;
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Split so the fixtures do not trip secret scanners on this file.
+    const std::string kToken = std::string("gh") + "p_" + "Zq3xV9kLm2Pw8RtY4nBc";
+    const std::string kPem = std::string("-----BEGIN ") + "OPENSSH PRIVATE KEY-----\nb3BlbnNzaA==\n";
+
+    const char *detect(const SecretDetector &d, const std::string &text, size_t chunk)
+    {
+        SecretDetector::Stream s(d);
+        for (size_t at = 0; at < text.size(); at += chunk)
+            s.feed(reinterpret_cast<const unsigned char *>(text.data()) + at, std::min(chunk, text.size() - at));
+        s.finish();
+        return s.reason();
+    }
+}
+
+TEST_CASE("secret detector flags tokens, keys and random strings in any chunking", "[secrets]")
+{
+    SecretDetector d;
+    std::vector<std::string> bad = {"{\"token\": \"" + kToken + "\"}", kPem,
+                                    "aws_secret = " + std::string("wJalrXUtnFEMI/K7MDENG/") + "bPxRfiCYEXAMPLEKEY\n",
+                                    "slack " + std::string("xo") + "xb-" + "1234567890123456789"};
+    std::vector<std::string> good = {"plain prose about ghp_ prefixes and secrets\n",
+                                     "commit 3f786850e387550fdab836ed7e6dc881de23001b\n",
+                                     "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\n", "ghp_short\n",
+                                     std::string("\0binary", 7) + kToken};
+    // More prefix mentions in one block than any fixed bound, then the token.
+    std::string mentions;
+    for (int i = 0; i < 40; ++i)
+        mentions += std::string("gh") + "p_ ";
+    bad.push_back(mentions + std::string("gh") + "p_" + std::string(20, 'a'));
+    for (size_t chunk : {size_t(1), size_t(3), size_t(7), size_t(4096)})
+    {
+        for (auto &t : bad)
+            REQUIRE(detect(d, t, chunk) != nullptr);
+        for (auto &t : good)
+            REQUIRE(detect(d, t, chunk) == nullptr);
+    }
+}
+
+TEST_CASE("scan with secret detection skips flagged files and caches the verdict", "[secrets]")
+{
+    fs::remove_all("tmp_scan_secrets");
+    fs::create_directories("tmp_scan_secrets/conf");
+    std::ofstream("tmp_scan_secrets/conf/config.json") << "{\"auth\": \"" << kToken << "\"}\n";
+    std::ofstream("tmp_scan_secrets/conf/deploy") << kPem;
+    std::ofstream("tmp_scan_secrets/readme.txt") << "nothing to see here\n";
+    // Old enough to be cached
+    for (auto &e : fs::recursive_directory_iterator("tmp_scan_secrets"))
+        if (e.is_regular_file())
+            fs::last_write_time(e.path(), fs::file_time_type::clock::now() - std::chrono::hours(1));
+    Logger logger;
+    ScanOptions o;
+    o.root = "tmp_scan_secrets";
+    o.threads = 2;
+    auto plain = scan_workspace(o, logger);
+    REQUIRE(plain.files.size() == 3);
+
+    o.detectSecrets = true;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        auto r = scan_workspace(o, logger);
+        REQUIRE(r.ok);
+        REQUIRE(r.files.size() == 1);
+        REQUIRE(r.files[0].path == "readme.txt");
+        REQUIRE(r.secretFiles.size() == 2);
+        REQUIRE(r.secretFiles[0] == "conf/config.json");
+        // Digests cached by the plain scan do not cover content checks.
+        REQUIRE(pass == 0 ? r.cacheMisses == 3 : r.cacheHits == 3);
+    }
+
+    o.includeSecrets = true;
+    auto kept = scan_workspace(o, logger);
+    REQUIRE(kept.files.size() == 3);
+    REQUIRE(kept.secretFiles.size() == 2);
+}
@@ -0,0 +1,41 @@
+#include "../src/core/sha256.hpp"
+#include "../src/core/utils.hpp"
+#include "../third_party/catch.hpp"
+#include <fstream>
+#include <string>
+
+using namespace rogue;
+
+static std::string sha_hex(const std::string &s, Sha256::Kernel k = Sha256::Kernel::Auto)
+{
+    Sha256 h(k);
+    h.update(s.data(), s.size());
+    return Sha256::to_hex(h.finish());
+}
+
+TEST_CASE("sha256 matches FIPS 180-4 vectors", "[sha256]")
+{
+    REQUIRE(sha_hex("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    REQUIRE(sha_hex("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    REQUIRE(sha_hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+            "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    REQUIRE(sha_hex(std::string(1000000, 'a')) ==
+            "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_CASE("sha256 kernels agree on split updates", "[sha256]")
+{
+    std::string data;
+    for (int i = 0; i < 5000; ++i)
+        data.push_back(char((i * 131) ^ (i >> 3)));
+    auto ref = sha_hex(data, Sha256::Kernel::Portable);
+    if (Sha256::kernel_available(Sha256::Kernel::ShaNi))
+        REQUIRE(sha_hex(data, Sha256::Kernel::ShaNi) == ref);
+    Sha256 h;
+    for (size_t off = 0; off < data.size(); off += 77)
+        h.update(data.data() + off, std::min<size_t>(77, data.size() - off));
+    REQUIRE(Sha256::to_hex(h.finish()) == ref);
+
+    std::ofstream("tmp_sha.bin", std::ios::binary) << data;
+    REQUIRE(utils::sha256_file("tmp_sha.bin") == ref);
+}
@@ -1,23 +1,124 @@
-// Minimal JSON shim compatible with a tiny subset of nlohmann::json API used in this project.
+// Minimal JSON DOM compatible with a tiny subset of the nlohmann::json API used in this project.
 // This is NOT a full JSON library. Only features used here are implemented:
 // - object and array construction
-// - operator[](string) for objects
-// - push_back for arrays
-// - assignment from string, const char*, integer (uint64_t/int), and bool
-// - dump(int indent = -1) serialization (basic, escapes quotes and backslashes)
+// - operator[](string) for objects, push_back for arrays (copy or move)
+// - assignment from string, const char*, integers, floating point, bool and nullptr
+// - value(key, default) for bool, integers, floating point and std::string
+// - dump(int indent = -1) serialization
+// - parse(text) and read access (find, at, get) for small documents
 // For production, replace with the real nlohmann/json single-header (MIT).
+//
+// Layout: every node of a document lives in one arena owned by the root
+// value, so building a document costs a few block allocations instead of one
+// per node. Objects are flat arrays of members in insertion order (linear
+// lookup: objects here have a handful of keys). Integers are stored as
+// 64-bit signed or unsigned values, so sizes above 2^53 stay exact.
+// Moving a root into a document (push_back(std::move(v)), j["k"] = std::move(v))
+// adopts its arena instead of copying the subtree.
+//
+// As with std::vector, a reference returned by operator[] is invalidated when
+// the same object or array grows.
 
 #pragma once
+#include <charconv>
+#include <cstddef>
 #include <cstdint>
-#include <map>
-#include <sstream>
+#include <cstring>
+#include <new>
 #include <string>
-#include <variant>
-#include <vector>
+#include <string_view>
+#include <type_traits>
 
 namespace nlohmann
 {
 
+// Bump allocator for the nodes, member arrays and strings of one document.
+// Memory is only released when the arena goes away.
+class json_arena
+{
+  public:
+    json_arena() = default;
+    json_arena(const json_arena&) = delete;
+    json_arena& operator=(const json_arena&) = delete;
+    ~json_arena()
+    {
+        while (head_)
+        {
+            Block* next = head_->next;
+            ::operator delete(head_);
+            head_ = next;
+        }
+        while (adopted_)
+        {
+            json_arena* next = adopted_->nextAdopted_;
+            adopted_->nextAdopted_ = nullptr;
+            delete adopted_;
+            adopted_ = next;
+        }
+    }
+
+    void* allocate(std::size_t n, std::size_t align = alignof(std::max_align_t))
+    {
+        std::size_t at = (used_ + align - 1) & ~(align - 1);
+        if (!head_ || at + n > head_->size)
+        {
+            grow(n + align);
+            at = (used_ + align - 1) & ~(align - 1);
+        }
+        used_ = at + n;
+        return head_->data() + at;
+    }
+
+    const char* copy_string(std::string_view s)
+    {
+        if (s.empty())
+            return "";
+        char* p = static_cast<char*>(allocate(s.size(), 1));
+        std::memcpy(p, s.data(), s.size());
+        return p;
+    }
+
+    // Keeps `other` (and everything allocated from it) alive as long as this
+    // arena; nodes that point into it stay valid.
+    void adopt(json_arena* other)
+    {
+        json_arena* last = other;
+        while (last->nextAdopted_)
+            last = last->nextAdopted_;
+        last->nextAdopted_ = adopted_;
+        adopted_ = other;
+    }
+
+  private:
+    struct Block
+    {
+        Block* next;
+        std::size_t size;
+        char* data() { return reinterpret_cast<char*>(this) + sizeof(Block); }
+    };
+    static_assert(sizeof(Block) % alignof(std::max_align_t) == 0, "block header keeps data aligned");
+
+    void grow(std::size_t atLeast)
+    {
+        // Blocks double up to 64 KiB; bigger requests get a block of their own.
+        std::size_t size = head_ ? head_->size * 2 : 512;
+        if (size > 64 * 1024)
+            size = 64 * 1024;
+        if (size < atLeast)
+            size = atLeast;
+        Block* b = static_cast<Block*>(::operator new(sizeof(Block) + size));
+        b->next = head_;
+        b->size = size;
+        head_ = b;
+        used_ = 0;
+    }
+
+    Block* head_{nullptr};
+    std::size_t used_{0};
+    json_arena* adopted_{nullptr};
+    json_arena* nextAdopted_{nullptr};
+};
+
 class json
 {
   public:
@@ -30,235 +131,693 @@ class json
         object,
         array
     };
-    using object_t = std::map<std::string, json>;
-    using array_t = std::vector<json>;
 
-    json() : data_(object_t{}) {}  // default to object
+    json() = default;  // an empty object
+    json(const json& other) { copy_from(other, nullptr); }
+    json(json&& other) { take(other); }
+    ~json() { delete own_; }
+
+    json& operator=(const json& other)
+    {
+        if (this != &other)
+        {
+            json tmp;
+            tmp.arena_ = arena();
+            tmp.copy_from(other, arena_);
+            assign_fields(tmp);
+        }
+        return *this;
+    }
+    json& operator=(json&& other)
+    {
+        if (this != &other)
+            take(other);
+        return *this;
+    }
+
     static json array()
     {
         json j;
-        j.data_ = array_t{};
+        j.tag_ = Tag::Array;
         return j;
     }
+    static json object() { return json(); }
 
-    // element access for objects
-    json& operator[](const std::string& key)
+    kind type() const
     {
-        ensure_object();
-        return std::get<object_t>(data_)[key];
+        switch (tag_)
+        {
+            case Tag::Null: return kind::null_t;
+            case Tag::Bool: return kind::boolean;
+            case Tag::String: return kind::string;
+            case Tag::Object: return kind::object;
+            case Tag::Array: return kind::array;
+            default: return kind::number;
+        }
     }
+    bool is_null() const { return tag_ == Tag::Null; }
+    bool is_object() const { return tag_ == Tag::Object; }
+    bool is_array() const { return tag_ == Tag::Array; }
+    bool is_string() const { return tag_ == Tag::String; }
+    bool is_number() const { return tag_ == Tag::Int || tag_ == Tag::Uint || tag_ == Tag::Double; }
+    // Members of an object or elements of an array; 0 otherwise.
+    std::size_t size() const { return is_object() || is_array() ? n_ : 0; }
+
+    // element access for objects (a missing key is added as an empty object)
+    json& operator[](std::string_view key);
+    json& operator[](const std::string& key) { return (*this)[std::string_view(key)]; }
+    json& operator[](const char* key) { return (*this)[std::string_view(key)]; }
+
+    // Pointer to the member's value, or null.
+    const json* find(std::string_view key) const;
+    // Element i of an array (i < size()).
+    const json& at(std::size_t i) const { return a_[i]; }
+    // Key and value of member i of an object (i < size()).
+    std::string_view key_at(std::size_t i) const;
+    const json& value_at(std::size_t i) const;
+    std::string_view get_string() const { return tag_ == Tag::String ? std::string_view(s_, n_) : std::string_view(); }
+
+    // Whole-document parse. On malformed input returns null and, if given,
+    // sets *ok to false.
+    static json parse(std::string_view text, bool* ok = nullptr);
 
     // push for arrays
     void push_back(const json& v)
     {
         ensure_array();
-        std::get<array_t>(data_).push_back(v);
+        reserve_slots(n_ + 1);
+        json* slot = new (&a_[n_]) json;
+        slot->arena_ = arena_;
+        slot->copy_from(v, arena_);
+        ++n_;
+    }
+    void push_back(json&& v)
+    {
+        ensure_array();
+        reserve_slots(n_ + 1);
+        json* slot = new (&a_[n_]) json;
+        slot->arena_ = arena_;
+        slot->take(v);
+        ++n_;
     }
 
     // assignments
-    json& operator=(const std::string& s)
+    json& operator=(std::string_view s)
     {
-        data_ = s;
+        const char* p = arena()->copy_string(s);
+        reset(Tag::String);
+        s_ = p;
+        n_ = s.size();
         return *this;
     }
-    json& operator=(const char* s)
+    json& operator=(const std::string& s) { return *this = std::string_view(s); }
+    json& operator=(const char* s) { return *this = std::string_view(s); }
+    json& operator=(bool b)
     {
-        data_ = std::string(s);
+        reset(Tag::Bool);
+        b_ = b;
         return *this;
     }
-    json& operator=(uint64_t n)
+    json& operator=(std::nullptr_t)
     {
-        data_ = static_cast<double>(n);
+        reset(Tag::Null);
         return *this;
     }
-    json& operator=(int n)
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    json& operator=(T n)
     {
-        data_ = static_cast<double>(n);
+        if (std::is_signed<T>::value && n < 0)
+        {
+            reset(Tag::Int);
+            i_ = static_cast<std::int64_t>(n);
+        }
+        else
+        {
+            reset(Tag::Uint);
+            u_ = static_cast<std::uint64_t>(n);
+        }
         return *this;
     }
-    json& operator=(bool b)
+    template <typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+    json& operator=(T d)
     {
-        data_ = b;
+        reset(Tag::Double);
+        d_ = static_cast<double>(d);
         return *this;
     }
 
-    // helpers for value() used in our code (not generic template)
+    // helpers for value() used in our code
     template <typename T>
-    T value(const std::string& key, const T& def) const
+    T value(std::string_view key, const T& def) const
     {
-        if (!is_object())
+        const json* v = find(key);
+        return v ? v->get<T>(def) : def;
+    }
+    std::string value(std::string_view key, const char* def) const { return value<std::string>(key, def); }
+
+    template <typename T>
+    T get(const T& def) const
+    {
+        if constexpr (std::is_same<T, bool>::value)
+            return tag_ == Tag::Bool ? b_ : def;
+        else if constexpr (std::is_integral<T>::value)
+        {
+            if (tag_ == Tag::Uint)
+                return static_cast<T>(u_);
+            if (tag_ == Tag::Int)
+                return static_cast<T>(i_);
+            if (tag_ == Tag::Double)
+                return static_cast<T>(d_);
             return def;
-        const auto& obj = std::get<object_t>(data_);
-        auto it = obj.find(key);
-        if (it == obj.end())
+        }
+        else if constexpr (std::is_floating_point<T>::value)
+        {
+            if (tag_ == Tag::Uint)
+                return static_cast<T>(u_);
+            if (tag_ == Tag::Int)
+                return static_cast<T>(i_);
+            if (tag_ == Tag::Double)
+                return static_cast<T>(d_);
             return def;
-        return it->second.get<T>(def);
+        }
+        else
+            return tag_ == Tag::String ? T(std::string(s_, n_)) : def;
     }
 
     // dump
     std::string dump(int indent = -1) const
     {
-        std::ostringstream os;
-        serialize(os, *this, indent, 0);
-        return os.str();
+        std::string out;
+        out.reserve(estimate(indent, 0));
+        dump_to(out, indent);
+        return out;
     }
+    // Appends the serialization to out (a reusable buffer).
+    void dump_to(std::string& out, int indent = -1) const { serialize(out, indent, 0); }
 
   private:
-    std::variant<std::nullptr_t, bool, double, std::string, object_t, array_t> data_{};
+    enum class Tag : std::uint8_t
+    {
+        Null,
+        Bool,
+        Int,
+        Uint,
+        Double,
+        String,
+        Object,
+        Array
+    };
+    struct member;
+    class parser;
 
-    bool is_object() const { return std::holds_alternative<object_t>(data_); }
-    bool is_array() const { return std::holds_alternative<array_t>(data_); }
+    Tag tag_{Tag::Object};
+    std::size_t n_{0};    // string length, member or element count
+    std::size_t cap_{0};  // member or element slots
+    union
+    {
+        std::uint64_t u_ = 0;
+        bool b_;
+        std::int64_t i_;
+        double d_;
+        const char* s_;
+        member* o_;
+        json* a_;
+    };
+    json_arena* arena_{nullptr};  // where this node's strings and children live
+    json_arena* own_{nullptr};    // set on roots: the arena is theirs
+
+    json_arena* arena()
+    {
+        if (!arena_)
+            arena_ = own_ = new json_arena;
+        return arena_;
+    }
+
+    // Old content stays in the arena until the document goes away.
+    void reset(Tag t)
+    {
+        tag_ = t;
+        n_ = cap_ = 0;
+        u_ = 0;
+    }
     void ensure_object()
     {
         if (!is_object())
-            data_ = object_t{};
+            reset(Tag::Object);
+        arena();
     }
     void ensure_array()
     {
         if (!is_array())
-            data_ = array_t{};
+            reset(Tag::Array);
+        arena();
     }
 
-    template <typename T>
-    T get(const T& def) const
-    {
-        return def;
-    }
+    // Grows the member or element array; nodes are relocated bitwise (they
+    // hold no resources of their own below the root).
+    void reserve_slots(std::size_t want);
 
-    bool get_bool(const bool& def) const
+    // Value fields only; arena_/own_ stay.
+    void assign_fields(const json& src)
     {
-        if (std::holds_alternative<bool>(data_))
-            return std::get<bool>(data_);
-        return def;
+        tag_ = src.tag_;
+        n_ = src.n_;
+        cap_ = src.cap_;
+        u_ = src.u_;
     }
 
-    uint64_t get_uint64(const uint64_t& def) const
-    {
-        if (std::holds_alternative<double>(data_))
-            return static_cast<uint64_t>(std::get<double>(data_));
-        return def;
-    }
+    // Deep copy of src into `into` (or a new arena of our own if null and needed).
+    void copy_from(const json& src, json_arena* into);
 
-    std::string get_string(const std::string& def) const
+    // Move: adopt a root's arena, share the same arena, or copy.
+    void take(json& src)
     {
-        if (std::holds_alternative<std::string>(data_))
-            return std::get<std::string>(data_);
-        return def;
+        if (src.own_)
+        {
+            if (!arena_)
+                arena_ = own_ = src.own_;
+            else if (arena_ != src.own_)
+                arena_->adopt(src.own_);
+            src.own_ = nullptr;
+        }
+        else if (src.arena_ && src.arena_ != arena_)
+        {
+            json tmp;
+            tmp.arena_ = arena();
+            tmp.copy_from(src, arena_);
+            assign_fields(tmp);
+            return;
+        }
+        assign_fields(src);
+        if (!arena_)
+            arena_ = src.arena_;
+        src.arena_ = nullptr;
+        src.reset(Tag::Null);
     }
 
-    static void indent_os(std::ostringstream& os, int count)
-    {
-        for (int i = 0; i < count; i++)
-            os << ' ';
-    }
-    static std::string escape(const std::string& s)
+    static void indent_to(std::string& out, int count) { out.append(std::size_t(count), ' '); }
+
+    static void escape_to(std::string& out, const char* s, std::size_t n)
     {
-        std::string out;
-        out.reserve(s.size() + 4);
-        for (char c : s)
+        static const char* hex = "0123456789abcdef";
+        out += '"';
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < n; ++i)
         {
+            const unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\')
+                continue;
+            out.append(s + run, i - run);
+            run = i + 1;
             switch (c)
             {
-                case '"':
-                    out += "\\\"";
-                    break;
-                case '\\':
-                    out += "\\\\";
-                    break;
-                case '\n':
-                    out += "\\n";
-                    break;
-                case '\r':
-                    out += "\\r";
-                    break;
-                case '\t':
-                    out += "\\t";
-                    break;
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
                 default:
-                    out += c;
+                    out += "\\u00";
+                    out += hex[c >> 4];
+                    out += hex[c & 15];
                     break;
             }
         }
-        return out;
+        out.append(s + run, n - run);
+        out += '"';
     }
-    static void serialize(std::ostringstream& os, const json& j, int indent, int level)
+
+    // Upper-bound-ish size of the serialization, to reserve once.
+    std::size_t estimate(int indent, int level) const;
+
+    void serialize(std::string& out, int indent, int level) const;
+};
+
+struct json::member
+{
+    const char* key;
+    std::size_t keyLen;
+    json value;
+};
+
+inline json& json::operator[](std::string_view key)
+{
+    ensure_object();
+    for (std::size_t i = 0; i < n_; ++i)
+        if (std::string_view(o_[i].key, o_[i].keyLen) == key)
+            return o_[i].value;
+    reserve_slots(n_ + 1);
+    member* m = new (&o_[n_]) member;
+    m->key = arena_->copy_string(key);
+    m->keyLen = key.size();
+    m->value.arena_ = arena_;
+    ++n_;
+    return m->value;
+}
+
+inline std::string_view json::key_at(std::size_t i) const
+{
+    return std::string_view(o_[i].key, o_[i].keyLen);
+}
+
+inline const json& json::value_at(std::size_t i) const
+{
+    return o_[i].value;
+}
+
+inline const json* json::find(std::string_view key) const
+{
+    if (!is_object())
+        return nullptr;
+    for (std::size_t i = 0; i < n_; ++i)
+        if (std::string_view(o_[i].key, o_[i].keyLen) == key)
+            return &o_[i].value;
+    return nullptr;
+}
+
+inline void json::reserve_slots(std::size_t want)
+{
+    if (want <= cap_)
+        return;
+    std::size_t cap = cap_ ? cap_ * 2 : 4;
+    if (cap < want)
+        cap = want;
+    const std::size_t width = tag_ == Tag::Object ? sizeof(member) : sizeof(json);
+    void* p = arena_->allocate(cap * width, alignof(member));
+    if (n_)
+        std::memcpy(p, tag_ == Tag::Object ? static_cast<void*>(o_) : static_cast<void*>(a_), n_ * width);
+    if (tag_ == Tag::Object)
+        o_ = static_cast<member*>(p);
+    else
+        a_ = static_cast<json*>(p);
+    cap_ = cap;
+}
+
+inline void json::copy_from(const json& src, json_arena* into)
+{
+    tag_ = src.tag_;
+    n_ = cap_ = 0;
+    u_ = src.u_;
+    if (tag_ != Tag::String && tag_ != Tag::Object && tag_ != Tag::Array)
+        return;
+    if (!into)
+        into = arena();
+    arena_ = into;
+    if (tag_ == Tag::String)
     {
-        if (std::holds_alternative<std::nullptr_t>(j.data_))
+        s_ = into->copy_string(std::string_view(src.s_, src.n_));
+        n_ = src.n_;
+        return;
+    }
+    if (!src.n_)
+        return;
+    reserve_slots(src.n_);
+    for (std::size_t i = 0; i < src.n_; ++i)
+    {
+        if (tag_ == Tag::Object)
         {
-            os << "null";
-            return;
+            member* m = new (&o_[i]) member;
+            m->key = into->copy_string(std::string_view(src.o_[i].key, src.o_[i].keyLen));
+            m->keyLen = src.o_[i].keyLen;
+            m->value.arena_ = into;
+            m->value.copy_from(src.o_[i].value, into);
         }
-        if (std::holds_alternative<bool>(j.data_))
+        else
         {
-            os << (std::get<bool>(j.data_) ? "true" : "false");
-            return;
+            json* e = new (&a_[i]) json;
+            e->arena_ = into;
+            e->copy_from(src.a_[i], into);
         }
-        if (std::holds_alternative<double>(j.data_))
-        {
-            os << (uint64_t)std::get<double>(j.data_);
-            return;
-        }
-        if (std::holds_alternative<std::string>(j.data_))
+        n_ = i + 1;
+    }
+}
+
+inline std::size_t json::estimate(int indent, int level) const
+{
+    switch (tag_)
+    {
+        case Tag::String: return n_ + 2 + n_ / 8;
+        case Tag::Object:
+        case Tag::Array:
         {
-            os << '"' << escape(std::get<std::string>(j.data_)) << '"';
-            return;
+            const std::size_t pad = indent >= 0 ? std::size_t(indent) * std::size_t(level + 1) + 1 : 0;
+            std::size_t total = 2 + pad;
+            for (std::size_t i = 0; i < n_; ++i)
+                total += pad + 2 + (tag_ == Tag::Object ? o_[i].keyLen + 4 + o_[i].value.estimate(indent, level + 1)
+                                                        : a_[i].estimate(indent, level + 1));
+            return total;
         }
-        if (std::holds_alternative<object_t>(j.data_))
+        default: return 24;
+    }
+}
+
+inline void json::serialize(std::string& out, int indent, int level) const
+{
+    char num[32];
+    switch (tag_)
+    {
+        case Tag::Null: out += "null"; return;
+        case Tag::Bool: out += b_ ? "true" : "false"; return;
+        case Tag::Int: out.append(num, std::to_chars(num, num + sizeof(num), i_).ptr); return;
+        case Tag::Uint: out.append(num, std::to_chars(num, num + sizeof(num), u_).ptr); return;
+        case Tag::Double: out.append(num, std::to_chars(num, num + sizeof(num), d_).ptr); return;
+        case Tag::String: escape_to(out, s_, n_); return;
+        case Tag::Object:
+        case Tag::Array:
         {
-            const auto& obj = std::get<object_t>(j.data_);
-            os << '{';
-            bool first = true;
-            for (auto& kv : obj)
+            const bool obj = tag_ == Tag::Object;
+            out += obj ? '{' : '[';
+            for (std::size_t i = 0; i < n_; ++i)
             {
-                if (!first)
-                    os << ',';
+                if (i)
+                    out += ',';
                 if (indent >= 0)
                 {
-                    os << '\n';
-                    indent_os(os, (level + 1) * indent);
+                    out += '\n';
+                    indent_to(out, (level + 1) * indent);
                 }
-                os << '"' << escape(kv.first) << '"' << ':';
-                if (indent >= 0)
-                    os << ' ';
-                serialize(os, kv.second, indent, level + 1);
-                first = false;
+                if (obj)
+                {
+                    escape_to(out, o_[i].key, o_[i].keyLen);
+                    out += ':';
+                    if (indent >= 0)
+                        out += ' ';
+                    o_[i].value.serialize(out, indent, level + 1);
+                }
+                else
+                    a_[i].serialize(out, indent, level + 1);
             }
-            if (!obj.empty() && indent >= 0)
+            if (n_ && indent >= 0)
             {
-                os << '\n';
-                indent_os(os, level * indent);
+                out += '\n';
+                indent_to(out, level * indent);
             }
-            os << '}';
+            out += obj ? '}' : ']';
             return;
         }
-        if (std::holds_alternative<array_t>(j.data_))
+    }
+}
+
+class json::parser
+{
+  public:
+    explicit parser(std::string_view text) : p_(text.data()), end_(text.data() + text.size()) {}
+
+    bool document(json& out)
+    {
+        if (!value(out, 0))
+            return false;
+        ws();
+        return p_ == end_;
+    }
+
+  private:
+    void ws()
+    {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t'))
+            ++p_;
+    }
+    bool eat(char c)
+    {
+        ws();
+        if (p_ < end_ && *p_ == c)
+        {
+            ++p_;
+            return true;
+        }
+        return false;
+    }
+    bool literal(const char* word, std::size_t n)
+    {
+        if (std::size_t(end_ - p_) < n || std::memcmp(p_, word, n) != 0)
+            return false;
+        p_ += n;
+        return true;
+    }
+    bool hex4(unsigned& out)
+    {
+        if (end_ - p_ < 4)
+            return false;
+        out = 0;
+        for (int i = 0; i < 4; ++i, ++p_)
         {
-            const auto& arr = std::get<array_t>(j.data_);
-            os << '[';
-            bool first = true;
-            for (auto& el : arr)
+            const char c = *p_;
+            const int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0)
+                return false;
+            out = out << 4 | unsigned(d);
+        }
+        return true;
+    }
+    bool string(std::string& out)
+    {
+        if (!eat('"'))
+            return false;
+        out.clear();
+        while (p_ < end_ && *p_ != '"')
+        {
+            if (static_cast<unsigned char>(*p_) < 0x20)
+                return false;
+            if (*p_ != '\\')
             {
-                if (!first)
-                    os << ',';
-                if (indent >= 0)
+                out += *p_++;
+                continue;
+            }
+            if (++p_ == end_)
+                return false;
+            const char c = *p_++;
+            unsigned cp;
+            switch (c)
+            {
+                case '"': case '\\': case '/': out += c; continue;
+                case 'b': out += '\b'; continue;
+                case 'f': out += '\f'; continue;
+                case 'n': out += '\n'; continue;
+                case 'r': out += '\r'; continue;
+                case 't': out += '\t'; continue;
+                case 'u': break;
+                default: return false;
+            }
+            if (!hex4(cp))
+                return false;
+            if (cp >= 0xD800 && cp < 0xDC00)
+            {
+                unsigned lo;
+                if (!literal("\\u", 2) || !hex4(lo) || lo < 0xDC00 || lo > 0xDFFF)
+                    return false;
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            }
+            if (cp < 0x80)
+                out += char(cp);
+            else if (cp < 0x800)
+                out += {char(0xC0 | cp >> 6), char(0x80 | (cp & 0x3F))};
+            else if (cp < 0x10000)
+                out += {char(0xE0 | cp >> 12), char(0x80 | (cp >> 6 & 0x3F)), char(0x80 | (cp & 0x3F))};
+            else
+                out += {char(0xF0 | cp >> 18), char(0x80 | (cp >> 12 & 0x3F)), char(0x80 | (cp >> 6 & 0x3F)),
+                        char(0x80 | (cp & 0x3F))};
+        }
+        if (p_ == end_)
+            return false;
+        ++p_;
+        return true;
+    }
+    bool number(json& out)
+    {
+        const char* start = p_;
+        bool integral = true;
+        while (p_ < end_ && (std::strchr("+-.eE", *p_) || (*p_ >= '0' && *p_ <= '9')))
+            integral = integral && (*p_ == '-' || (*p_ >= '0' && *p_ <= '9')), ++p_;
+        if (p_ == start)
+            return false;
+        if (integral)
+        {
+            if (*start == '-')
+            {
+                std::int64_t v{};
+                if (std::from_chars(start, p_, v).ptr == p_)
+                    return out = v, true;
+            }
+            else
+            {
+                std::uint64_t v{};
+                if (std::from_chars(start, p_, v).ptr == p_)
+                    return out = v, true;
+            }
+        }
+        double d;
+        if (std::from_chars(start, p_, d).ptr != p_)
+            return false;
+        out = d;
+        return true;
+    }
+    bool value(json& out, int depth)
+    {
+        ws();
+        if (p_ == end_ || depth > 512)
+            return false;
+        switch (*p_)
+        {
+            case '{':
+            {
+                ++p_;
+                out.ensure_object();
+                if (eat('}'))
+                    return true;
+                do
                 {
-                    os << '\n';
-                    indent_os(os, (level + 1) * indent);
-                }
-                serialize(os, el, indent, level + 1);
-                first = false;
+                    if (!string(key_) || !eat(':') || !value(out[key_], depth + 1))
+                        return false;
+                } while (eat(','));
+                return eat('}');
             }
-            if (!arr.empty() && indent >= 0)
+            case '[':
             {
-                os << '\n';
-                indent_os(os, level * indent);
+                ++p_;
+                out.ensure_array();
+                if (eat(']'))
+                    return true;
+                do
+                {
+                    out.reserve_slots(out.n_ + 1);
+                    json* e = new (&out.a_[out.n_]) json;
+                    e->arena_ = out.arena_;
+                    e->reset(Tag::Null);
+                    ++out.n_;
+                    if (!value(*e, depth + 1))
+                        return false;
+                } while (eat(','));
+                return eat(']');
             }
-            os << ']';
-            return;
+            case '"':
+                if (!string(str_))
+                    return false;
+                out = str_;
+                return true;
+            case 't': return literal("true", 4) && (out = true, true);
+            case 'f': return literal("false", 5) && (out = false, true);
+            case 'n': return literal("null", 4) && (out = nullptr, true);
+            default: return number(out);
         }
     }
+
+    const char* p_;
+    const char* end_;
+    std::string key_;
+    std::string str_;
 };
 
+inline json json::parse(std::string_view text, bool* ok)
+{
+    json out;
+    const bool good = parser(text).document(out);
+    if (ok)
+        *ok = good;
+    if (!good)
+        out = nullptr;
+    return out;
+}
+
 }  // namespace nlohmann
 
 using nlohmann::json;